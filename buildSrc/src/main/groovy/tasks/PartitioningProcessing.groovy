@@ -11,6 +11,7 @@ class PartitioningProcessing {
 	private String exampleName
 	private String partitioningMethod
 	private DefaultTask prepareTask, createIRTask, prepareInliningTask, applyInliningTask, speedUpAnalysisTask, createGraphsTask,
+	instrumentForProfilingTask,
 	prepareCodeGenerationTask, copyMehariSourcesTask, partitioningTask, compilePartitioningResultTask, testPartitioningResultTask
 	private ReconosHardwareTest hardwareTasks
 
@@ -63,7 +64,9 @@ class PartitioningProcessing {
 			commandLine "bash", "-c", "${project.LLVM_BIN}/opt " +
 			"-load ${project.LLVM_PASSES_LIB} " + 
 			"-add-attr-always-inline " +
-			"-inline-functions \"evalParameterCouplings\" " +
+			"-inline-functions \"${project.INLINE_FUNCTIONS}\" " +
+			"-inline-reachable-from \"${project.PARTITIONING_TARGET_FUNCTIONS}\" " +
+			"-inline-size-budget ${project.INLINE_SIZE_BUDGET} " +
 			"-S $sourcefile > $targetfile"
 		}
 		
@@ -73,7 +76,16 @@ class PartitioningProcessing {
 			def sourcefile = project.file("${project.OUTPUT_DIR}/$exampleName-prepare-inline"+".ll")
 			def targetfile = project.file("${project.OUTPUT_DIR}/$exampleName-inlined"+".ll")
 
-			commandLine "bash", "-c", "${project.LLVM_BIN}/opt -always-inline -S $sourcefile > $targetfile"
+			// the speedup analysis before and after the rebalancing shows its effect on the critical path
+			commandLine "bash", "-c", "${project.LLVM_BIN}/opt -always-inline " +
+			(project.HOIST_PARAMETERS || project.REBALANCE_FP_CHAINS ? "-load ${project.LLVM_PASSES_LIB} " : "") +
+			(project.HOIST_PARAMETERS ?
+				"-hoist-parameters -hoisting-functions \"${project.PARTITIONING_TARGET_FUNCTIONS}\" " : "") +
+			(project.REBALANCE_FP_CHAINS ?
+				"-speedup -tree-height-reduction -fp-reassociate -speedup " +
+				"-speedup-functions \"${project.PARTITIONING_TARGET_FUNCTIONS}\" " +
+				"-tree-height-functions \"${project.PARTITIONING_TARGET_FUNCTIONS}\" " : "") +
+			"-S $sourcefile > $targetfile"
 		}
 		
 		speedUpAnalysisTask = project.task(getTaskName("analyze", "speedup"), type: Exec) {
@@ -111,6 +123,22 @@ class PartitioningProcessing {
 			"-S $targetfile > /dev/null"
 		}
 
+		instrumentForProfilingTask = project.task(getTaskName("instrument", "forProfiling"), type: Exec) {
+			dependsOn project.installLLVMPasses, applyInliningTask
+
+			def sourcefile = project.file("${project.OUTPUT_DIR}/$exampleName-inlined"+".ll")
+			def targetfile = project.file("${project.OUTPUT_DIR}/$exampleName-profiling"+".ll")
+
+			inputs.file sourcefile
+			outputs.file targetfile
+
+			commandLine "bash", "-c", "${project.LLVM_BIN}/opt " +
+			"-load ${project.LLVM_PASSES_LIB} " +
+			"-profiling-instrumentation " +
+			"-profiling-functions \"${project.PARTITIONING_TARGET_FUNCTIONS}\" " +
+			"-S $sourcefile > $targetfile"
+		}
+
 		prepareCodeGenerationTask = project.task(getTaskName("prepare", "codeGeneration"), type: Exec) {
 			dependsOn prepareTask
 
@@ -151,6 +179,20 @@ class PartitioningProcessing {
 				"-partitioning-devices \"${project.PARTITIONING_DEVICES}\" " +
 				"-partitioning-output-dir \"${project.PARTITIONING_RESULTS_DIR}/$exampleName\" " +
 				"-partitioning-graph-output-dir \"${project.OUTPUT_GRAPH_DIR}\" " +
+				(project.PARTITIONING_PROFILE ? "-partitioning-profile \"${project.PARTITIONING_PROFILE}\" " : "") +
+				(project.PARTITIONING_EXPORT_GRAPH ? "-partitioning-export-graph \"${project.OUTPUT_GRAPH_DIR}\" " : "") +
+				(project.PARTITIONING_ASSIGNMENT ? "-partitioning-assignment \"${project.PARTITIONING_ASSIGNMENT}\" " : "") +
+				"-cpu-transport ${project.CPU_TRANSPORT} " +
+				(project.CPU_TRANSPORT_COSTS ? "-cpu-transport-costs \"${project.CPU_TRANSPORT_COSTS}\" " : "") +
+				(project.CPU_SLP_PACKING ? "-cpu-slp-packing " : "") +
+				(project.FPGA_SPLIT_PHASE ? "-fpga-split-phase " : "") +
+				(project.FPGA_CACHE_INPUTS ? "-fpga-cache-inputs " : "") +
+				(project.FPGA_ATOMIC_MESSAGES ? "-fpga-atomic-messages " : "") +
+				(project.FPGA_OPERATOR_LIMITS ? "-fpga-operator-limits \"${project.FPGA_OPERATOR_LIMITS}\" " : "") +
+				(project.FPGA_STATIC_SCHEDULE ? "-fpga-static-schedule " : "") +
+				(project.FPGA_EMULATION ? "-fpga-emulation " : "") +
+				(project.PARTITIONING_WAIT_COUNTERS ? "-partitioning-wait-counters " : "") +
+				(project.PARTITIONING_IR_OUTPUT ? "-partitioning-ir-output ${project.PARTITIONING_IR_OUTPUT} " : "") +
 				"-S $targetfile > /dev/null"
 			}
 		}
@@ -303,6 +345,16 @@ class PartitioningProcessing {
 		return createGraphsTask
 	}
 
+	public def instrumentForProfiling(closure=null) {
+		if (closure)
+			instrumentForProfilingTask.configure(closure)
+		return instrumentForProfilingTask
+	}
+
+	public def getInstrumentForProfiling() {
+		return instrumentForProfilingTask
+	}
+
 	public def prepareCodeGeneration(closure=null) {
 		if (closure)
 			prepareCodeGenerationTask.configure(closure)
@@ -0,0 +1,67 @@
+#ifndef EXECUTION_PROFILE_H
+#define EXECUTION_PROFILE_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Instructions.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+using namespace llvm;
+
+
+// Execution profile written by an instrumented run (see ProfilingInstrumentation
+// and runtime/mehari_profile.c). The instructions are identified by their position
+// in the uninstrumented function (order of inst_iterator).
+class ExecutionProfile {
+
+public:
+
+	ExecutionProfile();
+	~ExecutionProfile();
+
+	struct InstructionProfile {
+		unsigned long long executionCount;
+		unsigned long long cycleCount;
+		InstructionProfile() : executionCount(0), cycleCount(0) {};
+	};
+
+	struct BranchProfile {
+		unsigned long long takenCount;		// branch to successor 0
+		unsigned long long notTakenCount;	// branch to successor 1
+		BranchProfile() : takenCount(0), notTakenCount(0) {};
+	};
+
+	struct FunctionProfile {
+		unsigned long long invocationCount;
+		unsigned int instructionCount;
+		std::map<unsigned int, InstructionProfile> instructions;
+		std::map<unsigned int, BranchProfile> branches;
+		FunctionProfile() : invocationCount(0), instructionCount(0) {};
+	};
+
+	bool load(const std::string &filename);
+
+	bool hasFunction(const std::string &name);
+	FunctionProfile *getFunctionProfile(const std::string &name);
+
+	// average measured cycles per execution of each instruction (multiplied by scale)
+	// returns false if the profile does not match the function
+	bool getMeasuredCycles(Function &F, std::map<Instruction*, unsigned int> &cycles, float scale = 1.0);
+
+	// measured probability to branch to successor 0 for each executed conditional branch
+	bool getBranchProbabilities(Function &F, std::map<BranchInst*, float> &probabilities);
+
+	// instructions of a function in the order that is used to number them in the profile
+	static std::vector<Instruction*> getProfiledInstructions(Function &F);
+
+private:
+	std::map<std::string, FunctionProfile> functions;
+
+	FunctionProfile *getMatchingProfile(Function &F, std::vector<Instruction*> &instructions);
+};
+
+#endif /*EXECUTION_PROFILE_H*/
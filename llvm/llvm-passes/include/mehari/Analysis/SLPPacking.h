@@ -0,0 +1,47 @@
+#ifndef SLP_PACKING_H
+#define SLP_PACKING_H
+
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Instructions.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+
+using namespace llvm;
+
+
+// Superword level parallelism in straight-line code: finds pairs of isomorphic
+// (same opcode and type) floating point operations that are independent of each
+// other, so they can be executed as one operation on two lanes. The pairs are
+// found in a list of instructions in execution order (e.g. the instructions of
+// a partition). Both operations of a pair are executed at the position of the
+// second one, so the first one must not be used before. Pairs whose operands are
+// the lanes of another pair are preferred, so their operands stay in the vector.
+class SLPPacking {
+
+public:
+	typedef std::pair<Instruction*, Instruction*> Pack;
+
+	SLPPacking(const std::vector<Instruction*> &instructions);
+	~SLPPacking();
+
+	const std::vector<Pack> &getPacks(void);
+
+	// the pack that contains an instruction (NULL if it is executed on its own)
+	const Pack *getPack(Instruction *instr);
+
+	// the instruction is executed with the next one of its pack
+	bool isFirstOfPack(Instruction *instr);
+
+	static bool isPackable(Instruction *instr);
+
+private:
+	std::vector<Pack> packs;
+	std::map<Instruction*, unsigned int> packOfInstruction;
+
+	unsigned int getAffinity(Instruction *first, Instruction *second);
+};
+
+#endif /*SLP_PACKING_H*/
@@ -11,7 +11,9 @@
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <map>
 #include <set>
+#include <vector>
 
 class VHDLBackend : public CodeGeneratorBackend, private PhiNodeSink {
   std::string name;
@@ -27,17 +29,84 @@ class VHDLBackend : public CodeGeneratorBackend, private PhiNodeSink {
   boost::scoped_ptr<class ValueStorageFactory> vs_factory;
   boost::scoped_ptr<class ReadySignals> ready_signals;
   std::ostringstream interface_ccode;
+  size_t firstResultPosition;   // position of the first result in interface_ccode
   std::set<std::string> read_values;
+  std::set<std::string> invariant_inputs;
+  std::vector<std::pair<std::string, std::string> > cached_inputs;  // type and C code
+  std::vector<std::pair<std::string, std::string> > mbox_inputs;    // in the order of the hardware
+  std::vector<std::pair<std::string, std::string> > mbox_outputs;
+  std::string return_type;      // type of the returned value in mbox_outputs, if there is one
 
   bool generateForTest;
+
+  struct SharedOperation {
+    ChannelP input1, input2, output;
+  };
+  struct SharedCore {
+    std::string name;
+    OperatorInfo op_info;
+    unsigned int width;
+    std::vector<SharedOperation> operations;
+    unsigned int finish_time;  // estimated cycle when the last operation is done
+  };
+  std::map<std::string, unsigned int> operator_limits;
+  std::map<std::string, std::vector<SharedCore> > shared_cores;  // by operator name and width
+  std::map<std::string, unsigned int> core_counts;               // instantiated cores by operator name
+  std::map<std::string, unsigned int> operation_counts;
+  // estimated cycle when a value is available with and without sharing
+  std::map<std::string, unsigned int> finish_times, unshared_finish_times;
+
+  bool static_schedule, static_schedule_failed;
+  std::string schedule_name;
+  std::map<std::string, unsigned int> ready_times;  // cycle of the schedule when a data signal is valid
+  std::map<std::string, ChannelP> captured_inputs;  // by data signal of the input port
+  std::vector<ChannelP> scheduled_outputs;
 public:
   VHDLBackend(const std::string& name);
 
   MyOperator* getOperator();
   ReconOSOperator* getReconOSOperator();
   std::string getInterfaceCode();
+  // the interface code split at the first result of the hardware:
+  // the start code only sends inputs, so the CPU can continue after it
+  std::string getStartCode();
+  std::string getCollectCode();
   VHDLBackend* setTestMode();
 
+  // Instantiate at most count cores of an operator (e.g. "float_add"). The operations
+  // share them: each core executes its operations one after the other in the order
+  // of the code and multiplexes their inputs, so we trade latency for area.
+  void setOperatorLimit(const std::string& name, unsigned int count);
+  // estimated latency and FPGA resources of the generated hardware
+  std::string getResourceReport();
+
+  // Start the operations at fixed clock cycles of a counter instead of connecting them
+  // with handshakes. The cycles use the maximum latencies of the cores and the results
+  // stay in registers until the iteration is done. Operator limits are ignored.
+  // The values of other partitions are inputs of the schedule, so none of them may
+  // depend on a result of the same iteration (see Partitioning::hasRoundTrip).
+  // Calls of functions cannot be scheduled this way, so isStaticallyScheduled() returns
+  // false, if the generated code had to use handshakes.
+  void setStaticSchedule(bool enabled);
+  bool isStaticallyScheduled();
+
+  // The backend can generate hardware for the instruction. The partitioning must not
+  // put other instructions on the FPGA.
+  static bool isSupported(Instruction* instr);
+
+  // Inputs (C code of the value, e.g. "Vp[3]") that rarely change. The hardware keeps
+  // them in registers and the interface code only sends them, if they have changed.
+  // In that case, the interface code sends the start word, which is the version of
+  // the cached inputs.
+  void setInvariantInputs(const std::set<std::string>& inputs);
+  bool hasCachedInputs();
+
+  // C code that does the same mbox transfers as the hardware thread for the ReconOS
+  // emulation: it reads the inputs from mbox_start into their variables, calls the
+  // calculation (a C expression) and sends the results, the return value and the ack
+  // to mbox_stop.
+  std::string getEmulationCode(const std::string& calculation);
+
   void init(SimpleCCodeGenerator* generator, std::ostream& stream);
 
   void generateStore(Value *op1, Value *op2);
@@ -46,6 +115,7 @@ public:
   void generateVoidCall(std::string funcName, std::vector<Value*> args);
   void generateComparison(std::string tmpVar, Value *op1, Value *op2, FCmpInst::Predicate comparePredicate);
   void generateIntegerExtension(std::string tmpVar, Value *op);
+  void generateCast(std::string tmpVar, Value *op, Type *type, unsigned opcode);
   void generateSelect(std::string tmpVar, Value *condition, Value *targetTrue, Value *targetFalse);
   void generatePhiNodeAssignment(std::string tmpVar, Value *op);
   void generateUnconditionalBranch(Instruction *target);
@@ -73,13 +143,34 @@ private:
 
   ValueStorageP remember(ValueStorageP value);
 
+  bool shareOperator(const std::string& tmpVar, Value *op1, Value *op2, const OperatorInfo& op_info, unsigned int width);
+  void generateSharedCore(SharedCore& core);
+  void addOperation(const std::string& tmpVar, const std::string& operator_name,
+    const std::vector<Value*>& inputs, SharedCore* core = NULL);
+
+  void generateBitwiseOperator(std::string tmpVar, Value *op1, Value *op2, unsigned opcode);
+  void generateUnaryOperator(std::string tmpVar, Value *value, const OperatorInfo& op_info);
+
+  void connectOperator(const std::string& tmpVar, const OperatorInfo& op_info,
+    ChannelP input1, ChannelP value1, ChannelP input2, ChannelP value2, ChannelP output, ChannelP result);
+  void connectStaticInput(const std::string& tmpVar, const OperatorInfo& op_info,
+    ChannelP input, ChannelP value, const std::string& start);
+  ChannelP captureInput(ChannelP port);
+  unsigned int getReadyTime(ChannelP channel);
+  void setReadyTime(ChannelP channel, unsigned int time);
+  std::string scheduleCondition(const std::string& comparison, unsigned int time);
+  unsigned int getStaticLatency();
+  void generateSchedule();
+
   ChannelP read(ValueStorageP value);
 
   unsigned int dataDependencyCount;
 
   void mboxGet(unsigned int mbox, ChannelP channel_of_op, ValueStorageP value);
   void mboxPut(unsigned int mbox, ChannelP channel_of_op, ValueStorageP value);
-  void mboxGetWithoutInterface(unsigned int mbox, ChannelP channel_of_op);
+  void markFirstResult();
+  std::string getCachedInputsCode();
+  void mboxGetWithoutInterface(unsigned int mbox, ChannelP channel_of_op, bool cached = false);
   void mboxPutWithoutInterface(unsigned int mbox, ChannelP channel_of_op);
 };
 
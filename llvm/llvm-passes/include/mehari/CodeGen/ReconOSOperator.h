@@ -44,10 +44,25 @@ public:
     const std::string& addr, const std::string& len, unsigned int local_ram_addr,
     unsigned int state_pos = UINT_MAX);
 
-  void readMbox(const std::string& state_name, unsigned int mbox, const ChannelP channel);
+  // Each word is read (or written) in a state of its own in the order of the
+  // calls, so all words of one invocation form a single message. If several
+  // threads call the hardware thread, the software has to send and receive
+  // them without words of other threads in between (-fpga-atomic-messages).
+  void readMbox(const std::string& state_name, unsigned int mbox, const ChannelP channel,
+    unsigned int state_pos = UINT_MAX);
+
+  // Read a value that is kept in a register while the version word
+  // in the start mbox doesn't change. The states are put directly after
+  // INIT, so INIT can skip all of them at once. Call addInitialState
+  // after all cached inputs have been added.
+  void readCachedMbox(const std::string& state_name, unsigned int mbox, const ChannelP channel);
 
   void writeMbox(const std::string& state_name, unsigned int mbox, const ChannelP channel);
 
+  // Read a value before the first value that is written to a mbox. A statically
+  // scheduled calculation needs all of its inputs before it sends any result.
+  void readMboxBeforeWrites(const std::string& state_name, unsigned int mbox, const ChannelP channel);
+
   void writeMemory(const std::string& state_name,
     const std::string& addr, const std::string& len, unsigned int local_ram_addr,
     const std::string& valid_condition, const std::string& set_ready);
@@ -101,6 +116,10 @@ protected:
   std::vector<State*> sequential_states;
   std::map<std::string, State*> states_by_name;
 
+  unsigned int cachedInputStateCount;
+  std::vector<std::string> cachedInputValidSignals;
+  unsigned int firstWriteState;   // UINT_MAX, if nothing has been written
+
   State& addSequentialState(const std::string& state_name, unsigned int pos = UINT_MAX);
   State& addOutOfBandState(const std::string& state_name);
   State& internalAddState(const std::string& state_name, unsigned int pos = UINT_MAX);
@@ -147,7 +166,8 @@ class ReconOSOperator : public BasicReconOSOperator {
 public:
   ReconOSOperator();
 
-  void readMbox(unsigned int mbox, const ChannelP channel);
+  void readMbox(unsigned int mbox, const ChannelP channel, bool before_writes = false);
+  void readCachedMbox(unsigned int mbox, const ChannelP channel);
   void writeMbox(unsigned int mbox, const ChannelP channel);
 
   void readMemory(ValueStorageP vs);
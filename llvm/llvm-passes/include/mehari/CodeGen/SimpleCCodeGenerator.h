@@ -23,6 +23,8 @@ public:
   ~SimpleCCodeGenerator();
 
   void setIgnoreDataDependencies(bool ignoreThem);
+  // generate pairs of independent floating point operations together (see SLPPacking)
+  void setSLPPacking(bool usePacking);
 
   typedef struct {
     std::string name;
@@ -44,6 +46,7 @@ public:
 private:
   std::map<std::string, std::string> dataDependencies;
   bool ignoreDataDependencies;
+  bool useSLPPacking;
 
   CodeGeneratorBackend* backend;
 
@@ -60,10 +63,13 @@ public:
 
   virtual void generateStore(Value *op1, Value *op2) =0;
   virtual void generateBinaryOperator(std::string tmpVar, Value *op1, Value *op2, unsigned opcode) =0;
+  virtual void generatePackedBinaryOperator(Instruction *first, Instruction *second);
   virtual void generateCall(std::string funcName, std::string tmpVar, std::vector<Value*> args) =0;
   virtual void generateVoidCall(std::string funcName, std::vector<Value*> args) =0;
   virtual void generateComparison(std::string tmpVar, Value *op1, Value *op2, FCmpInst::Predicate comparePredicate) =0;
   virtual void generateIntegerExtension(std::string tmpVar, Value *op) =0;
+  // all casts except zext, type is the type of the result
+  virtual void generateCast(std::string tmpVar, Value *op, Type *type, unsigned opcode) =0;
   virtual void generateSelect(std::string tmpVar, Value *condition, Value *targetTrue, Value *targetFalse) =0;
   virtual void generatePhiNodeAssignment(std::string tmpVar, Value *op) =0;
   virtual void generateUnconditionalBranch(Instruction *target) =0;
@@ -93,19 +99,30 @@ class CCodeBackend : public CodeGeneratorBackend {
   std::ostream* output_stream;
 
   SimpleCCodeGenerator* generator;
+
+  // partition number for the wait counters of the runtime (see runtime/mehari_waits.h), -1 if disabled
+  int waitCounterPartition;
+  unsigned int waitCounterFirstPartition;
+  bool hasWaitCounters;
 public:
   CCodeBackend();
   ~CCodeBackend();
 
+  // measure the cycles of the generated code and of each blocking communication call
+  // (partitions are numbered across all functions, firstPartition is partition 0 of this function)
+  void setWaitCounters(unsigned int partition, unsigned int firstPartition);
+
   void init(SimpleCCodeGenerator* generator, std::ostream& stream);
 
   std::string generateBranchLabel(Value *target);
   void generateStore(Value *op1, Value *op2);
   void generateBinaryOperator(std::string tmpVar, Value *op1, Value *op2, unsigned opcode);
+  void generatePackedBinaryOperator(Instruction *first, Instruction *second);
   void generateCall(std::string funcName, std::string tmpVar, std::vector<Value*> args);
   void generateVoidCall(std::string funcName, std::vector<Value*> args);
   void generateComparison(std::string tmpVar, Value *op1, Value *op2, FCmpInst::Predicate comparePredicate);
   void generateIntegerExtension(std::string tmpVar, Value *op);
+  void generateCast(std::string tmpVar, Value *op, Type *type, unsigned opcode);
   void generateSelect(std::string tmpVar, Value *condition, Value *targetTrue, Value *targetFalse);
   void generatePhiNodeAssignment(std::string tmpVar, Value *op);
   void generateUnconditionalBranch(std::string label);
@@ -127,6 +144,7 @@ public:
 
 private:
   std::string getOperandString(Value* addr);
+  std::string getPackedOperandString(Value* lane0, Value* lane1);
 
   std::string getDatatype(Value *addr);
   std::string getDatatype(Type *type);
@@ -21,9 +21,12 @@ private:
 };
 
 
+// a data dependency is sent in a message that costs DataDependency once 
+// and DataWord for each 32 bit word of the values in the message
 enum CommunicationType {
 	OrderDependency,
-	DataDependency
+	DataDependency,
+	DataWord
 };
 
 
@@ -57,6 +60,9 @@ public:
 
 	void addInstructionInfo(std::string opcodeName, unsigned int cycles);
 	InstructionInformation *getInstructionInfo(llvm::Instruction *instr);
+	// costs of two independent operations like instr that are executed together (see SLPPacking), NULL if unknown
+	InstructionInformation *getPackedInstructionInfo(llvm::Instruction *instr);
+	InstructionInformation *getInstructionInfo(std::string opcodeName);
 
 	void addCommunicationInfo(std::string target, CommunicationType type, unsigned int cost);
 	CommunicationInformation *getCommunicationInfo(std::string target);
@@ -68,7 +74,6 @@ private:
 	std::map<std::string, CommunicationInformation*> *comInfoMap;
 
 	std::string getOpcodeName(llvm::Instruction *instr);
-	InstructionInformation *getInstructionInfo(std::string opcodeName);
 };
 
 
@@ -80,9 +85,18 @@ public:
 	DeviceInformation *getDeviceInfo(std::string deviceName);
 	unsigned int getDeviceIndependentCommunicationCost(CommunicationType type);
 
+	// data dependencies between processors use the ring buffers of mehari_channel instead of mailboxes
+	static bool useRingBuffersForCPUs(void);
+	// a processor partition starts the FPGA and collects its results, there is no thread that waits for it
+	static bool useSplitPhaseFPGAInvocation(void);
+	// pairs of independent floating point operations in processor partitions are executed together
+	static bool useSLPPackingForCPUs(void);
+
 private:
 	std::map<std::string, DeviceInformation*> *devices;
 	std::map<CommunicationType, unsigned int> deviceIndependentComCosts;
+
+	void readCommunicationCosts(std::string filename, CommunicationInformation *comInfo);
 };
 
 #endif /*HARDWARE_INFORMATION_H_*/
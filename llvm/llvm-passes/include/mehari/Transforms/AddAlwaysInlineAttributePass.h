@@ -2,9 +2,20 @@
 #define ADD_ALWAYS_INLINE_ATTRIBUTE_PASS_H
 
 #include "llvm/Pass.h"
+#include "llvm/IR/Function.h"
+
+#include <string>
+#include <vector>
+#include <map>
 
 using namespace llvm;
 
+// Adds the AlwaysInline attribute to the functions given by -inline-functions.
+// With -inline-reachable-from it also selects the callees of these functions
+// (and their callees) that contain operations the FPGA can compute: a call is an
+// opaque vertex for the partitioning, which is never moved to the FPGA. The callees
+// that expose the most parallelism are selected first, until the instructions added
+// by inlining them (see getAddedInstructions) reach -inline-size-budget.
 class AddAlwaysInlineAttributePass : public ModulePass {
 
 public:
@@ -15,9 +26,32 @@ public:
 
   virtual bool runOnModule(Module &M);
 
+  // override the command line options
+  void setRootFunctions(const std::vector<std::string> &functions);
+  void setSizeBudget(unsigned int budget);
+
 private:
   std::vector<std::string> targetFunctions;
+  std::vector<std::string> rootFunctions;
+  unsigned int sizeBudget;
   void parseTargetFunctions();
+
+  struct CalleeInformation {
+    unsigned int instructions;
+    unsigned int offloadable;
+    double parallelism;
+    unsigned int addedInstructions;
+  };
+  std::map<Function*, CalleeInformation> calleeInfo;
+  std::vector<Function*> candidates;  // callees before their callers
+  std::map<Function*, std::vector<Function*> > candidateCallees;
+  std::map<Function*, bool> selected;
+  unsigned int usedBudget;
+
+  CalleeInformation &getCalleeInformation(Function *callee);
+  void collectCandidates(Function *caller, std::vector<Function*> &callStack);
+  void selectCandidates();
+  void trySelect(Function *callee);
 };
 
 #endif /*ADD_ALWAYS_INLINE_ATTRIBUTE_PASS_H*/
@@ -0,0 +1,44 @@
+#ifndef LIST_SCHEDULER_H
+#define LIST_SCHEDULER_H
+
+#include "mehari/Transforms/PartitioningGraph.h"
+
+#include <string>
+#include <vector>
+
+
+// List scheduler for a partitioned PartitioningGraph (HEFT with a fixed assignment):
+// processor partitions execute their vertices sequentially in the order of the schedule,
+// FPGA partitions start each vertex as soon as its inputs are available.
+// Among the vertices that are ready, the one that can start first is scheduled first,
+// ties are broken by the upward rank (length of the remaining path to the end).
+class ListScheduler {
+public:
+	typedef PartitioningGraph::VertexDescriptor VertexDescriptor;
+
+	struct Schedule {
+		unsigned int length;
+		std::vector<unsigned int> startTimes;						// indexed by vertex descriptor
+		std::vector<std::vector<VertexDescriptor> > partitionOrders;	// execution order for each partition
+		std::vector<bool> isSequential;								// partition executes one vertex at a time
+	};
+
+	Schedule schedule(PartitioningGraph &pGraph, std::vector<std::string> &partitioningDevices);
+
+	// determine pairs of vertices that must keep their original order if they are in the same partition:
+	// accesses to the same memory location, calls with side effects, branches to labels in other vertices
+	// and the return statement
+	static void calcOrderingConstraints(PartitioningGraph &pGraph, PartitioningGraph::VertexPairList &constraints);
+
+private:
+	typedef std::pair<VertexDescriptor, unsigned int> Precedence;	// (vertex, communication cost)
+
+	std::vector<std::vector<Precedence> > predecessors, successors;
+	std::vector<unsigned int> executionTimes;
+	std::vector<unsigned int> upwardRanks;
+
+	void createPrecedences(PartitioningGraph &pGraph, std::vector<std::string> &partitioningDevices);
+	bool calcUpwardRanks(void);
+};
+
+#endif /*LIST_SCHEDULER_H*/
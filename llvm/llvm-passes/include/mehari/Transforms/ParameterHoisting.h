@@ -0,0 +1,51 @@
+#ifndef PARAMETER_HOISTING_H
+#define PARAMETER_HOISTING_H
+
+#include "llvm/Pass.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/GlobalVariable.h"
+
+#include <string>
+#include <vector>
+#include <set>
+
+using namespace llvm;
+
+// Moves the computations that only depend on parameters of the model (elements of
+// global arrays that are never written, e.g. m*l*l or sin of a constant angle) out of
+// the target functions. The results are computed by <function>_on_parameter_change
+// and saved in the global array <function>_parameter_cache. The function must be
+// called once before the first step and each time the parameters have been changed.
+// Both are listed in the named metadata PARAMETER_INIT_METADATA, so the partitioning
+// can write their C code.
+class ParameterHoisting : public ModulePass {
+
+public:
+  static char ID;
+
+  ParameterHoisting();
+  ~ParameterHoisting();
+
+  virtual bool runOnModule(Module &M);
+
+  // override the command line option
+  void setTargetFunctions(const std::vector<std::string> &functions);
+
+private:
+  std::vector<std::string> targetFunctions;
+  std::vector<std::string> reportDevices;
+  void parseTargetFunctions();
+
+  std::set<GlobalVariable*> writtenGlobals;
+  std::set<std::pair<GlobalVariable*, uint64_t> > writtenElements;
+
+  void findWrittenParameters(Module &M);
+  bool isParameterLoad(Instruction *instr);
+  bool isHoistable(Instruction *instr, const std::set<Instruction*> &hoistable);
+
+  bool hoistParameterComputations(Module &M, Function &F);
+};
+
+#define PARAMETER_INIT_METADATA "mehari.parameter_init"
+
+#endif /*PARAMETER_HOISTING_H*/
@@ -3,11 +3,16 @@
 
 #include "llvm/Pass.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
 
 #include "mehari/Transforms/PartitioningGraph.h"
+#include "mehari/Transforms/ListScheduler.h"
 #include "mehari/CodeGen/SimpleCCodeGenerator.h"
 
 #include <string>
+#include <set>
 
 using namespace llvm;
 
@@ -24,6 +29,57 @@ public:
 
 	enum Architectures {CPU, FPGA};
 
+  // Clones the instructions of a processor partition into a function of its own (in module)
+  // with the signature of func. The results of the get calls replace the values of the other
+  // partitions, which are removed.
+  static Function *clonePartition(Module *module, Function &func, const std::string &name,
+    const std::vector<Instruction*> &instructions);
+
+  // number of 32-bit words of a value in a message
+  static unsigned int getMessageWords(Type *type);
+  // Splits a message with values of these types into consecutive parts that fit into a
+  // channel of channelWords words. Returns the number of values of each part.
+  static std::vector<unsigned int> splitMessage(const std::vector<Type*> &types, unsigned int channelWords);
+  // Returns the numbers of the semaphores whose wait is already ordered after their post by the
+  // other communication calls and the execution order of the partitions. Partitions that don't
+  // execute their instructions in this order (the FPGA) cannot be used for the ordering.
+  static std::set<unsigned int> findRedundantSemaphores(Function &F, PostDominatorTree &PDT,
+    const std::vector<std::vector<Instruction*> > &executionOrders, const std::vector<bool> &isSequential);
+  // Returns true, if the calls of a message with values of these types may be moved by
+  // moveCommunicationCalls. Each channel carries one message per execution of its put and the
+  // receiver takes it before it needs anything of the next execution, so a put can only wait
+  // for the receiver, if the message is larger than the channel. splitMessage sends such a
+  // value on its own and the runtime passes it while the receiver reads it. Moving this put in
+  // front of a get could make two partitions wait for each other, so it is not moved.
+  static bool isMovableMessage(const std::vector<Type*> &types, unsigned int channelWords);
+  // Receives the values of the movable calls as late and sends them as early as possible in the
+  // vertices of a sequential partition (in execution order). messageCount is increased by the
+  // number of messages of the partition. Returns the number of moved messages.
+  static unsigned int moveCommunicationCalls(Function &F, std::vector<std::vector<Instruction*> > &vertices,
+    const std::set<Instruction*> &movableCalls, unsigned int &messageCount);
+  // value (or semaphore signal) that is sent from one partition to another
+  struct DependencyTransfer {
+    Instruction *depInstr, *tgtInstr;                       // producer and first user in the target partition
+    unsigned int depPosition, tgtPosition;                  // positions of the instructions in their vertices
+    PartitioningGraph::VertexDescriptor depVertex, tgtVertex;
+    bool useSemaphores;
+  };
+  // Collects the dependencies between partitions in one pass over the dependency list. Each value
+  // (or semaphore signal) is transferred once to each partition that uses it. The transfer goes to
+  // the first user in the execution order of the partition (positionInSchedule, indexed by vertex).
+  // Data of a load/store instruction replaces the loaded value, so each user gets a transfer.
+  static std::vector<DependencyTransfer> collectTransfers(PartitioningGraph &pGraph, InstructionDependencyList &dependencies,
+    const std::vector<DeviceInformation::DeviceType> &deviceTypes, const std::vector<unsigned int> &positionInSchedule);
+  // Calculates the expected number of executions of each block per execution of the function.
+  // The measured branch probabilities are used if we have them, else the estimation of LLVM.
+  // Blocks in loops are executed more than once.
+  static void calcBlockFrequencies(Function &F, LoopInfo *LI, BranchProbabilityInfo *BPI,
+    std::map<BranchInst*, float> &profiledBranches, std::map<BasicBlock*, float> &frequencies);
+  // Returns true, if the partition receives a value that depends on one of its own puts or
+  // posts in the same call, i.e. the value makes a round trip through other partitions.
+  static bool hasRoundTrip(const std::vector<Instruction*> *instructionsForPartition, unsigned int partitionCount,
+    unsigned int partition);
+
 private:
   std::vector<std::string> targetFunctions;
   std::vector<std::string> partitioningMethods;
@@ -36,11 +92,26 @@ private:
 
   std::vector<SimpleCCodeGenerator::GlobalArrayVariable> globalVariables;
 
+  // functions that compute the cached parameter values and their caches (see ParameterHoisting.h)
+  std::vector<std::pair<Function*, GlobalVariable*> > parameterInitFunctions;
+
+  // order in which the vertices of each partition are executed (for each function)
+  std::map<std::string, ListScheduler::Schedule> schedules;
+
+  // processor partition that starts and collects each FPGA partition (for each function)
+  std::map<std::string, std::map<unsigned int, unsigned int> > fpgaHostPartitions;
+
+  // predicted critical path of each function (for the report of the wait counters)
+  std::map<std::string, unsigned int> criticalPathCosts;
+
   void parseTargetFunctions(void);
   void parsePartitioningMethods(void);
   void parsePartitioningDevices(void);
 
   void handleDependencies(Module &M, Function &F, PartitioningGraph &pGraph, InstructionDependencyList &dependencies);
+  void hideCommunicationLatency(Function &F, PartitioningGraph &pGraph, const std::set<Instruction*> &movableCalls);
+  void insertSplitPhaseFPGAInvocations(Module &M, Function &F, PartitioningGraph &pGraph);
+  unsigned int removeRedundantSemaphores(Function &F, PartitioningGraph &pGraph, unsigned int firstSemNumber, unsigned int semNumberEnd);
 
   void savePartitioning(std::map<std::string, Function*> &functions, std::map<std::string, PartitioningGraph*> &graphs, 
     std::map<std::string, unsigned int> partitioningNumbers);
@@ -6,6 +6,7 @@
 #include <boost/graph/adjacency_list.hpp> 
 #include <boost/tuple/tuple.hpp>
 
+#include <string>
 #include <vector>
 
 
@@ -16,6 +17,14 @@ public:
 };
 
 
+// create the partitioning method with the given name ("random", "clustering", "sa", "k-lin"),
+// returns NULL if there is no such method
+AbstractPartitioningMethod *createPartitioningMethod(const std::string &name);
+
+// iterative methods need a starting point, if they are the first method that is applied
+void createInitialPartitioning(const std::string &name, PartitioningGraph &pGraph, std::vector<std::string> &targetDevices);
+
+
 
 class RandomPartitioning : public AbstractPartitioningMethod {
 public:
@@ -104,7 +113,13 @@ private:
 	void randomMove(State &state);
 	double randomNumber(void);
 
+	void updateCriticalVertices(State &state);
+
 	std::vector<std::string> devices;
+
+	// vertices on the critical path of the current state
+	std::vector<PartitioningGraph::VertexDescriptor> criticalVertices;
+	float criticalMoveProbability;
 	
 	Temperature Tinit, Tmin;
 	int iterationMax;
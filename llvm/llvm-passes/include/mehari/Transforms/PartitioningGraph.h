@@ -9,7 +9,9 @@
 #include <boost/graph/adjacency_list.hpp> 
 #include <boost/graph/graphviz.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <boost/shared_ptr.hpp>
 
+#include <map>
 #include <vector>
 
 
@@ -38,10 +40,17 @@ public:
 		std::string name;
 		unsigned int partition;
 		std::vector<Instruction*> instructions;
+		std::vector<unsigned int> instructionIds;				// position of the instructions in the function
+		std::map<std::string, unsigned int> executionTimes;	// cached execution time for each device
 	};
 
+	typedef std::pair<std::string, std::string> DevicePair;
+
 	struct Communication {
 		std::vector<CommunicationType> comOperations;
+		std::vector<Instruction*> comInstructions;	// target instruction of each communication operation
+		std::vector<Instruction*> comSources;		// instruction that produces the value of each operation
+		std::map<DevicePair, unsigned int> comCosts;	// cached costs for (source, target) device, ("", "") is device independent
 	};
 
 	typedef boost::adjacency_list<
@@ -56,6 +65,7 @@ public:
 	typedef Graph::vertex_descriptor VertexDescriptor;
 	typedef Graph::edge_iterator EdgeIterator;
 	typedef Graph::edge_descriptor EdgeDescriptor;
+	typedef std::vector<std::pair<VertexDescriptor, VertexDescriptor> > VertexPairList;
 
 	unsigned int getVertexCount(void);
 	unsigned int getVertexCountForPartition(unsigned int i);
@@ -84,14 +94,65 @@ public:
 	unsigned int getDeviceIndependentCommunicationCost(VertexDescriptor vd1, VertexDescriptor vd2);
 	unsigned int getExecutionTime(VertexDescriptor vd, std::string &targetDevice);
 
+	// the VHDL backend can generate hardware for all instructions of the vertex
+	bool isFPGAEligible(VertexDescriptor vd);
+
+	// use measured cycle counts (e.g. from an ExecutionProfile) instead of the 
+	// static costs of the HardwareInformation for the instructions on this device
+	void setMeasuredExecutionTimes(const std::string &device, std::map<Instruction*, unsigned int> &cycles);
+
+	// weight the costs of instructions in conditional regions and loops by the execution frequency 
+	// of their basic block relative to the first block of the vertex
+	void setBlockFrequencies(std::map<BasicBlock*, float> &frequencies);
+	// expected number of executions of the instruction per execution of the vertex
+	// (less than 1 in conditional regions, more than 1 in loops)
+	float getExpectedExecutionCount(VertexDescriptor vd, Instruction *instr);
+
+	// pairs of vertices that have to keep their order if they are in the same partition (see ListScheduler)
+	VertexPairList &getOrderingConstraints(void);
+
 	boost::tuple<unsigned int, unsigned int> getInternalExternalCommunicationCost(VertexDescriptor vd);
 
 	unsigned int getCriticalPathCost(std::vector<std::string> &partitioningDevices);
 
+	// start times and slack of a vertex or edge in the schedule of the critical path analysis
+	struct Timing {
+		unsigned int earliestStart;
+		unsigned int latestStart;
+		unsigned int slack;
+		Timing() : earliestStart(0), latestStart(0), slack(0) {};
+	};
+
+	struct CriticalityAnalysis {
+		unsigned int criticalPathCost;
+		std::vector<Timing> vertexTimings;	// indexed by vertex descriptor
+		std::map<std::pair<VertexDescriptor, VertexDescriptor>, Timing> edgeTimings;
+
+		Timing &getEdgeTiming(VertexDescriptor source, VertexDescriptor target) {
+			return edgeTimings[std::make_pair(source, target)];
+		}
+		bool isCritical(VertexDescriptor vd) { 
+			return vertexTimings[vd].slack == 0; 
+		}
+	};
+
+	CriticalityAnalysis getCriticalityAnalysis(std::vector<std::string> &partitioningDevices);
+	std::vector<VertexDescriptor> getCriticalVertices(std::vector<std::string> &partitioningDevices);
+
 	VertexDescriptor getVertexForInstruction(Instruction *instruction);
 
+	// store the graph with the costs for the devices, so the partitioning can be done without LLVM (see mehari-partition)
+	bool save(const std::string &filename, const std::string &functionName, std::vector<std::string> &devices);
+	// devices are the devices whose costs are in the file
+	bool load(const std::string &filename, std::string &functionName, std::vector<std::string> &devices);
+
+	// store the partition of each vertex
+	bool saveAssignment(const std::string &filename, const std::string &functionName, unsigned int partitionCount);
+	bool loadAssignment(const std::string &filename, const std::string &functionName, unsigned int &partitionCount);
+
 	void printGraph(const std::string &name);
 	void printGraphviz(Function &func, const std::string &name, std::string &outputDir);
+	void printCriticalityGraphviz(const std::string &name, std::string &outputDir, std::vector<std::string> &partitioningDevices);
 	void printPartitions(void);
 
 private:
@@ -108,8 +169,15 @@ private:
 	unsigned int calcEdgeCost(EdgeDescriptor ed, std::string &sourceDevice, std::string &targetDevice);
 	unsigned int calcDeviceIndependentEdgeCost(EdgeDescriptor ed);
 
+	void clearCostCache(void);
+
 	std::vector<Instruction*> instructionList;
 	Graph pGraph;
+
+	std::string measuredDevice;
+	boost::shared_ptr<std::map<Instruction*, unsigned int> > measuredCycles;
+	boost::shared_ptr<std::map<BasicBlock*, float> > blockFrequencies;
+	boost::shared_ptr<VertexPairList> orderingConstraints;
 	VertexDescriptor initVertex;
 };
 
@@ -0,0 +1,29 @@
+#ifndef PROFILING_INSTRUMENTATION_H
+#define PROFILING_INSTRUMENTATION_H
+
+#include "llvm/Pass.h"
+#include "llvm/IR/Module.h"
+
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+class ProfilingInstrumentation : public ModulePass {
+
+public:
+  static char ID;
+
+  ProfilingInstrumentation();
+  ~ProfilingInstrumentation();
+
+  virtual bool runOnModule(Module &M);
+
+private:
+  std::vector<std::string> targetFunctions;
+  void parseTargetFunctions();
+
+  void instrumentFunction(Module &M, Function &F, unsigned int functionId);
+};
+
+#endif /*PROFILING_INSTRUMENTATION_H*/
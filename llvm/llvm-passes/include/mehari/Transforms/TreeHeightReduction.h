@@ -0,0 +1,43 @@
+#ifndef TREE_HEIGHT_REDUCTION_H
+#define TREE_HEIGHT_REDUCTION_H
+
+#include "llvm/Pass.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Rebalances chains of floating point additions and multiplications, e.g.
+// ((a+b)+c)+d becomes (a+b)+(c+d), so the depth of a chain with n operands
+// is reduced from n-1 to ceil(log2(n)). This changes the rounding of the
+// results (like -ffast-math does), so the chains are only rewritten, if
+// -fp-reassociate is given. Otherwise the pass only reports them.
+// Run -speedup before and after this pass to see the effect on the critical path.
+class TreeHeightReduction : public FunctionPass {
+
+public:
+  static char ID;
+
+  TreeHeightReduction();
+  ~TreeHeightReduction();
+
+  virtual bool runOnFunction(Function &func);
+
+  // override the command line options
+  void setTargetFunctions(const std::vector<std::string> &functions);
+  void setReassociate(bool enable);
+
+private:
+  std::vector<std::string> targetFunctions;
+  bool reassociate;
+  void parseTargetFunctions();
+
+  bool isChainRoot(Instruction *instr);
+  unsigned int collectChain(Instruction *node, std::vector<Value*> &leaves, std::vector<Instruction*> &inner);
+  void rebalanceChain(Instruction *root, std::vector<Value*> &leaves, std::vector<Instruction*> &inner);
+};
+
+#endif /*TREE_HEIGHT_REDUCTION_H*/
@@ -0,0 +1,154 @@
+#include "mehari/Analysis/ExecutionProfile.h"
+
+#include "mehari/utils/ContainerUtils.h"
+
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <fstream>
+#include <sstream>
+
+
+ExecutionProfile::ExecutionProfile() {}
+
+ExecutionProfile::~ExecutionProfile() {}
+
+
+bool ExecutionProfile::load(const std::string &filename) {
+	// profile format (one entry per line, '#' starts a comment):
+	//   function <name> <invocations> <instruction count>
+	//   instr <id> <executions> <cycles>
+	//   branch <id> <taken> <not taken>
+	std::ifstream file(filename.c_str());
+	if (!file.is_open()) {
+		errs() << "ERROR: Could not open execution profile " << filename << "\n";
+		return false;
+	}
+
+	FunctionProfile *currentFunction = NULL;
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream iss(line);
+		std::string entryType;
+		iss >> entryType;
+
+		bool valid;
+		if (entryType == "function") {
+			std::string name;
+			FunctionProfile funcProfile;
+			valid = !(iss >> name >> funcProfile.invocationCount >> funcProfile.instructionCount).fail();
+			if (valid) {
+				functions[name] = funcProfile;
+				currentFunction = &functions[name];
+			}
+		}
+		else if (entryType == "instr" && currentFunction != NULL) {
+			unsigned int id;
+			InstructionProfile instrProfile;
+			valid = !(iss >> id >> instrProfile.executionCount >> instrProfile.cycleCount).fail();
+			if (valid)
+				currentFunction->instructions[id] = instrProfile;
+		}
+		else if (entryType == "branch" && currentFunction != NULL) {
+			unsigned int id;
+			BranchProfile branchProfile;
+			valid = !(iss >> id >> branchProfile.takenCount >> branchProfile.notTakenCount).fail();
+			if (valid)
+				currentFunction->branches[id] = branchProfile;
+		}
+		else
+			valid = false;
+
+		if (!valid) {
+			errs() << "ERROR: Invalid entry in execution profile " << filename << ":" << lineNumber << "\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool ExecutionProfile::hasFunction(const std::string &name) {
+	return contains(functions, name);
+}
+
+
+ExecutionProfile::FunctionProfile *ExecutionProfile::getFunctionProfile(const std::string &name) {
+	if (!hasFunction(name))
+		return NULL;
+	return &functions[name];
+}
+
+
+std::vector<Instruction*> ExecutionProfile::getProfiledInstructions(Function &F) {
+	std::vector<Instruction*> instructions;
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+		instructions.push_back(&*I);
+	return instructions;
+}
+
+
+ExecutionProfile::FunctionProfile *ExecutionProfile::getMatchingProfile(Function &F, std::vector<Instruction*> &instructions) {
+	FunctionProfile *funcProfile = getFunctionProfile(F.getName().str());
+	if (funcProfile == NULL)
+		return NULL;
+
+	instructions = getProfiledInstructions(F);
+	if (instructions.size() != funcProfile->instructionCount) {
+		errs() << "WARNING: The execution profile of " << F.getName() << " was recorded for a different version "
+			<< "of the function (" << funcProfile->instructionCount << " instead of " << instructions.size()
+			<< " instructions). It will be ignored.\n";
+		return NULL;
+	}
+
+	return funcProfile;
+}
+
+
+bool ExecutionProfile::getMeasuredCycles(Function &F, std::map<Instruction*, unsigned int> &cycles, float scale) {
+	std::vector<Instruction*> instructions;
+	FunctionProfile *funcProfile = getMatchingProfile(F, instructions);
+	if (funcProfile == NULL)
+		return false;
+
+	for (std::map<unsigned int, InstructionProfile>::iterator it = funcProfile->instructions.begin();
+		it != funcProfile->instructions.end(); ++it) {
+		// instructions that have never been executed keep their static costs
+		if (it->first >= instructions.size() || it->second.executionCount == 0)
+			continue;
+		double average = (double)it->second.cycleCount / it->second.executionCount;
+		cycles[instructions[it->first]] = (unsigned int)(average * scale + 0.5);
+	}
+
+	return true;
+}
+
+
+bool ExecutionProfile::getBranchProbabilities(Function &F, std::map<BranchInst*, float> &probabilities) {
+	std::vector<Instruction*> instructions;
+	FunctionProfile *funcProfile = getMatchingProfile(F, instructions);
+	if (funcProfile == NULL)
+		return false;
+
+	for (std::map<unsigned int, BranchProfile>::iterator it = funcProfile->branches.begin();
+		it != funcProfile->branches.end(); ++it) {
+		unsigned long long total = it->second.takenCount + it->second.notTakenCount;
+		if (it->first >= instructions.size() || total == 0)
+			continue;
+		BranchInst *bInstr = dyn_cast<BranchInst>(instructions[it->first]);
+		if (bInstr == NULL || !bInstr->isConditional()) {
+			errs() << "WARNING: The execution profile of " << F.getName() << " contains a branch entry "
+				<< "for the instruction " << it->first << " that is no conditional branch.\n";
+			continue;
+		}
+		probabilities[bInstr] = (float)it->second.takenCount / total;
+	}
+
+	return true;
+}
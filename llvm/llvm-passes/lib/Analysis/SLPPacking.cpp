@@ -0,0 +1,102 @@
+#include "mehari/Analysis/SLPPacking.h"
+
+#include <algorithm>
+
+
+SLPPacking::SLPPacking(const std::vector<Instruction*> &instructions) {
+	// operations that can still be delayed to the position of a second operation
+	std::vector<Instruction*> open;
+	BasicBlock *currentBlock = NULL;
+
+	for (std::vector<Instruction*>::const_iterator it = instructions.begin(); it != instructions.end(); ++it) {
+		Instruction *instr = *it;
+
+		// a pair must be in straight-line code
+		if (instr->getParent() != currentBlock || isa<TerminatorInst>(instr) || isa<PHINode>(instr))
+			open.clear();
+		currentBlock = instr->getParent();
+
+		// an operation that is used can't be delayed
+		for (User::op_iterator opIt = instr->op_begin(); opIt != instr->op_end(); ++opIt)
+			if (Instruction *op = dyn_cast<Instruction>(*opIt))
+				open.erase(std::remove(open.begin(), open.end(), op), open.end());
+
+		// the generated code reads loaded values where they are used, so an operation
+		// that reads memory can't be delayed behind a write
+		if (isa<StoreInst>(instr) || isa<CallInst>(instr)) {
+			std::vector<Instruction*> stillOpen;
+			for (std::vector<Instruction*>::iterator openIt = open.begin(); openIt != open.end(); ++openIt)
+				if (!isa<LoadInst>((*openIt)->getOperand(0)) && !isa<LoadInst>((*openIt)->getOperand(1)))
+					stillOpen.push_back(*openIt);
+			open.swap(stillOpen);
+		}
+
+		if (!isPackable(instr))
+			continue;
+
+		// prefer the operation whose operands are in the same packs, then the nearest one
+		std::vector<Instruction*>::iterator best = open.end();
+		unsigned int bestAffinity = 0;
+		for (std::vector<Instruction*>::iterator openIt = open.begin(); openIt != open.end(); ++openIt) {
+			if ((*openIt)->getOpcode() != instr->getOpcode() || (*openIt)->getType() != instr->getType())
+				continue;
+			unsigned int affinity = getAffinity(*openIt, instr);
+			if (best == open.end() || affinity >= bestAffinity) {
+				best = openIt;
+				bestAffinity = affinity;
+			}
+		}
+
+		if (best != open.end()) {
+			packOfInstruction[*best] = packs.size();
+			packOfInstruction[instr] = packs.size();
+			packs.push_back(Pack(*best, instr));
+			open.erase(best);
+		}
+		else
+			open.push_back(instr);
+	}
+}
+
+SLPPacking::~SLPPacking() {}
+
+
+const std::vector<SLPPacking::Pack> &SLPPacking::getPacks(void) {
+	return packs;
+}
+
+const SLPPacking::Pack *SLPPacking::getPack(Instruction *instr) {
+	std::map<Instruction*, unsigned int>::iterator it = packOfInstruction.find(instr);
+	return (it != packOfInstruction.end() ? &packs[it->second] : NULL);
+}
+
+bool SLPPacking::isFirstOfPack(Instruction *instr) {
+	const Pack *pack = getPack(instr);
+	return pack != NULL && pack->first == instr;
+}
+
+
+bool SLPPacking::isPackable(Instruction *instr) {
+	switch (instr->getOpcode()) {
+		case Instruction::FAdd:
+		case Instruction::FSub:
+		case Instruction::FMul:
+			return instr->getType()->isDoubleTy();
+		default:
+			return false;
+	}
+}
+
+
+// number of operands that are already in the lanes of the same pack
+unsigned int SLPPacking::getAffinity(Instruction *first, Instruction *second) {
+	unsigned int affinity = 0;
+	for (unsigned int i = 0; i < 2; i++) {
+		Instruction *op1 = dyn_cast<Instruction>(first->getOperand(i));
+		Instruction *op2 = dyn_cast<Instruction>(second->getOperand(i));
+		const Pack *pack = (op1 ? getPack(op1) : NULL);
+		if (pack != NULL && pack->first == op1 && pack->second == op2)
+			affinity++;
+	}
+	return affinity;
+}
@@ -1,4 +1,5 @@
 #include "mehari/CodeGen/SimpleCCodeGenerator.h"
+#include "mehari/Analysis/SLPPacking.h"
 
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
@@ -38,7 +39,11 @@ namespace CCodeMaps {
     (Instruction::SRem, "%")
     (Instruction::FRem, "%")
     (Instruction::Or,   "|")
-    (Instruction::And,  "&");
+    (Instruction::And,  "&")
+    (Instruction::Xor,  "^")
+    (Instruction::Shl,  "<<")
+    (Instruction::LShr, ">>")
+    (Instruction::AShr, ">>");
 
     // not all of these cases are implemented in the code generator
     // isnan: at least one of the arguments is a not-a-number value
@@ -84,6 +89,7 @@ namespace CCodeMaps {
 
 SimpleCCodeGenerator::SimpleCCodeGenerator(CodeGeneratorBackend* backend)
     : ignoreDataDependencies(false),
+      useSLPPacking(false),
       backend(backend ? backend : new CCodeBackend()) { }
 
 SimpleCCodeGenerator::~SimpleCCodeGenerator() {
@@ -95,6 +101,10 @@ void SimpleCCodeGenerator::setIgnoreDataDependencies(bool ignoreThem) {
   ignoreDataDependencies = ignoreThem;
 }
 
+void SimpleCCodeGenerator::setSLPPacking(bool usePacking) {
+  useSLPPacking = usePacking;
+}
+
 template <typename T>
 T* convertAddressStringToPointer(const std::string& address) {
   std::stringstream ss;
@@ -118,6 +128,10 @@ void SimpleCCodeGenerator::createCCode(std::ostream& stream, Function &func, con
   // extract the parameter information from the given function
   extractFunctionParameters(func);
 
+  boost::scoped_ptr<SLPPacking> packing;
+  if (useSLPPacking)
+    packing.reset(new SLPPacking(instructions));
+
   // determine the CalcState to start with
   Instruction *firstInstr = instructions.front();
   if (isa<LoadInst>(firstInstr)) 
@@ -217,6 +231,11 @@ void SimpleCCodeGenerator::createCCode(std::ostream& stream, Function &func, con
         if (isa<StoreInst>(instr)) {
           backend->generateStore(instr->getOperand(1), instr->getOperand(0));
         }
+        else if (packing && packing->getPack(instr)) {
+          // the first operation of a pair is generated together with the second one
+          if (!packing->isFirstOfPack(instr))
+            backend->generatePackedBinaryOperator(packing->getPack(instr)->first, instr);
+        }
         else if (isa<BinaryOperator>(instr)) {
           // create new temporary variable and print C code
           std::string tmpVar = backend->createTemporaryVariable(instr);
@@ -236,7 +255,8 @@ void SimpleCCodeGenerator::createCCode(std::ostream& stream, Function &func, con
             backend->generateCall(functionName, tmpVar, args);
             // TODO: not very nice.. is there a better solution without asking for the function name?
             if (functionName == "_get_real" || functionName == "_get_int" 
-             || functionName == "_get_bool" || functionName == "_get_intptr") {
+             || functionName == "_get_bool" || functionName == "_get_intptr"
+             || functionName == "_ring_get_real" || functionName == "_ring_get_int" || functionName == "_ring_get_bool") {
               if (!ignoreDataDependencies) {
                 std::string tgtOperand = cast<MDString>(instr->getMetadata("targetop")->getOperand(0))->getString();
                 dataDependencies[tgtOperand] = tmpVar;
@@ -255,6 +275,10 @@ void SimpleCCodeGenerator::createCCode(std::ostream& stream, Function &func, con
           std::string tmpVar = backend->createTemporaryVariable(instr);
           backend->generateIntegerExtension(tmpVar, extInstr->getOperand(0));
         }
+        else if (CastInst *castInstr = dyn_cast<CastInst>(instr)) {
+          std::string tmpVar = backend->createTemporaryVariable(instr);
+          backend->generateCast(tmpVar, castInstr->getOperand(0), castInstr->getDestTy(), castInstr->getOpcode());
+        }
         else if (BranchInst *brInstr = dyn_cast<BranchInst>(instr)) {
           if (brInstr->isUnconditional()) {
             // handle phi nodes branch targets
@@ -370,15 +394,28 @@ CodeGeneratorBackend::~CodeGeneratorBackend() {}
 
 void CodeGeneratorBackend::generateEndOfMethod() { }
 
+void CodeGeneratorBackend::generatePackedBinaryOperator(Instruction *first, Instruction *second) {
+  generateBinaryOperator(createTemporaryVariable(first), first->getOperand(0), first->getOperand(1), first->getOpcode());
+  generateBinaryOperator(createTemporaryVariable(second), second->getOperand(0), second->getOperand(1), second->getOpcode());
+}
+
 void CodeGeneratorBackend::addDataDependency(Value *valueFromOtherThread, const std::string& isSavedHere) { }
 
 
 CCodeBackend::CCodeBackend()
   : branchLabelNameGenerator("label"),
-    tmpVarNameGenerator("t") { }
+    tmpVarNameGenerator("t"),
+    waitCounterPartition(-1),
+    waitCounterFirstPartition(0),
+    hasWaitCounters(false) { }
 
 CCodeBackend::~CCodeBackend() {}
 
+void CCodeBackend::setWaitCounters(unsigned int partition, unsigned int firstPartition) {
+  waitCounterPartition = partition;
+  waitCounterFirstPartition = firstPartition;
+}
+
 void CCodeBackend::init(SimpleCCodeGenerator* generator, std::ostream& stream) {
   this->generator = generator;
   this->output_stream = &stream;
@@ -392,6 +429,7 @@ void CCodeBackend::init(SimpleCCodeGenerator* generator, std::ostream& stream) {
   tmpVarNameGenerator.reset();
   declarations.str("");
   ccode.str("");
+  hasWaitCounters = false;
 }
 
 std::string CCodeBackend::generateBranchLabel(Value *target) {
@@ -442,6 +480,18 @@ std::string CCodeBackend::getOperandString(Value* addr) {
     return "## " + toString(addr) + " ##";
 }
 
+std::string CCodeBackend::getPackedOperandString(Value* lane0, Value* lane1) {
+  std::string op0 = getOperandString(lane0), op1 = getOperandString(lane1);
+
+  // both lanes of the same vector can be used as they are
+  if (op0.size() > 3 && op0.compare(op0.size()-3, 3, "[0]") == 0
+      && op1 == op0.substr(0, op0.size()-3) + "[1]"
+      && contains(tmpVariables["mehari_v2df"], op0.substr(0, op0.size()-3)))
+    return op0.substr(0, op0.size()-3);
+
+  return "((mehari_v2df){" + op0 + ", " + op1 + "})";
+}
+
 
 void CCodeBackend::generateStore(Value *op1, Value *op2) {
   ccode << "\t"
@@ -453,16 +503,53 @@ void CCodeBackend::generateStore(Value *op1, Value *op2) {
 
 void CCodeBackend::generateBinaryOperator(std::string tmpVar,
     Value *op1, Value *op2, unsigned opcode) {
+  // all integers are int in the C code
+  bool isUnsigned = (opcode == Instruction::UDiv || opcode == Instruction::URem || opcode == Instruction::LShr);
+  std::string cast = (isUnsigned ? "(unsigned int)" : "");
   ccode << "\t" << tmpVar
     <<  " = "
-    <<  getOperandString(op1)
+    <<  cast << getOperandString(op1)
     <<  " " << CCodeMaps::parseBinaryOperator(opcode) << " "
-    <<  getOperandString(op2)
+    <<  cast << getOperandString(op2)
     <<  ";\n";
 }
 
+// The lanes of the result are used like variables. The type mehari_v2df is a GCC vector of
+// two doubles, which is defined by the partitioning pass.
+void CCodeBackend::generatePackedBinaryOperator(Instruction *first, Instruction *second) {
+  std::string vecVar = tmpVarNameGenerator.next();
+  tmpVariables["mehari_v2df"].push_back(vecVar);
+  ccode << "\t" << vecVar
+    <<  " = "
+    <<  getPackedOperandString(first->getOperand(0), second->getOperand(0))
+    <<  " " << CCodeMaps::parseBinaryOperator(first->getOpcode()) << " "
+    <<  getPackedOperandString(first->getOperand(1), second->getOperand(1))
+    <<  ";\n";
+  variables[first]  = vecVar + "[0]";
+  variables[second] = vecVar + "[1]";
+}
+
+// kind of a blocking communication call for the wait counters (see runtime/mehari_waits.h)
+static const char* getWaitKind(const std::string& funcName) {
+  if (funcName == "_sem_wait" || funcName == "_ring_sem_wait")
+    return "MEHARI_WAIT_SEMAPHORE";
+  else if (funcName == "_fpga_collect")
+    return "MEHARI_WAIT_FPGA";
+  else if (funcName.compare(0, 5, "_get_") == 0 || funcName.compare(0, 5, "_put_") == 0
+      || funcName.compare(0, 10, "_ring_get_") == 0 || funcName.compare(0, 10, "_ring_put_") == 0)
+    return "MEHARI_WAIT_DATA";
+  else
+    return NULL;
+}
+
 void CCodeBackend::generateCall(std::string funcName,
     std::string tmpVar, std::vector<Value*> args) {
+  const char* waitKind = (waitCounterPartition >= 0 ? getWaitKind(funcName) : NULL);
+  if (waitKind) {
+    ccode << "\t_mehari_wait_start = _mehari_wait_begin();\n";
+    hasWaitCounters = true;
+  }
+
   ccode << "\t";
   if (!tmpVar.empty())
     ccode << tmpVar << " = ";
@@ -475,6 +562,18 @@ void CCodeBackend::generateCall(std::string funcName,
   }
 
   ccode << ");\n";
+
+  if (waitKind) {
+    // the FPGA partitions are numbered like the partitions of the wait counters
+    std::string number = getOperandString(args[0]);
+    if (funcName == "_fpga_collect") {
+      std::stringstream ss;
+      ss << (waitCounterFirstPartition + cast<ConstantInt>(args[0])->getZExtValue());
+      number = ss.str();
+    }
+    ccode << "\t_mehari_wait_end(" << waitCounterPartition << ", " << waitKind << ", "
+      << number << ", _mehari_wait_start);\n";
+  }
 }
 
 void CCodeBackend::generateVoidCall(std::string funcName, std::vector<Value*> args) {
@@ -483,11 +582,12 @@ void CCodeBackend::generateVoidCall(std::string funcName, std::vector<Value*> ar
 
 void CCodeBackend::generateComparison(std::string tmpVar, Value *op1, Value *op2,
     FCmpInst::Predicate comparePredicate) {
+  std::string cast = (ICmpInst::isUnsigned(comparePredicate) ? "(unsigned int)" : "");
   ccode << "\t" << tmpVar
     <<  " = ("
-    <<  getOperandString(op1)
+    <<  cast << getOperandString(op1)
     <<  " " << CCodeMaps::parseComparePredicate(comparePredicate) << " "
-    <<  getOperandString(op2)
+    <<  cast << getOperandString(op2)
     <<  ");\n";
 }
 
@@ -499,6 +599,40 @@ void CCodeBackend::generateIntegerExtension(std::string tmpVar, Value *op) {
     <<  ";\n";
 }
 
+void CCodeBackend::generateCast(std::string tmpVar, Value *op, Type *type, unsigned opcode) {
+  // all integers are int and all floating point values are double in the C code
+  std::string operand = getOperandString(op);
+  std::string value;
+  switch (opcode) {
+    case Instruction::Trunc:
+      switch (type->getIntegerBitWidth()) {
+        case 1:  value = "(" + operand + " & 1)"; break;
+        case 8:  value = "(signed char)" + operand; break;
+        case 16: value = "(short)" + operand; break;
+        default: value = "(int)" + operand; break;
+      }
+      break;
+    case Instruction::SExt:
+      // true is 1 in C and -1 as a sign extended i1
+      value = (op->getType()->getIntegerBitWidth() == 1 ? "-" + operand : "(int)" + operand);
+      break;
+    case Instruction::FPToSI:  value = "(int)" + operand; break;
+    case Instruction::FPToUI:  value = "(int)(unsigned int)" + operand; break;
+    case Instruction::SIToFP:  value = "(double)" + operand; break;
+    case Instruction::UIToFP:  value = "(double)(unsigned int)" + operand; break;
+    case Instruction::FPTrunc: value = "(double)(float)" + operand; break;
+    case Instruction::FPExt:   value = "(double)" + operand; break;
+    case Instruction::BitCast: value = operand; break;
+    default:
+      value = "(" + getDatatype(type) + ")" + operand;
+      break;
+  }
+  ccode << "\t" << tmpVar
+    <<  " = "
+    <<  value
+    <<  ";\n";
+}
+
 void CCodeBackend::generateSelect(std::string tmpVar, Value *condition, Value *targetTrue, Value *targetFalse) {
     ccode << "\t" << tmpVar
     <<  " = "
@@ -535,6 +669,8 @@ void CCodeBackend::generateConditionalBranch(Value *condition, Instruction *targ
 }
 
 void CCodeBackend::generateReturn(Value *retVal) {
+  if (waitCounterPartition >= 0)
+    ccode << "\t_mehari_partition_end(" << waitCounterPartition << ", _mehari_partition_start);\n";
   ccode << "\treturn " << getOperandString(retVal) << ";\n";
 }
 
@@ -565,7 +701,20 @@ void CCodeBackend::generateBranchTargetIfNecessary(llvm::Instruction* instr) {
 void CCodeBackend::generateEndOfMethod() {
   // add declarations for temporary variables at the beginning of the code
   generateVariableDeclarations();
-  *output_stream << declarations.str() << ccode.str();
+  if (waitCounterPartition >= 0) {
+    // generateReturn has already added the end of the partition before the return
+    std::string code = ccode.str();
+    size_t lastLine = (code.size() > 1 ? code.rfind('\n', code.size()-2) : std::string::npos);
+    bool endsWithReturn = (code.compare(lastLine == std::string::npos ? 0 : lastLine+1, 8, "\treturn ") == 0);
+    *output_stream << declarations.str()
+      << (hasWaitCounters ? "\tuint64_t _mehari_wait_start;\n" : "")
+      << "\tuint64_t _mehari_partition_start = _mehari_wait_begin();\n"
+      << code;
+    if (!endsWithReturn)
+      *output_stream << "\t_mehari_partition_end(" << waitCounterPartition << ", _mehari_partition_start);\n";
+  }
+  else
+    *output_stream << declarations.str() << ccode.str();
 }
 
 std::string CCodeBackend::createTemporaryVariable(Value *addr) {
@@ -2,8 +2,11 @@
 #include "mehari/utils/ContainerUtils.h"
 
 #include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include <cstddef>
+#include <fstream>
 
 #include <boost/assign.hpp>
 
@@ -33,6 +36,21 @@ namespace {
 }
 
 
+static llvm::cl::opt<std::string> CPUTransport("cpu-transport", 
+            llvm::cl::desc("Select the runtime for dependencies between processor partitions: "
+            	"mailbox (_put_*/_get_*) or ring (lock-free ring buffers of mehari_channel)"), 
+            llvm::cl::value_desc("mailbox|ring"), llvm::cl::init("mailbox"));
+static llvm::cl::opt<std::string> CPUTransportCosts("cpu-transport-costs", 
+            llvm::cl::desc("Use the ring buffer costs that have been measured by mehari_channel_bench"), 
+            llvm::cl::value_desc("filename"));
+static llvm::cl::opt<bool> SplitPhaseFPGA("fpga-split-phase", 
+            llvm::cl::desc("Start the FPGA from a processor partition and collect its results where they are used, "
+            	"instead of waiting for them in a thread of its own"));
+static llvm::cl::opt<bool> CPUSLPPacking("cpu-slp-packing", 
+            llvm::cl::desc("Execute pairs of independent floating point operations in processor partitions together "
+            	"(GCC vector extensions) and count the costs of the pairs"));
+
+
 
 // HardwareInformation
 // -------------------
@@ -53,22 +71,61 @@ HardwareInformation::HardwareInformation() {
 	cortexA9->addInstructionInfo("fmul",   6);
 	cortexA9->addInstructionInfo("fdiv",  25);
 	cortexA9->addInstructionInfo("or",     2);
+	cortexA9->addInstructionInfo("and",    1);
+	cortexA9->addInstructionInfo("xor",    1);
+	cortexA9->addInstructionInfo("shl",    1);
+	cortexA9->addInstructionInfo("lshr",   1);
+	cortexA9->addInstructionInfo("ashr",   1);
+	cortexA9->addInstructionInfo("add",    1);
+	cortexA9->addInstructionInfo("sub",    1);
+	cortexA9->addInstructionInfo("mul",    2);
+	// the Cortex-A9 doesn't have a hardware divider
+	cortexA9->addInstructionInfo("udiv",  40);
+	cortexA9->addInstructionInfo("sdiv",  40);
+	cortexA9->addInstructionInfo("urem",  40);
+	cortexA9->addInstructionInfo("srem",  40);
 	cortexA9->addInstructionInfo("alloca", 0);
 	cortexA9->addInstructionInfo("load",   4);
 	cortexA9->addInstructionInfo("store",  6);
 	cortexA9->addInstructionInfo("getelementptr", 3);
 	cortexA9->addInstructionInfo("zext",   1);
+	cortexA9->addInstructionInfo("sext",   1);
+	cortexA9->addInstructionInfo("trunc",  1);
+	cortexA9->addInstructionInfo("bitcast", 0);
+	cortexA9->addInstructionInfo("sitofp", 4);
+	cortexA9->addInstructionInfo("uitofp", 4);
+	cortexA9->addInstructionInfo("fptosi", 4);
+	cortexA9->addInstructionInfo("fptoui", 4);
 	cortexA9->addInstructionInfo("icmp",   3);
 	cortexA9->addInstructionInfo("fcmp",   4);
 	cortexA9->addInstructionInfo("select", 4);
 	cortexA9->addInstructionInfo("phi",    0);
 	cortexA9->addInstructionInfo("call",  50); // NOTE: approximation
-
-	cortexA9->addCommunicationInfo("Cortex-A9", DataDependency,  455);
+	// NEON has no lanes for doubles, so a pair of independent operations is executed by two VFP
+	// instructions, which overlap in the pipeline (the second one is issued 1 cycle after the
+	// first for fadd/fsub and 2 cycles after it for fmul)
+	cortexA9->addInstructionInfo("fadd#pair",  5);
+	cortexA9->addInstructionInfo("fsub#pair",  5);
+	cortexA9->addInstructionInfo("fmul#pair",  8);
+
+	// the data dependency costs have been measured for one double value (two words)
+	cortexA9->addCommunicationInfo("Cortex-A9", DataDependency,  415);
+	cortexA9->addCommunicationInfo("Cortex-A9", DataWord,         20);
 	cortexA9->addCommunicationInfo("Cortex-A9", OrderDependency, 220);
-	cortexA9->addCommunicationInfo("xc7z020-1", DataDependency,  fpgaClockMultiplier * 275);
+	cortexA9->addCommunicationInfo("xc7z020-1", DataDependency,  fpgaClockMultiplier * 267);
+	cortexA9->addCommunicationInfo("xc7z020-1", DataWord,        fpgaClockMultiplier * 4);
 	cortexA9->addCommunicationInfo("xc7z020-1", OrderDependency, fpgaClockMultiplier * 115);
 
+	// the ring buffers only need two cache line transfers instead of a system call,
+	// these values are estimations until they are replaced by the output of mehari_channel_bench
+	if (useRingBuffersForCPUs()) {
+		cortexA9->addCommunicationInfo("Cortex-A9", DataDependency,  150);
+		cortexA9->addCommunicationInfo("Cortex-A9", DataWord,         10);
+		cortexA9->addCommunicationInfo("Cortex-A9", OrderDependency, 120);
+		if (!CPUTransportCosts.empty())
+			readCommunicationCosts(CPUTransportCosts, cortexA9->getCommunicationInfo("Cortex-A9"));
+	}
+
 	devices->insert(std::pair<std::string, DeviceInformation*>(cortexA9->getName(), cortexA9));
 
 	// add timinigs for the FPGA
@@ -80,11 +137,31 @@ HardwareInformation::HardwareInformation() {
 	fpga->addInstructionInfo("fmul",          fpgaClockMultiplier * 10);
 	fpga->addInstructionInfo("fdiv",          fpgaClockMultiplier * 58);
 	fpga->addInstructionInfo("or",            fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("and",           fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("xor",           fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("shl",           fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("lshr",          fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("ashr",          fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("add",           fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("sub",           fpgaClockMultiplier * 1);
+	// pipelined cores, see vhdl/mul.vhdl and vhdl/udiv.vhdl
+	fpga->addInstructionInfo("mul",           fpgaClockMultiplier * 4);
+	fpga->addInstructionInfo("udiv",          fpgaClockMultiplier * 34);
+	fpga->addInstructionInfo("sdiv",          fpgaClockMultiplier * 34);
+	fpga->addInstructionInfo("urem",          fpgaClockMultiplier * 34);
+	fpga->addInstructionInfo("srem",          fpgaClockMultiplier * 34);
 	fpga->addInstructionInfo("alloca",        fpgaClockMultiplier * 0);
 	fpga->addInstructionInfo("load",          fpgaClockMultiplier * 40);
 	fpga->addInstructionInfo("store",         fpgaClockMultiplier * 40);
 	fpga->addInstructionInfo("getelementptr", fpgaClockMultiplier * 0);
 	fpga->addInstructionInfo("zext",          fpgaClockMultiplier * 0);
+	fpga->addInstructionInfo("sext",          fpgaClockMultiplier * 0);
+	fpga->addInstructionInfo("trunc",         fpgaClockMultiplier * 0);
+	fpga->addInstructionInfo("bitcast",       fpgaClockMultiplier * 0);
+	fpga->addInstructionInfo("sitofp",        fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("uitofp",        fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("fptosi",        fpgaClockMultiplier * 1);
+	fpga->addInstructionInfo("fptoui",        fpgaClockMultiplier * 1);
 	fpga->addInstructionInfo("icmp",          fpgaClockMultiplier * 1);
 	fpga->addInstructionInfo("fcmp",          fpgaClockMultiplier * 3);
 	fpga->addInstructionInfo("select",        fpgaClockMultiplier * 0);
@@ -93,9 +170,11 @@ HardwareInformation::HardwareInformation() {
 	fpga->addInstructionInfo("call#sin",      fpgaClockMultiplier * (7+54+8));
 	fpga->addInstructionInfo("call#cos",      fpgaClockMultiplier * (7+54+8));
 
-	fpga->addCommunicationInfo("Cortex-A9", DataDependency,  fpgaClockMultiplier * 315);
+	fpga->addCommunicationInfo("Cortex-A9", DataDependency,  fpgaClockMultiplier * 307);
+	fpga->addCommunicationInfo("Cortex-A9", DataWord,        fpgaClockMultiplier * 4);
 	fpga->addCommunicationInfo("Cortex-A9", OrderDependency, fpgaClockMultiplier * 240);
 	fpga->addCommunicationInfo("xc7z020-1", DataDependency,  fpgaClockMultiplier * 1);
+	fpga->addCommunicationInfo("xc7z020-1", DataWord,        fpgaClockMultiplier * 0);
 	fpga->addCommunicationInfo("xc7z020-1", OrderDependency, fpgaClockMultiplier * 1);
 
 	devices->insert(std::pair<std::string, DeviceInformation*>(fpga->getName(), fpga));
@@ -107,16 +186,18 @@ HardwareInformation::HardwareInformation() {
 	for (std::map<std::string, DeviceInformation*>::iterator it = devices->begin(); it != devices->end(); ++it)
 		targets.push_back(it->first);
 
-	unsigned int dataDepCostSum = 0, orderDepCostSum = 0, count = 0;
+	unsigned int dataDepCostSum = 0, dataWordCostSum = 0, orderDepCostSum = 0, count = 0;
 	for (std::map<std::string, DeviceInformation*>::iterator it = devices->begin(); it != devices->end(); ++it) {
 		for (std::vector<std::string>::iterator targetIt = targets.begin(); targetIt != targets.end(); ++targetIt) {
 			dataDepCostSum += it->second->getCommunicationInfo(*targetIt)->getCommunicationCost(DataDependency);
+			dataWordCostSum += it->second->getCommunicationInfo(*targetIt)->getCommunicationCost(DataWord);
 			orderDepCostSum += it->second->getCommunicationInfo(*targetIt)->getCommunicationCost(OrderDependency);
 			count++;
 		}
 	}
 
 	deviceIndependentComCosts[DataDependency] = dataDepCostSum/count;
+	deviceIndependentComCosts[DataWord] = dataWordCostSum/count;
 	deviceIndependentComCosts[OrderDependency] = orderDepCostSum/count;
 }
 
@@ -138,6 +219,55 @@ unsigned int HardwareInformation::getDeviceIndependentCommunicationCost(Communic
 }
 
 
+bool HardwareInformation::useRingBuffersForCPUs(void) {
+	return CPUTransport == "ring";
+}
+
+
+bool HardwareInformation::useSplitPhaseFPGAInvocation(void) {
+	return SplitPhaseFPGA;
+}
+
+
+bool HardwareInformation::useSLPPackingForCPUs(void) {
+	return CPUSLPPacking;
+}
+
+
+void HardwareInformation::readCommunicationCosts(std::string filename, CommunicationInformation *comInfo) {
+	// the file is only read once, because HardwareInformation is created very often
+	static std::map<CommunicationType, unsigned int> measuredCosts;
+	static bool isRead = false;
+	if (!isRead) {
+		isRead = true;
+		// lines "<communication type> <cycles>", comments start with '#'
+		std::ifstream file(filename.c_str());
+		if (!file.is_open())
+			llvm::errs() << "ERROR: Could not open communication costs " << filename << "\n";
+		std::string type;
+		unsigned int cost;
+		while (file >> type) {
+			if (type[0] == '#') {
+				std::getline(file, type);
+				continue;
+			}
+			if (!(file >> cost))
+				break;
+			if (type == "DataDependency")
+				measuredCosts[DataDependency] = cost;
+			else if (type == "DataWord")
+				measuredCosts[DataWord] = cost;
+			else if (type == "OrderDependency")
+				measuredCosts[OrderDependency] = cost;
+			else
+				llvm::errs() << "WARNING: Unknown communication type " << type << " in " << filename << "\n";
+		}
+	}
+	for (std::map<CommunicationType, unsigned int>::iterator it = measuredCosts.begin(); it != measuredCosts.end(); ++it)
+		comInfo->addCommunicationCost(it->first, it->second);
+}
+
+
 
 // DeviceInformation
 // -----------------
@@ -182,6 +312,11 @@ InstructionInformation *DeviceInformation::getInstructionInfo(llvm::Instruction
 }
 
 
+InstructionInformation *DeviceInformation::getPackedInstructionInfo(llvm::Instruction *instr) {
+	return getValueOrDefault(*instrInfoMap, getOpcodeName(instr) + "#pair");
+}
+
+
 std::string DeviceInformation::getOpcodeName(llvm::Instruction *instr) {
 	if (llvm::CallInst *cInstr = llvm::dyn_cast<llvm::CallInst>(instr))
 		return "call#" + cInstr->getCalledFunction()->getName().str();
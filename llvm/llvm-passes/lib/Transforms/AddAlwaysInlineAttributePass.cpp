@@ -1,8 +1,14 @@
 #include "mehari/Transforms/AddAlwaysInlineAttributePass.h"
 
+#include "mehari/HardwareInformation.h"
+
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Attributes.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/InstIterator.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/Format.h"
 
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
@@ -14,9 +20,16 @@
 static cl::opt<std::string> TargetFunctions("inline-functions", 
             cl::desc("Specify the functions the always inline attribute will be added to (seperated by whitespace)"), 
             cl::value_desc("target-functions"));
+static cl::opt<std::string> RootFunctions("inline-reachable-from", 
+            cl::desc("Also inline the callees of these functions, if they contain operations for the FPGA (seperated by whitespace)"), 
+            cl::value_desc("root-functions"));
+static cl::opt<unsigned int> SizeBudget("inline-size-budget", 
+            cl::desc("Maximum number of instructions that are added by inlining the callees of -inline-reachable-from "
+            	"(the callees with the most parallelism are selected first)"), 
+            cl::init(5000));
 
 
-AddAlwaysInlineAttributePass::AddAlwaysInlineAttributePass() : ModulePass(ID) {
+AddAlwaysInlineAttributePass::AddAlwaysInlineAttributePass() : ModulePass(ID), sizeBudget(SizeBudget), usedBudget(0) {
   parseTargetFunctions();
 }
 
@@ -28,15 +41,206 @@ bool AddAlwaysInlineAttributePass::runOnModule(Module &M) {
     for (Module::iterator funcIt = M.begin(); funcIt != M.end(); ++funcIt) {
     	if (std::find(targetFunctions.begin(), targetFunctions.end(), funcIt->getName()) != targetFunctions.end()) {
         	funcIt->addFnAttr(Attribute::AlwaysInline);
+        	selected[&*funcIt] = true;
         	modified = true;
         }
     }
+
+	for (std::vector<std::string>::iterator rootIt = rootFunctions.begin(); rootIt != rootFunctions.end(); ++rootIt) {
+		if (rootIt->empty())
+			continue;
+		Function *root = M.getFunction(*rootIt);
+		if (!root || root->isDeclaration()) {
+			errs() << "ERROR: Function " << *rootIt << " not found!\n";
+			continue;
+		}
+		std::vector<Function*> callStack;
+		collectCandidates(root, callStack);
+	}
+	selectCandidates();
+	for (std::map<Function*, bool>::iterator selIt = selected.begin(); selIt != selected.end(); ++selIt) {
+		if (selIt->second) {
+			selIt->first->addFnAttr(Attribute::AlwaysInline);
+			modified = true;
+		}
+	}
+	if (!rootFunctions.empty() && !rootFunctions[0].empty())
+		errs() << "inlining: " << usedBudget << " of " << sizeBudget << " instructions of the size budget used\n";
+
     return modified;
 }
 
 
+// the cycles of these instructions are known for all devices
+static bool hasKnownCosts(Instruction *instr) {
+	switch (instr->getOpcode()) {
+		case Instruction::FAdd: case Instruction::FSub: case Instruction::FMul: case Instruction::FDiv:
+		case Instruction::Load: case Instruction::Store: case Instruction::GetElementPtr:
+		case Instruction::ZExt: case Instruction::ICmp: case Instruction::FCmp: case Instruction::Select:
+		case Instruction::Or:
+			return true;
+		case Instruction::Call:
+			return cast<CallInst>(instr)->getCalledFunction() != NULL;
+		default:
+			return false;
+	}
+}
+
+// Counts the operations that could be moved to the FPGA, if the function was inlined,
+// and estimates the parallelism of its body (sequential cycles / critical path on the CPU).
+AddAlwaysInlineAttributePass::CalleeInformation &AddAlwaysInlineAttributePass::getCalleeInformation(Function *callee) {
+	std::map<Function*, CalleeInformation>::iterator infoIt = calleeInfo.find(callee);
+	if (infoIt != calleeInfo.end())
+		return infoIt->second;
+
+	HardwareInformation hwInfo;
+	DeviceInformation *cpuInfo = hwInfo.getDeviceInfo("Cortex-A9");
+	DeviceInformation *fpgaInfo = hwInfo.getDeviceInfo("xc7z020-1");
+
+	CalleeInformation info;
+	info.instructions = 0;
+	info.offloadable = 0;
+	unsigned int sequential = 0, criticalPath = 0;
+	std::map<Instruction*, unsigned int> finished;
+	for (inst_iterator instrIt = inst_begin(callee); instrIt != inst_end(callee); ++instrIt) {
+		Instruction *instr = &*instrIt;
+		info.instructions++;
+		if (!hasKnownCosts(instr))
+			continue;
+
+		// the FPGA charges calls it can't compute with (1<<20) cycles (times its clock multiplier)
+		if (instr->getType()->isFloatingPointTy() && instr->getOpcode() != Instruction::Load
+				&& fpgaInfo->getInstructionInfo(instr)->getCycleCount() < (1u<<20))
+			info.offloadable++;
+
+		unsigned int start = 0;
+		for (User::op_iterator opIt = instr->op_begin(); opIt != instr->op_end(); ++opIt)
+			if (Instruction *operand = dyn_cast<Instruction>(*opIt))
+				start = std::max(start, finished[operand]);
+		unsigned int cycles = cpuInfo->getInstructionInfo(instr)->getCycleCount();
+		finished[instr] = start + cycles;
+		sequential += cycles;
+		criticalPath = std::max(criticalPath, start + cycles);
+	}
+	info.parallelism = (criticalPath > 0 ? (double)sequential / criticalPath : 1.0);
+
+	return calleeInfo[callee] = info;
+}
+
+// The attribute applies to all calls, so a selected callee is inlined at each call site.
+static unsigned int countCallSites(Function *callee) {
+	unsigned int count = 0;
+	for (Value::use_iterator useIt = callee->use_begin(); useIt != callee->use_end(); ++useIt)
+		if (CallInst *call = dyn_cast<CallInst>(*useIt))
+			if (call->getCalledFunction() == callee)
+				count++;
+	return count;
+}
+
+// Each call site gets a copy of the body, which replaces the call and the return. A function
+// that is only visible in the module is removed, when all of its calls have been inlined.
+static unsigned int getAddedInstructions(Function *callee, unsigned int instructions) {
+	long added = (long)countCallSites(callee) * ((long)instructions - 2);
+	if (callee->hasLocalLinkage())
+		added -= instructions;
+	return (unsigned int)std::max(added, 0L);
+}
+
+// Collects the callees of the caller that can be inlined. The callees of a callee are
+// collected first, so a function that only calls offloadable code can be decided after them.
+void AddAlwaysInlineAttributePass::collectCandidates(Function *caller, std::vector<Function*> &callStack) {
+	callStack.push_back(caller);
+	std::vector<Function*> &callees = candidateCallees[caller];
+	for (inst_iterator instrIt = inst_begin(caller); instrIt != inst_end(caller); ++instrIt) {
+		CallInst *call = dyn_cast<CallInst>(&*instrIt);
+		if (call == NULL)
+			continue;
+		Function *callee = call->getCalledFunction();
+		if (callee == NULL || callee->isDeclaration())
+			continue;
+		if (std::find(callStack.begin(), callStack.end(), callee) != callStack.end()) {
+			if (selected.find(callee) == selected.end())
+				errs() << "  keep calls of " << callee->getName() << ": recursive\n";
+			selected[callee] = false;
+			continue;
+		}
+
+		if (calleeInfo.find(callee) == calleeInfo.end()) {
+			CalleeInformation &info = getCalleeInformation(callee);
+			info.addedInstructions = getAddedInstructions(callee, info.instructions);
+			collectCandidates(callee, callStack);
+			candidates.push_back(callee);
+		}
+		if (std::find(callees.begin(), callees.end(), callee) == callees.end())
+			callees.push_back(callee);
+	}
+	callStack.pop_back();
+}
+
+// Selects the candidates with offloadable operations, the ones with the most parallelism
+// (sequential cycles / critical path) first, because the partitioning can only distribute
+// independent operations. Then the functions without offloadable operations are selected,
+// if they call a selected function.
+void AddAlwaysInlineAttributePass::selectCandidates() {
+	std::vector<std::pair<double, unsigned int> > ranking;
+	for (unsigned int i=0; i<candidates.size(); i++)
+		if (calleeInfo[candidates[i]].offloadable > 0)
+			ranking.push_back(std::make_pair(-calleeInfo[candidates[i]].parallelism, i));
+	std::sort(ranking.begin(), ranking.end());
+	for (std::vector<std::pair<double, unsigned int> >::iterator it = ranking.begin(); it != ranking.end(); ++it)
+		trySelect(candidates[it->second]);
+
+	for (std::vector<Function*>::iterator it = candidates.begin(); it != candidates.end(); ++it) {
+		if (calleeInfo[*it].offloadable > 0 || selected.find(*it) != selected.end())
+			continue;
+		bool callsSelected = false;
+		std::vector<Function*> &callees = candidateCallees[*it];
+		for (std::vector<Function*>::iterator calleeIt = callees.begin(); calleeIt != callees.end(); ++calleeIt)
+			callsSelected |= (selected.find(*calleeIt) != selected.end() && selected[*calleeIt]);
+		if (!callsSelected) {
+			errs() << "  keep calls of " << (*it)->getName() << ": no offloadable operations\n";
+			selected[*it] = false;
+			continue;
+		}
+		trySelect(*it);
+	}
+}
+
+void AddAlwaysInlineAttributePass::trySelect(Function *callee) {
+	if (selected.find(callee) != selected.end())
+		return;
+
+	CalleeInformation &info = calleeInfo[callee];
+	std::string reason;
+	if (callee->hasFnAttribute(Attribute::NoInline))
+		reason = "marked as noinline";
+	else if (usedBudget + info.addedInstructions > sizeBudget)
+		reason = "size budget exceeded";
+	if (!reason.empty()) {
+		errs() << "  keep calls of " << callee->getName() << ": " << reason << "\n";
+		selected[callee] = false;
+		return;
+	}
+
+	errs() << "  inline " << callee->getName() << ": " << info.offloadable << " offloadable operations, parallelism "
+		<< format("%.1f", info.parallelism) << ", adds " << info.addedInstructions << " instructions at "
+		<< countCallSites(callee) << " call sites\n";
+	selected[callee] = true;
+	usedBudget += info.addedInstructions;
+}
+
+
+void AddAlwaysInlineAttributePass::setRootFunctions(const std::vector<std::string> &functions) {
+	rootFunctions = functions;
+}
+
+void AddAlwaysInlineAttributePass::setSizeBudget(unsigned int budget) {
+	sizeBudget = budget;
+}
+
 void AddAlwaysInlineAttributePass::parseTargetFunctions() {
   boost::algorithm::split(targetFunctions, TargetFunctions, boost::algorithm::is_any_of(" "));
+  boost::algorithm::split(rootFunctions, RootFunctions, boost::algorithm::is_any_of(" "));
 }
 
 
@@ -0,0 +1,325 @@
+#include "mehari/Transforms/ListScheduler.h"
+
+#include "mehari/HardwareInformation.h"
+
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <set>
+
+
+namespace {
+
+	// memory that is accessed by a load or store: object (variable or array) and byte range within the object
+	struct MemoryAccess {
+		Value *object;
+		bool indirect;			// object is a pointer variable and we access the memory it points to
+		bool hasOffset;			// false if the offset is not constant
+		int64_t offset;
+		uint64_t size;
+		bool isWrite;
+	};
+
+	struct VertexAccesses {
+		std::vector<MemoryAccess> accesses;
+		bool readsAll, writesAll;	// calls that can access any memory
+		bool hasReturn;
+		std::set<Instruction*> branchTargets;
+		VertexAccesses() : readsAll(false), writesAll(false), hasReturn(false) {};
+
+		bool writes(void) {
+			if (writesAll)
+				return true;
+			for (std::vector<MemoryAccess>::iterator it = accesses.begin(); it != accesses.end(); ++it)
+				if (it->isWrite)
+					return true;
+			return false;
+		}
+	};
+
+}
+
+
+// library functions without side effects that are not marked as readnone (they can set errno)
+static bool isSideEffectFreeFunction(Function *func) {
+	static const char *functions[] = {
+		"sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sqrt", "exp", "log", "pow", "fabs", "floor", "ceil",
+		"sinf", "cosf", "tanf", "asinf", "acosf", "atanf", "atan2f", "sqrtf", "expf", "logf", "powf", "fabsf", "floorf", "ceilf",
+		NULL
+	};
+	if (func == NULL)
+		return false;
+	if (func->doesNotAccessMemory())
+		return true;
+	for (unsigned int i=0; functions[i] != NULL; i++)
+		if (func->getName() == functions[i])
+			return true;
+	return false;
+}
+
+
+static MemoryAccess getMemoryAccess(DataLayout &dataLayout, Value *pointer, bool isWrite) {
+	MemoryAccess access;
+	access.indirect = false;
+	access.hasOffset = true;
+	access.offset = 0;
+	access.size = dataLayout.getTypeStoreSize(cast<PointerType>(pointer->getType())->getElementType());
+	access.isWrite = isWrite;
+
+	// strip address calculations and remember the constant offset
+	pointer = pointer->stripPointerCasts();
+	while (GEPOperator *gep = dyn_cast<GEPOperator>(pointer)) {
+		APInt gepOffset(dataLayout.getPointerSizeInBits(), 0);
+		if (gep->accumulateConstantOffset(dataLayout, gepOffset))
+			access.offset += gepOffset.getSExtValue();
+		else
+			access.hasOffset = false;
+		pointer = gep->getPointerOperand()->stripPointerCasts();
+	}
+
+	// arrays that are passed as parameters are accessed through a pointer
+	// that is loaded from the stack variable of the parameter
+	if (LoadInst *lInstr = dyn_cast<LoadInst>(pointer)) {
+		pointer = lInstr->getPointerOperand();
+		access.indirect = true;
+	}
+
+	access.object = pointer;
+	return access;
+}
+
+
+static bool isConflicting(MemoryAccess &a1, MemoryAccess &a2) {
+	if (!a1.isWrite && !a2.isWrite)
+		return false;
+	if (a1.object != a2.object || a1.indirect != a2.indirect)
+		return false;
+	if (!a1.hasOffset || !a2.hasOffset)
+		return true;
+	return a1.offset < a2.offset + (int64_t)a2.size && a2.offset < a1.offset + (int64_t)a1.size;
+}
+
+
+static bool isConflicting(VertexAccesses &v1, VertexAccesses &v2) {
+	if ((v1.writesAll && (v2.readsAll || !v2.accesses.empty()))
+		|| (v2.writesAll && (v1.readsAll || !v1.accesses.empty()))
+		|| (v1.readsAll && v2.writes())
+		|| (v2.readsAll && v1.writes()))
+		return true;
+	for (std::vector<MemoryAccess>::iterator it1 = v1.accesses.begin(); it1 != v1.accesses.end(); ++it1)
+		for (std::vector<MemoryAccess>::iterator it2 = v2.accesses.begin(); it2 != v2.accesses.end(); ++it2)
+			if (isConflicting(*it1, *it2))
+				return true;
+	return false;
+}
+
+
+void ListScheduler::calcOrderingConstraints(PartitioningGraph &pGraph, PartitioningGraph::VertexPairList &constraints) {
+	unsigned int vertexCount = pGraph.getVertexCount();
+	std::vector<VertexAccesses> vertexAccesses(vertexCount);
+	std::map<Instruction*, VertexDescriptor> vertexOfInstruction;
+
+	Module *module = NULL;
+	for (unsigned int i=0; i<vertexCount && module == NULL; i++)
+		if (!pGraph.getInstructions(i).empty())
+			module = pGraph.getInstructions(i).front()->getParent()->getParent()->getParent();
+	if (module == NULL)
+		return;
+	DataLayout dataLayout(module);
+
+	for (unsigned int i=0; i<vertexCount; i++) {
+		std::vector<Instruction*> &instructions = pGraph.getInstructions(i);
+		VertexAccesses &va = vertexAccesses[i];
+		for (std::vector<Instruction*>::iterator instrIt = instructions.begin(); instrIt != instructions.end(); ++instrIt) {
+			Instruction *instr = *instrIt;
+			vertexOfInstruction[instr] = i;
+
+			if (LoadInst *lInstr = dyn_cast<LoadInst>(instr))
+				va.accesses.push_back(getMemoryAccess(dataLayout, lInstr->getPointerOperand(), false));
+			else if (StoreInst *sInstr = dyn_cast<StoreInst>(instr))
+				va.accesses.push_back(getMemoryAccess(dataLayout, sInstr->getPointerOperand(), true));
+			else if (CallInst *cInstr = dyn_cast<CallInst>(instr)) {
+				if (!isSideEffectFreeFunction(cInstr->getCalledFunction())) {
+					va.readsAll = true;
+					va.writesAll |= cInstr->mayWriteToMemory();
+				}
+			}
+			else if (BranchInst *bInstr = dyn_cast<BranchInst>(instr)) {
+				// the label of a branch target is only generated if the branch is generated before it
+				for (unsigned int s=0; s<bInstr->getNumSuccessors(); s++)
+					va.branchTargets.insert(&bInstr->getSuccessor(s)->front());
+			}
+			else if (isa<ReturnInst>(instr))
+				va.hasReturn = true;
+		}
+	}
+
+	for (unsigned int i=0; i<vertexCount; i++) {
+		VertexAccesses &va = vertexAccesses[i];
+
+		for (std::set<Instruction*>::iterator it = va.branchTargets.begin(); it != va.branchTargets.end(); ++it) {
+			std::map<Instruction*, VertexDescriptor>::iterator targetIt = vertexOfInstruction.find(*it);
+			if (targetIt != vertexOfInstruction.end() && targetIt->second > i)
+				constraints.push_back(std::make_pair(i, targetIt->second));
+		}
+
+		for (unsigned int j=0; j<vertexCount; j++) {
+			if (j == i)
+				continue;
+			// the return statement has to be the last statement of the partition
+			if (vertexAccesses[j].hasReturn && !va.hasReturn)
+				constraints.push_back(std::make_pair(i, j));
+			// keep the order of conflicting memory accesses
+			if (j > i && isConflicting(va, vertexAccesses[j]))
+				constraints.push_back(std::make_pair(i, j));
+		}
+	}
+}
+
+
+void ListScheduler::createPrecedences(PartitioningGraph &pGraph, std::vector<std::string> &partitioningDevices) {
+	unsigned int vertexCount = pGraph.getVertexCount();
+	predecessors.assign(vertexCount, std::vector<Precedence>());
+	successors.assign(vertexCount, std::vector<Precedence>());
+	executionTimes.assign(vertexCount, 0);
+
+	for (unsigned int i=0; i<vertexCount; i++)
+		executionTimes[i] = pGraph.getExecutionTime(i, partitioningDevices[pGraph.getPartition(i)]);
+
+	// data dependencies: communication costs only apply if the vertices are in different partitions
+	for (PartitioningGraph::EdgeIterator eIt = pGraph.getFirstEdgeIterator(); eIt != pGraph.getEndEdgeIterator(); ++eIt) {
+		VertexDescriptor u = pGraph.getSourceVertex(*eIt), v = pGraph.getTargetVertex(*eIt);
+		unsigned int comCost = 0;
+		if (pGraph.getPartition(u) != pGraph.getPartition(v))
+			comCost = pGraph.getCommunicationCost(u, v,
+				partitioningDevices[pGraph.getPartition(u)], partitioningDevices[pGraph.getPartition(v)]);
+		successors[u].push_back(Precedence(v, comCost));
+		predecessors[v].push_back(Precedence(u, comCost));
+	}
+
+	// ordering constraints only matter within a partition
+	PartitioningGraph::VertexPairList &constraints = pGraph.getOrderingConstraints();
+	for (PartitioningGraph::VertexPairList::iterator it = constraints.begin(); it != constraints.end(); ++it) {
+		if (pGraph.getPartition(it->first) != pGraph.getPartition(it->second))
+			continue;
+		successors[it->first].push_back(Precedence(it->second, 0));
+		predecessors[it->second].push_back(Precedence(it->first, 0));
+	}
+}
+
+
+bool ListScheduler::calcUpwardRanks(void) {
+	unsigned int vertexCount = executionTimes.size();
+
+	// topological order
+	std::vector<VertexDescriptor> order;
+	std::vector<unsigned int> remainingPredecessors(vertexCount);
+	for (unsigned int i=0; i<vertexCount; i++) {
+		remainingPredecessors[i] = predecessors[i].size();
+		if (remainingPredecessors[i] == 0)
+			order.push_back(i);
+	}
+	for (unsigned int i=0; i<order.size(); i++) {
+		for (std::vector<Precedence>::iterator it = successors[order[i]].begin(); it != successors[order[i]].end(); ++it)
+			if (--remainingPredecessors[it->first] == 0)
+				order.push_back(it->first);
+	}
+
+	// upward rank: length of the longest path from the start of the vertex to the end of the program
+	upwardRanks.assign(vertexCount, 0);
+	for (std::vector<VertexDescriptor>::reverse_iterator vIt = order.rbegin(); vIt != order.rend(); ++vIt) {
+		unsigned int maxSuccessorRank = 0;
+		for (std::vector<Precedence>::iterator it = successors[*vIt].begin(); it != successors[*vIt].end(); ++it)
+			maxSuccessorRank = std::max(maxSuccessorRank, it->second + upwardRanks[it->first]);
+		upwardRanks[*vIt] = executionTimes[*vIt] + maxSuccessorRank;
+	}
+
+	return order.size() == vertexCount;
+}
+
+
+ListScheduler::Schedule ListScheduler::schedule(PartitioningGraph &pGraph, std::vector<std::string> &partitioningDevices) {
+	unsigned int vertexCount = pGraph.getVertexCount();
+
+	Schedule result;
+	result.length = 0;
+	result.startTimes.assign(vertexCount, 0);
+
+	// processor partitions execute one vertex at a time, the FPGA executes independent vertices in parallel
+	unsigned int partitionCount = partitioningDevices.size();
+	for (unsigned int i=0; i<vertexCount; i++)
+		partitionCount = std::max(partitionCount, pGraph.getPartition(i) + 1);
+	result.partitionOrders.resize(partitionCount);
+	result.isSequential.assign(partitionCount, true);
+	HardwareInformation hwInfo;
+	for (unsigned int p=0; p<partitioningDevices.size(); p++) {
+		DeviceInformation *devInfo = hwInfo.getDeviceInfo(partitioningDevices[p]);
+		if (devInfo != NULL && devInfo->getType() == DeviceInformation::FPGA_RECONOS)
+			result.isSequential[p] = false;
+	}
+
+	createPrecedences(pGraph, partitioningDevices);
+	if (!calcUpwardRanks())
+		errs() << "ERROR: The partitioning graph contains a cycle. The vertices cannot be scheduled!\n";
+
+	std::vector<unsigned int> remainingPredecessors(vertexCount);
+	std::vector<unsigned int> readyTimes(vertexCount, 0);
+	std::vector<unsigned int> partitionFreeTimes(partitionCount, 0);
+	std::vector<VertexDescriptor> ready;
+	for (unsigned int i=0; i<vertexCount; i++) {
+		remainingPredecessors[i] = predecessors[i].size();
+		if (remainingPredecessors[i] == 0)
+			ready.push_back(i);
+	}
+
+	std::vector<bool> scheduled(vertexCount, false);
+	unsigned int scheduledCount = 0;
+	while (!ready.empty()) {
+		// choose the vertex that can start first (avoids waiting for data if there is other work to do)
+		// and prefer vertices with a long remaining path
+		std::vector<VertexDescriptor>::iterator best = ready.end();
+		unsigned int bestStart = 0;
+		for (std::vector<VertexDescriptor>::iterator it = ready.begin(); it != ready.end(); ++it) {
+			unsigned int partition = pGraph.getPartition(*it);
+			unsigned int start = readyTimes[*it];
+			if (result.isSequential[partition])
+				start = std::max(start, partitionFreeTimes[partition]);
+			if (best == ready.end() || start < bestStart
+				|| (start == bestStart && upwardRanks[*it] > upwardRanks[*best])
+				|| (start == bestStart && upwardRanks[*it] == upwardRanks[*best] && *it < *best)) {
+				best = it;
+				bestStart = start;
+			}
+		}
+
+		VertexDescriptor vd = *best;
+		ready.erase(best);
+		unsigned int partition = pGraph.getPartition(vd);
+		unsigned int finish = bestStart + executionTimes[vd];
+		result.startTimes[vd] = bestStart;
+		result.partitionOrders[partition].push_back(vd);
+		result.length = std::max(result.length, finish);
+		if (result.isSequential[partition])
+			partitionFreeTimes[partition] = finish;
+		scheduled[vd] = true;
+		scheduledCount++;
+
+		for (std::vector<Precedence>::iterator it = successors[vd].begin(); it != successors[vd].end(); ++it) {
+			readyTimes[it->first] = std::max(readyTimes[it->first], finish + it->second);
+			if (--remainingPredecessors[it->first] == 0)
+				ready.push_back(it->first);
+		}
+	}
+
+	// keep the original order for vertices that could not be scheduled (only if there is a cycle)
+	if (scheduledCount != vertexCount)
+		for (unsigned int i=0; i<vertexCount; i++)
+			if (!scheduled[i])
+				result.partitionOrders[pGraph.getPartition(i)].push_back(i);
+
+	return result;
+}
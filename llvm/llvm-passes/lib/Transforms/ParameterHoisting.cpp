@@ -0,0 +1,310 @@
+#include "mehari/Transforms/ParameterHoisting.h"
+
+#include "mehari/HardwareInformation.h"
+#include "mehari/utils/ContainerUtils.h"
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+#include <map>
+#include <algorithm>
+
+
+static cl::opt<std::string> TargetFunctions("hoisting-functions",
+            cl::desc("Specify the functions whose parameter-only computations will be hoisted (seperated by whitespace)"),
+            cl::value_desc("target-functions"));
+static cl::opt<std::string> ReportDevices("hoisting-devices",
+            cl::desc("Specify the devices for the report of the saved cycles (seperated by whitespace)"),
+            cl::init("Cortex-A9"));
+
+
+// math functions without side effects that can be computed in advance
+static const char *pureFunctions[] = {
+	"sin", "cos", "tan", "asin", "acos", "atan", "atan2", "sinh", "cosh", "tanh",
+	"exp", "log", "log10", "pow", "sqrt", "fabs", "floor", "ceil", "fmod", NULL
+};
+
+
+ParameterHoisting::ParameterHoisting() : ModulePass(ID) {
+	parseTargetFunctions();
+}
+
+ParameterHoisting::~ParameterHoisting() {}
+
+
+bool ParameterHoisting::runOnModule(Module &M) {
+	findWrittenParameters(M);
+
+	bool modified = false;
+	for (std::vector<std::string>::iterator funcIt = targetFunctions.begin(); funcIt != targetFunctions.end(); ++funcIt) {
+		Function *func = M.getFunction(*funcIt);
+		if (!func || func->isDeclaration()) {
+			errs() << "ERROR: Function " << *funcIt << " not found!\n";
+			continue;
+		}
+		modified |= hoistParameterComputations(M, *func);
+	}
+	return modified;
+}
+
+
+// element of a global array that is accessed with a constant index, e.g. Vp[3]
+static GlobalVariable *getGlobalElement(Value *pointer, uint64_t &index) {
+	GEPOperator *gep = dyn_cast<GEPOperator>(pointer);
+	if (gep == NULL || gep->getNumIndices() != 2 || !gep->hasAllConstantIndices())
+		return NULL;
+	GlobalVariable *global = dyn_cast<GlobalVariable>(gep->getPointerOperand());
+	if (global == NULL || !global->getType()->getElementType()->isArrayTy())
+		return NULL;
+	index = cast<ConstantInt>(*(gep->idx_end()-1))->getZExtValue();
+	return global;
+}
+
+// global variable whose address (or the address of one of its elements) is used
+static GlobalVariable *getReferencedGlobal(Value *value) {
+	value = value->stripPointerCasts();
+	while (GEPOperator *gep = dyn_cast<GEPOperator>(value))
+		value = gep->getPointerOperand()->stripPointerCasts();
+	return dyn_cast<GlobalVariable>(value);
+}
+
+
+void ParameterHoisting::findWrittenParameters(Module &M) {
+	// A global may be changed by a store or by any instruction that gets its address. We
+	// don't know what the code outside of this module does, but the caches are updated
+	// by <function>_on_parameter_change, which the model has to call anyway.
+	writtenGlobals.clear();
+	writtenElements.clear();
+	for (Module::iterator fIt = M.begin(); fIt != M.end(); ++fIt) {
+		for (inst_iterator it = inst_begin(*fIt); it != inst_end(*fIt); ++it) {
+			Instruction *instr = &*it;
+			for (unsigned int i=0; i<instr->getNumOperands(); i++) {
+				GlobalVariable *global = getReferencedGlobal(instr->getOperand(i));
+				if (global == NULL)
+					continue;
+
+				uint64_t index;
+				if (isa<LoadInst>(instr))
+					continue;
+				else if (isa<StoreInst>(instr) && i == 1 && getGlobalElement(instr->getOperand(i), index) == global)
+					writtenElements.insert(std::make_pair(global, index));
+				else
+					writtenGlobals.insert(global);
+			}
+		}
+	}
+}
+
+
+bool ParameterHoisting::isParameterLoad(Instruction *instr) {
+	LoadInst *lInstr = dyn_cast<LoadInst>(instr);
+	if (lInstr == NULL || lInstr->isVolatile())
+		return false;
+
+	uint64_t index;
+	GlobalVariable *global = getGlobalElement(lInstr->getPointerOperand(), index);
+	return global != NULL
+		&& !contains(writtenGlobals, global)
+		&& !contains(writtenElements, std::make_pair(global, index));
+}
+
+
+bool ParameterHoisting::isHoistable(Instruction *instr, const std::set<Instruction*> &hoistable) {
+	if (isParameterLoad(instr))
+		return true;
+
+	if (CallInst *cInstr = dyn_cast<CallInst>(instr)) {
+		Function *func = cInstr->getCalledFunction();
+		if (func == NULL)
+			return false;
+		bool isPure = false;
+		for (const char **name = pureFunctions; *name != NULL; name++)
+			isPure |= (func->getName() == *name);
+		if (!isPure)
+			return false;
+		for (unsigned int i=0; i<cInstr->getNumArgOperands(); i++) {
+			Value *arg = cInstr->getArgOperand(i);
+			if (!isa<ConstantFP>(arg) && !isa<ConstantInt>(arg)
+					&& !(isa<Instruction>(arg) && contains(hoistable, cast<Instruction>(arg))))
+				return false;
+		}
+		return true;
+	}
+
+	// the instructions must be supported by the code generators
+	switch (instr->getOpcode()) {
+		case Instruction::FAdd:
+		case Instruction::FSub:
+		case Instruction::FMul:
+		case Instruction::FDiv:
+		case Instruction::FCmp:
+		case Instruction::ZExt:
+		case Instruction::Select:
+			break;
+		default:
+			return false;
+	}
+	for (unsigned int i=0; i<instr->getNumOperands(); i++) {
+		Value *op = instr->getOperand(i);
+		if (!isa<ConstantFP>(op) && !isa<ConstantInt>(op)
+				&& !(isa<Instruction>(op) && contains(hoistable, cast<Instruction>(op))))
+			return false;
+	}
+	return true;
+}
+
+
+bool ParameterHoisting::hoistParameterComputations(Module &M, Function &F) {
+	LLVMContext &context = M.getContext();
+	std::string functionName = F.getName().str();
+
+	// the operands are defined before their users, so one pass is enough
+	std::set<Instruction*> hoistable;
+	std::vector<Instruction*> hoistableInOrder;
+	for (inst_iterator it = inst_begin(F); it != inst_end(F); ++it) {
+		if (isHoistable(&*it, hoistable)) {
+			hoistable.insert(&*it);
+			hoistableInOrder.push_back(&*it);
+		}
+	}
+
+	// cache the computed values that are used by the per-step code
+	std::vector<Instruction*> cachedValues;
+	for (std::vector<Instruction*>::iterator it = hoistableInOrder.begin(); it != hoistableInOrder.end(); ++it) {
+		if (isa<LoadInst>(*it) || !(*it)->getType()->isDoubleTy())
+			continue;
+		for (Value::use_iterator useIt = (*it)->use_begin(); useIt != (*it)->use_end(); ++useIt) {
+			Instruction *user = dyn_cast<Instruction>(*useIt);
+			if (user == NULL || !contains(hoistable, user)) {
+				cachedValues.push_back(*it);
+				break;
+			}
+		}
+	}
+	if (cachedValues.empty()) {
+		errs() << "parameter hoisting: " << functionName << ": nothing to hoist\n";
+		return false;
+	}
+
+	std::string initName = functionName + "_on_parameter_change";
+	if (M.getFunction(initName) != NULL) {
+		errs() << "ERROR: Function " << initName << " already exists!\n";
+		return false;
+	}
+
+	Type *doubleType = Type::getDoubleTy(context);
+	ArrayType *cacheType = ArrayType::get(doubleType, cachedValues.size());
+	GlobalVariable *cache = new GlobalVariable(M, cacheType, false, GlobalValue::ExternalLinkage,
+		ConstantAggregateZero::get(cacheType), functionName + "_parameter_cache");
+	std::vector<Constant*> cacheElements;
+	for (unsigned int i=0; i<cachedValues.size(); i++) {
+		Constant *indices[] = {
+			ConstantInt::get(Type::getInt32Ty(context), 0),
+			ConstantInt::get(Type::getInt32Ty(context), i)
+		};
+		cacheElements.push_back(ConstantExpr::getInBoundsGetElementPtr(cache, indices));
+	}
+
+	// copy the computations of the cached values into the new function
+	std::set<Instruction*> needed(cachedValues.begin(), cachedValues.end());
+	for (std::vector<Instruction*>::reverse_iterator it = hoistableInOrder.rbegin(); it != hoistableInOrder.rend(); ++it) {
+		if (!contains(needed, *it))
+			continue;
+		for (unsigned int i=0; i<(*it)->getNumOperands(); i++)
+			if (Instruction *op = dyn_cast<Instruction>((*it)->getOperand(i)))
+				needed.insert(op);
+	}
+
+	Function *initFunc = cast<Function>(M.getOrInsertFunction(initName, Type::getVoidTy(context), (Type *)0));
+	BasicBlock *initBlock = BasicBlock::Create(context, "entry", initFunc);
+	std::map<Instruction*, Instruction*> copies;
+	for (std::vector<Instruction*>::iterator it = hoistableInOrder.begin(); it != hoistableInOrder.end(); ++it) {
+		if (!contains(needed, *it))
+			continue;
+		Instruction *copy = (*it)->clone();
+		copy->setName((*it)->getName());
+		for (unsigned int i=0; i<copy->getNumOperands(); i++)
+			if (Instruction *op = dyn_cast<Instruction>(copy->getOperand(i)))
+				copy->setOperand(i, copies[op]);
+		initBlock->getInstList().push_back(copy);
+		copies[*it] = copy;
+
+		std::vector<Instruction*>::iterator cachedIt = std::find(cachedValues.begin(), cachedValues.end(), *it);
+		if (cachedIt != cachedValues.end())
+			new StoreInst(copy, cacheElements[cachedIt - cachedValues.begin()], initBlock);
+	}
+	ReturnInst::Create(context, initBlock);
+
+	// load the cached values in the function
+	std::vector<Instruction*> cacheLoads;
+	for (unsigned int i=0; i<cachedValues.size(); i++) {
+		LoadInst *cached = new LoadInst(cacheElements[i], cachedValues[i]->getName() + ".cached", cachedValues[i]);
+		cachedValues[i]->replaceAllUsesWith(cached);
+		cacheLoads.push_back(cached);
+	}
+
+	// remove the computations that are not used anymore (users before their operands)
+	std::vector<Instruction*> removed;
+	std::set<Instruction*> removedSet;
+	for (std::vector<Instruction*>::reverse_iterator it = hoistableInOrder.rbegin(); it != hoistableInOrder.rend(); ++it) {
+		bool unused = true;
+		for (Value::use_iterator useIt = (*it)->use_begin(); useIt != (*it)->use_end(); ++useIt) {
+			Instruction *user = dyn_cast<Instruction>(*useIt);
+			unused &= (user != NULL && contains(removedSet, user));
+		}
+		if (unused) {
+			removed.push_back(*it);
+			removedSet.insert(*it);
+		}
+	}
+
+	errs() << "parameter hoisting: " << functionName << ": " << removed.size() << " instructions moved to "
+		<< initName << ", " << cachedValues.size() << " values are cached in " << cache->getName() << "\n";
+	HardwareInformation hwInfo;
+	for (std::vector<std::string>::iterator devIt = reportDevices.begin(); devIt != reportDevices.end(); ++devIt) {
+		DeviceInformation *devInfo = hwInfo.getDeviceInfo(*devIt);
+		if (devInfo == NULL) {
+			errs() << "ERROR: Device " << *devIt << " not found!\n";
+			continue;
+		}
+		long saved = 0;
+		for (std::vector<Instruction*>::iterator it = removed.begin(); it != removed.end(); ++it)
+			saved += devInfo->getInstructionInfo(*it)->getCycleCount();
+		for (std::vector<Instruction*>::iterator it = cacheLoads.begin(); it != cacheLoads.end(); ++it)
+			saved -= devInfo->getInstructionInfo(*it)->getCycleCount();
+		errs() << "  saves " << saved << " cycles per call on " << *devIt << "\n";
+	}
+
+	for (std::vector<Instruction*>::iterator it = removed.begin(); it != removed.end(); ++it)
+		(*it)->eraseFromParent();
+
+	// tell the partitioning about the new function and its cache
+	Value *initMetadata[] = { initFunc, cache };
+	M.getOrInsertNamedMetadata(PARAMETER_INIT_METADATA)->addOperand(MDNode::get(context, initMetadata));
+
+	return true;
+}
+
+
+void ParameterHoisting::setTargetFunctions(const std::vector<std::string> &functions) {
+	targetFunctions = functions;
+}
+
+void ParameterHoisting::parseTargetFunctions() {
+	boost::algorithm::split(targetFunctions, TargetFunctions, boost::algorithm::is_any_of(" "));
+	boost::algorithm::split(reportDevices, ReportDevices, boost::algorithm::is_any_of(" "));
+}
+
+
+// register pass so we can call it using opt
+char ParameterHoisting::ID = 0;
+static RegisterPass<ParameterHoisting>
+Y("hoist-parameters", "Move computations that only depend on model parameters into an initialization function.");
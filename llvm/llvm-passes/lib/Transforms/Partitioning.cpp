@@ -1,15 +1,28 @@
 #include "mehari/Transforms/Partitioning.h"
 #include "mehari/Transforms/PartitioningAlgorithms.h"
+#include "mehari/Transforms/ParameterHoisting.h"
 
 #include "mehari/Analysis/InstructionDependencyAnalysis.h"
+#include "mehari/Analysis/ExecutionProfile.h"
 #include "mehari/CodeGen/SimpleCCodeGenerator.h"
 #include "mehari/CodeGen/TemplateWriter.h"
 #include "mehari/CodeGen/GenerateVHDL.h"
 
 #include "mehari/utils/StringUtils.h"
+#include "mehari/utils/ContainerUtils.h"
 
 #include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/IR/Module.h"
+
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/Verifier.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 #include "llvm/Support/InstIterator.h"
 #include "llvm/Support/raw_ostream.h"
@@ -19,12 +32,15 @@
 #include <sstream>
 #include <fstream>
 #include <ctime>
+#include <set>
+#include <climits>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/foreach.hpp>
 #include <boost/assign.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
 
 
 static cl::opt<std::string> TargetFunctions("partitioning-functions", 
@@ -45,6 +61,54 @@ static cl::opt<std::string> GraphOutputDir("partitioning-graph-output-dir",
 static cl::opt<std::string> TemplateDir("template-dir", 
             cl::desc("Set the directory where the code generation templates are located"), 
             cl::value_desc("template-dir"));
+static cl::opt<std::string> ProfileFile("partitioning-profile", 
+            cl::desc("Use the execution profile of an instrumented run instead of the static instruction costs"), 
+            cl::value_desc("profile-file"));
+static cl::opt<std::string> ProfileDevice("partitioning-profile-device", 
+            cl::desc("Set the device whose instruction costs are replaced by the execution profile"), 
+            cl::value_desc("device"), cl::init("Cortex-A9"));
+static cl::opt<float> ProfileScale("partitioning-profile-scale", 
+            cl::desc("Set the factor to convert the measured cycles to cycles of the profiled device"), 
+            cl::value_desc("factor"), cl::init(1.0));
+static cl::opt<std::string> GraphExportDir("partitioning-export-graph", 
+            cl::desc("Save the partitioning graph of each function to <dir>/<function>.pgraph (see mehari-partition)"), 
+            cl::value_desc("dir"));
+static cl::opt<std::string> AssignmentFile("partitioning-assignment", 
+            cl::desc("Use the partitioning created by mehari-partition instead of the partitioning methods"), 
+            cl::value_desc("assignment-file"));
+static cl::opt<bool> NoMessageCoalescing("partitioning-no-message-coalescing", 
+            cl::desc("Send each value that crosses a partition boundary in a message of its own"));
+static cl::opt<unsigned int> ChannelWords("partitioning-channel-words", 
+            cl::desc("Capacity of the channels between partitions in 32-bit words (a double takes two words, "
+            	"the ring buffers of the runtime have 16 slots), larger messages are split"), 
+            cl::init(16));
+static cl::opt<bool> KeepRedundantSemaphores("partitioning-keep-redundant-semaphores", 
+            cl::desc("Do not remove semaphores whose ordering is already implied by other communication"));
+static cl::opt<bool> NoLatencyHiding("partitioning-no-latency-hiding", 
+            cl::desc("Receive and send the data between processors next to the instructions that use and produce it, "
+            	"instead of as late and as early as possible"));
+static cl::opt<bool> NoBranchWeights("partitioning-no-branch-weights", 
+            cl::desc("Count the costs of conditional regions as if all branches were always executed"));
+static cl::opt<bool> CacheFPGAInputs("fpga-cache-inputs", 
+            cl::desc("Keep inputs of the FPGA, which are never written by the model, in registers and only send them, if they have changed"));
+static cl::opt<bool> AtomicFPGAMessages("fpga-atomic-messages", 
+            cl::desc("Send the inputs of the FPGA and receive its results as atomic messages (see mehari_message.h), "
+            	"so several threads can call the hardware thread"));
+static cl::opt<std::string> FPGAOperatorLimits("fpga-operator-limits",
+            cl::desc("Share the cores of an operator in the hardware thread, e.g. \"float_add=2 float_mul=1\" "
+            	"(separated by whitespace)"),
+            cl::value_desc("operator=count"));
+static cl::opt<bool> FPGAStaticSchedule("fpga-static-schedule",
+            cl::desc("Start the operations of the hardware thread at fixed clock cycles instead of using handshakes "
+            	"(falls back to handshakes for partitions with function calls or round trips through other partitions)"));
+static cl::opt<bool> EmulateFPGA("fpga-emulation",
+            cl::desc("Also generate a C implementation of the hardware thread for the ReconOS emulation in runtime/reconos_emu"));
+static cl::opt<std::string> IROutput("partitioning-ir-output",
+            cl::desc("Write the processor partitions as LLVM functions to linux/partitions.<ll|bc> "
+            	"and call them from the generated C code"),
+            cl::value_desc("ll|bc"));
+static cl::opt<bool> WaitCounters("partitioning-wait-counters",
+            cl::desc("Measure the cycles of each partition and how long it waits for each dependency (see runtime/mehari_waits.h)"));
 
 
 // Use data dependencies for all communication with the FPGA
@@ -87,6 +151,15 @@ bool Partitioning::runOnModule(Module &M) {
 		}
 	}
 
+	// read the functions of the parameter hoisting
+	if (NamedMDNode *initMetadata = M.getNamedMetadata(PARAMETER_INIT_METADATA)) {
+		for (unsigned int i=0; i<initMetadata->getNumOperands(); i++) {
+			MDNode *node = initMetadata->getOperand(i);
+			parameterInitFunctions.push_back(std::make_pair(
+				cast<Function>(node->getOperand(0)), cast<GlobalVariable>(node->getOperand(1))));
+		}
+	}
+
 	// create partitioning for each target function
 	std::map<std::string, Function*> partitioningFunctions;
 	std::map<std::string, PartitioningGraph*> partitioningGraphs;
@@ -95,6 +168,12 @@ bool Partitioning::runOnModule(Module &M) {
 	// init maximum numbers
 	semNumberMax = 0;
 
+	// read the execution profile, if we should use one
+	ExecutionProfile profile;
+	bool useProfile = false;
+	if (!ProfileFile.empty())
+		useProfile = profile.load(ProfileFile);
+
 	for (std::vector<std::string>::iterator funcIt = targetFunctions.begin(); funcIt != targetFunctions.end(); ++funcIt) {
 		Function *func = M.getFunction(*funcIt);
 
@@ -119,65 +198,99 @@ bool Partitioning::runOnModule(Module &M) {
 		// create partitioning graph
 		PartitioningGraph *pGraph = new PartitioningGraph();
 		pGraph->create(worklist, dependencies);
-		
-		// create partitioning
-		std::string methodsListString;
-		for (std::vector<std::string>::iterator it = partitioningMethods.begin(); it != partitioningMethods.end(); ++it) {
-			std::string pMethod = *it;
-			methodsListString += " " + pMethod;
-			// if the first algorithm that should be executed is an iterative algorithm that needs a starting point,
-			// create an random partitioning before
-			if ((it-partitioningMethods.begin() == 0) && (pMethod == "sa" || pMethod == "k-lin")) {
-				RandomPartitioning rPM;
-				if (pMethod == "k-lin")
-					rPM.balancedBiPartitioning(*pGraph);
-				else
-					rPM.apply(*pGraph, partitioningDevices);
-			}
 
-			if (pMethod == "nop") {
-				partitioningNumbers[functionName] = 1;
-			}
-			else {
-				AbstractPartitioningMethod *PM;
-				
-				if (pMethod == "random")
-					PM = new RandomPartitioning();
-				else if (pMethod == "clustering")
-					PM = new HierarchicalClustering();
-				else if (pMethod == "sa")
-					PM = new SimulatedAnnealing();
-				else if (pMethod == "k-lin")
-					PM = new KernighanLin();
-				else
-					throw std::runtime_error("Invalid partitioning method!");
+		// replace static instruction costs by the measured ones
+		std::map<Instruction*, unsigned int> measuredCycles;
+		if (useProfile && profile.getMeasuredCycles(*func, measuredCycles, ProfileScale))
+			pGraph->setMeasuredExecutionTimes(ProfileDevice, measuredCycles);
+
+		// weight conditional regions by the probabilities of their branches
+		if (!NoBranchWeights) {
+			std::map<BranchInst*, float> profiledBranches;
+			if (useProfile)
+				profile.getBranchProbabilities(*func, profiledBranches);
+			std::map<BasicBlock*, float> blockFrequencies;
+			calcBlockFrequencies(*func, &getAnalysis<LoopInfo>(*func), &getAnalysis<BranchProbabilityInfo>(*func),
+				profiledBranches, blockFrequencies);
+			pGraph->setBlockFrequencies(blockFrequencies);
+		}
+		
+		// export the graph for the standalone partitioner (mehari-partition)
+		if (!GraphExportDir.empty())
+			pGraph->save(GraphExportDir + "/" + functionName + ".pgraph", functionName, partitioningDevices);
 
-				clock_t start = std::clock();
-				partitioningNumbers[functionName] = PM->apply(*pGraph, partitioningDevices);
-				clock_t ends = std::clock();
-				delete PM;
+		// create partitioning or use the one that has been created by mehari-partition
+		std::string methodsListString;
+		unsigned int importedPartitionCount = 0;
+		bool useImportedAssignment = !AssignmentFile.empty()
+			&& pGraph->loadAssignment(AssignmentFile, functionName, importedPartitionCount);
+		if (useImportedAssignment && importedPartitionCount > partitioningDevices.size()) {
+			errs() << "ERROR: The imported partitioning of " << functionName << " uses more partitions than devices!\n";
+			useImportedAssignment = false;
+		}
+		if (useImportedAssignment) {
+			partitioningNumbers[functionName] = importedPartitionCount;
+			methodsListString = " import";
+		}
+		else {
+			if (!AssignmentFile.empty())
+				errs() << "WARNING: No partitioning assignment for " << functionName << " found in " << AssignmentFile << "\n";
+			for (std::vector<std::string>::iterator it = partitioningMethods.begin(); it != partitioningMethods.end(); ++it) {
+				std::string pMethod = *it;
+				methodsListString += " " + pMethod;
+				// if the first algorithm that should be executed is an iterative algorithm that needs a starting point,
+				// create an random partitioning before
+				if (it-partitioningMethods.begin() == 0)
+					createInitialPartitioning(pMethod, *pGraph, partitioningDevices);
+
+				if (pMethod == "nop") {
+					partitioningNumbers[functionName] = 1;
+				}
+				else {
+					AbstractPartitioningMethod *PM = createPartitioningMethod(pMethod);
+					if (PM == NULL)
+						throw std::runtime_error("Invalid partitioning method!");
+
+					clock_t start = std::clock();
+					partitioningNumbers[functionName] = PM->apply(*pGraph, partitioningDevices);
+					clock_t ends = std::clock();
+					delete PM;
+
+					double runtime = (double) (ends - start) / CLOCKS_PER_SEC * 1000;
+					errs() << "Runtime for partitioning " << functionName << " using " << pMethod << ": " 
+						<< format("%4.4f", runtime) << " ms\n";
+				}
 
-				double runtime = (double) (ends - start) / CLOCKS_PER_SEC * 1000;
-				errs() << "Runtime for partitioning " << functionName << " using " << pMethod << ": " 
-					<< format("%4.4f", runtime) << " ms\n";
+				// print partitioning graph results
+				//pGraph->printGraphviz(*func, functionName + "_" + pMethod, GraphOutputDir);
 			}
-
-			// print partitioning graph results
-			//pGraph->printGraphviz(*func, functionName + "_" + pMethod, GraphOutputDir);
 		}
 
 		// print critical path of partitioning graph to evaluate the partitioning result
 		std::ofstream criticalPathFile;
 		std::string criticalPathFileName = OutputDir + "/critical_path.txt";
 		criticalPathFile.open(criticalPathFileName.c_str());
+		criticalPathCosts[functionName] = pGraph->getCriticalPathCost(partitioningDevices);
 		criticalPathFile << "Critical path length for using [" << methodsListString
-		<< " ]: " << pGraph->getCriticalPathCost(partitioningDevices) << "\n";
+		<< " ]: " << criticalPathCosts[functionName] << "\n";
 		criticalPathFile.close();
 
+		// visualize which vertices and edges determine the critical path
+		if (!GraphOutputDir.empty())
+			pGraph->printCriticalityGraphviz(functionName, GraphOutputDir, partitioningDevices);
+
+		// determine the execution order of the vertices in each partition
+		// before the communication calls change the costs of the vertices
+		schedules[functionName] = ListScheduler().schedule(*pGraph, partitioningDevices);
+
 		// handle data and control dependencies between partitions
 		// by adding appropriate function calls
 		handleDependencies(M, *func, *pGraph, dependencies);
 
+		// let a processor partition start the FPGA and collect its results
+		if (HardwareInformation::useSplitPhaseFPGAInvocation())
+			insertSplitPhaseFPGAInvocations(M, *func, *pGraph);
+
 		// save partitioning function and graph
 		partitioningFunctions[functionName] = func;
 		partitioningGraphs[functionName] = pGraph;
@@ -192,6 +305,9 @@ bool Partitioning::runOnModule(Module &M) {
 
 void Partitioning::getAnalysisUsage(AnalysisUsage &AU) const {
 	AU.addRequired<InstructionDependencyAnalysis>();
+	AU.addRequired<BranchProbabilityInfo>();
+	AU.addRequired<LoopInfo>();
+	AU.addRequired<PostDominatorTree>();
 	AU.setPreservesAll();
 }
 
@@ -212,6 +328,233 @@ void Partitioning::parsePartitioningDevices(void) {
 }
 
 
+static void setOperatorLimits(VHDLBackend *backend) {
+	std::vector<std::string> limits;
+	boost::algorithm::split(limits, FPGAOperatorLimits, boost::algorithm::is_any_of(" "), boost::algorithm::token_compress_on);
+	for (std::vector<std::string>::iterator it = limits.begin(); it != limits.end(); ++it) {
+		if (it->empty())
+			continue;
+		size_t pos = it->find('=');
+		if (pos == std::string::npos) {
+			errs() << "ERROR: Invalid operator limit " << *it << " (expected operator=count)\n";
+			continue;
+		}
+		backend->setOperatorLimit(it->substr(0, pos), atoi(it->substr(pos + 1).c_str()));
+	}
+}
+
+
+// the measured probability of the edge, if we have it, else the estimation of LLVM
+static float getEdgeProbability(BasicBlock *BB, BasicBlock *succ, BranchProbabilityInfo *BPI,
+	std::map<BranchInst*, float> &profiledBranches) {
+	BranchInst *bInstr = dyn_cast<BranchInst>(BB->getTerminator());
+	if (bInstr != NULL && contains(profiledBranches, bInstr)) {
+		float probability = 0;
+		if (bInstr->getSuccessor(0) == succ)
+			probability += profiledBranches[bInstr];
+		if (bInstr->getSuccessor(1) == succ)
+			probability += 1 - profiledBranches[bInstr];
+		return probability;
+	}
+	BranchProbability probability = BPI->getEdgeProbability(BB, succ);
+	return (float) probability.getNumerator() / probability.getDenominator();
+}
+
+// Propagates the frequency 1 of start in reverse post-order to the blocks of the loop
+// (or of the function, if loop is NULL). Back edges are not followed; instead, the
+// frequency of the header of an inner loop is multiplied by its number of iterations.
+// Returns the frequency of the back edges to start.
+static float propagateBlockFrequencies(const std::vector<BasicBlock*> &blocks, BasicBlock *start, Loop *loop,
+	LoopInfo *LI, BranchProbabilityInfo *BPI, std::map<BranchInst*, float> &profiledBranches,
+	std::map<BasicBlock*, float> &iterations, std::map<BasicBlock*, float> &frequencies) {
+	float backEdgeFrequency = 0;
+	frequencies[start] = 1.0;
+	for (std::vector<BasicBlock*>::const_iterator bbIt = blocks.begin(); bbIt != blocks.end(); ++bbIt) {
+		BasicBlock *BB = *bbIt;
+		if (loop != NULL && !loop->contains(BB))
+			continue;
+		if (BB != start && contains(iterations, BB))
+			frequencies[BB] *= iterations[BB];
+		float frequency = frequencies[BB];
+
+		std::set<BasicBlock*> successors;
+		TerminatorInst *terminator = BB->getTerminator();
+		for (unsigned int i=0; i<terminator->getNumSuccessors(); i++)
+			successors.insert(terminator->getSuccessor(i));
+		for (std::set<BasicBlock*>::iterator succIt = successors.begin(); succIt != successors.end(); ++succIt) {
+			BasicBlock *succ = *succIt;
+			float edgeFrequency = frequency * getEdgeProbability(BB, succ, BPI, profiledBranches);
+			if (loop != NULL && succ == start) {
+				backEdgeFrequency += edgeFrequency;
+				continue;
+			}
+			if (loop != NULL && !loop->contains(succ))
+				continue;
+			// the iterations of an inner loop are in the frequency of its header
+			Loop *succLoop = LI->getLoopFor(succ);
+			if (succLoop != NULL && succLoop->getHeader() == succ && succLoop->contains(BB))
+				continue;
+			frequencies[succ] += edgeFrequency;
+		}
+	}
+	return backEdgeFrequency;
+}
+
+// Sets the iterations of the loop and its inner loops (the inner loops first).
+static void calcLoopIterations(Loop *loop, const std::vector<BasicBlock*> &blocks,
+	LoopInfo *LI, BranchProbabilityInfo *BPI, std::map<BranchInst*, float> &profiledBranches,
+	std::map<BasicBlock*, float> &iterations) {
+	for (Loop::iterator subLoopIt = loop->begin(); subLoopIt != loop->end(); ++subLoopIt)
+		calcLoopIterations(*subLoopIt, blocks, LI, BPI, profiledBranches, iterations);
+
+	// the probability to stay in the loop must be less than 1, so we limit the iterations
+	const float maxContinueProbability = 1 - 1.0f / (1<<20);
+	std::map<BasicBlock*, float> frequencies;
+	float continueProbability = propagateBlockFrequencies(blocks, loop->getHeader(), loop,
+		LI, BPI, profiledBranches, iterations, frequencies);
+	iterations[loop->getHeader()] = 1 / (1 - std::min(continueProbability, maxContinueProbability));
+}
+
+void Partitioning::calcBlockFrequencies(Function &F, LoopInfo *LI, BranchProbabilityInfo *BPI,
+	std::map<BranchInst*, float> &profiledBranches, std::map<BasicBlock*, float> &frequencies) {
+	// propagate the execution frequency from the entry block (frequency 1) to all other blocks
+	// use the measured branch probabilities if we have them, else the estimation of LLVM
+	// The frequency of a loop header is the frequency of the edges that enter the loop times
+	// its iterations, which we get from the probability of the back edges (Wu and Larus).
+	ReversePostOrderTraversal<Function*> RPOT(&F);
+	std::vector<BasicBlock*> blocks(RPOT.begin(), RPOT.end());
+
+	std::map<BasicBlock*, float> iterations;
+	for (LoopInfo::iterator loopIt = LI->begin(); loopIt != LI->end(); ++loopIt)
+		calcLoopIterations(*loopIt, blocks, LI, BPI, profiledBranches, iterations);
+
+	propagateBlockFrequencies(blocks, &F.getEntryBlock(), NULL, LI, BPI, profiledBranches, iterations, frequencies);
+}
+
+
+unsigned int Partitioning::getMessageWords(Type *type) {
+	unsigned int bits = type->getPrimitiveSizeInBits();
+	return std::max(1u, (bits + 31) / 32);
+}
+
+std::vector<unsigned int> Partitioning::splitMessage(const std::vector<Type*> &types, unsigned int channelWords) {
+	std::vector<unsigned int> partSizes;
+	unsigned int words = 0;
+	for (std::vector<Type*>::const_iterator it = types.begin(); it != types.end(); ++it) {
+		unsigned int valueWords = getMessageWords(*it);
+		if (partSizes.empty() || words + valueWords > channelWords) {
+			// a value that doesn't fit into an empty channel gets a message of its own
+			partSizes.push_back(0);
+			words = 0;
+		}
+		partSizes.back()++;
+		words += valueWords;
+	}
+	return partSizes;
+}
+
+
+// the value that is replaced by the result of a get call (see handleDependencies), NULL for other instructions
+static Value *getReceivedValue(Instruction *instr) {
+	MDNode *node = instr->getMetadata("targetop");
+	if (node == NULL)
+		return NULL;
+	std::string address = cast<MDString>(node->getOperand(0))->getString();
+	std::stringstream ss(address.substr(2));
+	size_t pointer = 0;
+	ss >> std::hex >> pointer;
+	return reinterpret_cast<Value*>(pointer);
+}
+
+
+std::vector<Partitioning::DependencyTransfer> Partitioning::collectTransfers(PartitioningGraph &pGraph,
+	InstructionDependencyList &dependencies, const std::vector<DeviceInformation::DeviceType> &deviceTypes,
+	const std::vector<unsigned int> &positionInSchedule) {
+	// precompute the vertex of each instruction and its position in the vertex
+	std::map<Instruction*, PartitioningGraph::VertexDescriptor> vertexOfInstruction;
+	std::map<Instruction*, unsigned int> positionInVertex;
+	for (unsigned int vd=0; vd<pGraph.getVertexCount(); vd++) {
+		std::vector<Instruction*> &instructions = pGraph.getInstructions(vd);
+		for (unsigned int i=0; i<instructions.size(); i++) {
+			vertexOfInstruction[instructions[i]] = vd;
+			positionInVertex[instructions[i]] = i;
+		}
+	}
+
+	// (producer, target partition, semaphore, target instruction for data of load/store instructions)
+	typedef boost::tuple<Instruction*, unsigned int, bool, Instruction*> TransferKey;
+
+	// each value is sent only once to each partition that uses it,
+	// so the receiving call has to be placed before the first use in the partition
+	std::vector<DependencyTransfer> transfers;
+	std::map<TransferKey, unsigned int> transferIndices;
+	for (InstructionDependencyList::iterator listIt = dependencies.begin(); listIt != dependencies.end(); ++listIt) {
+		Instruction *tgtInstr = listIt->tgtInstruction;
+		std::map<Instruction*, PartitioningGraph::VertexDescriptor>::iterator tgtIt = vertexOfInstruction.find(tgtInstr);
+		if (tgtIt == vertexOfInstruction.end())
+			// the instruction is not part of the Graph -> continue with the next instruction
+			continue;
+		PartitioningGraph::VertexDescriptor instrVertex = tgtIt->second;
+		unsigned int tgtPartition = pGraph.getPartition(instrVertex);
+
+		for (std::vector<InstructionDependency>::iterator depValIt = listIt->dependencies.begin(); depValIt != listIt->dependencies.end(); ++depValIt) {
+			Instruction *depInstr = depValIt->depInstruction;
+			std::map<Instruction*, PartitioningGraph::VertexDescriptor>::iterator depIt = vertexOfInstruction.find(depInstr);
+			if (depIt == vertexOfInstruction.end())
+				// the dependency is not part of the Graph -> continue with the next instruction
+				continue;
+			PartitioningGraph::VertexDescriptor depVertex = depIt->second;
+			unsigned int srcPartition = pGraph.getPartition(depVertex);
+			if (srcPartition == tgtPartition)
+				continue;
+
+			// determine whether to use mboxes or semaphores
+			// currently we do not use semaphores for the communication with the FPGA, only for control flow
+			// so we use data dependency methods every time we communicate with the FPGA
+			// or we communicate between two processor cores and the current dependency is a register dependency
+			DeviceInformation::DeviceType t1 = deviceTypes[tgtPartition], t2 = deviceTypes[srcPartition];
+			bool useSemaphores;
+			if (useDataDepForAllFPGACom)
+				useSemaphores = depValIt->isCtrlDep
+				|| (t1 != DeviceInformation::FPGA_RECONOS && t2 != DeviceInformation::FPGA_RECONOS && depValIt->isMemDep);
+			else
+				useSemaphores = depValIt->isCtrlDep || depValIt->isMemDep;
+
+			// the data of a load/store (void) instruction replaces the loaded value of the target instruction,
+			// so we need a separate transfer for each target
+			bool isVoidInstr = depInstr->getType()->isVoidTy();
+			TransferKey key(depInstr, tgtPartition, useSemaphores, 
+				(isVoidInstr && !useSemaphores) ? tgtInstr : NULL);
+
+			std::map<TransferKey, unsigned int>::iterator transferIt = transferIndices.find(key);
+			if (transferIt == transferIndices.end()) {
+				DependencyTransfer transfer;
+				transfer.depInstr = depInstr;
+				transfer.depVertex = depVertex;
+				transfer.tgtInstr = tgtInstr;
+				transfer.tgtVertex = instrVertex;
+				transfer.depPosition = positionInVertex[depInstr];
+				transfer.tgtPosition = positionInVertex[tgtInstr];
+				transfer.useSemaphores = useSemaphores;
+				transferIndices[key] = transfers.size();
+				transfers.push_back(transfer);
+			}
+			else {
+				// use the first target in the execution order of the partition
+				DependencyTransfer &transfer = transfers[transferIt->second];
+				unsigned int oldPos = positionInSchedule[transfer.tgtVertex], newPos = positionInSchedule[instrVertex];
+				if (newPos < oldPos || (newPos == oldPos && positionInVertex[tgtInstr] < transfer.tgtPosition)) {
+					transfer.tgtInstr = tgtInstr;
+					transfer.tgtVertex = instrVertex;
+					transfer.tgtPosition = positionInVertex[tgtInstr];
+				}
+			}
+		}
+	}
+	return transfers;
+}
+
+
 void Partitioning::handleDependencies(Module &M, Function &F, PartitioningGraph &pGraph, InstructionDependencyList &dependencies) {
 	// create new functions to put or get data dependencies
 	Function *newGetFloatFunc = cast<Function>(
@@ -249,6 +592,19 @@ void Partitioning::handleDependencies(Module &M, Function &F, PartitioningGraph
 			Type::getInt1Ty(M.getContext()),
 			(Type *)0));
 
+	// ring buffers and semaphores of the runtime for communication between two processors (see runtime/mehari_channel.h)
+	bool useRingBuffers = HardwareInformation::useRingBuffersForCPUs();
+	Function *ringGetFloatFunc = NULL, *ringGetIntFunc = NULL, *ringGetBoolFunc = NULL;
+	Function *ringPutFloatFunc = NULL, *ringPutIntFunc = NULL, *ringPutBoolFunc = NULL;
+	if (useRingBuffers) {
+		ringGetFloatFunc = cast<Function>(M.getOrInsertFunction("_ring_get_real", newGetFloatFunc->getFunctionType()));
+		ringGetIntFunc   = cast<Function>(M.getOrInsertFunction("_ring_get_int",  newGetIntFunc->getFunctionType()));
+		ringGetBoolFunc  = cast<Function>(M.getOrInsertFunction("_ring_get_bool", newGetBoolFunc->getFunctionType()));
+		ringPutFloatFunc = cast<Function>(M.getOrInsertFunction("_ring_put_real", newPutFloatFunc->getFunctionType()));
+		ringPutIntFunc   = cast<Function>(M.getOrInsertFunction("_ring_put_int",  newPutIntFunc->getFunctionType()));
+		ringPutBoolFunc  = cast<Function>(M.getOrInsertFunction("_ring_put_bool", newPutBoolFunc->getFunctionType()));
+	}
+
 	// create new functions to handle semaphores
 	Function *newSemWaitFunc = cast<Function>(
 		M.getOrInsertFunction("_sem_wait",
@@ -260,178 +616,786 @@ void Partitioning::handleDependencies(Module &M, Function &F, PartitioningGraph
 			Type::getVoidTy(M.getContext()),
 			Type::getInt32Ty(M.getContext()), 
 			(Type *)0));
+	Function *ringSemWaitFunc = NULL, *ringSemPostFunc = NULL;
+	if (useRingBuffers) {
+		ringSemWaitFunc = cast<Function>(M.getOrInsertFunction("_ring_sem_wait", newSemWaitFunc->getFunctionType()));
+		ringSemPostFunc = cast<Function>(M.getOrInsertFunction("_ring_sem_post", newSemPostFunc->getFunctionType()));
+	}
 
 	// reset counting semaphore uses (semaphores are reused in each partitioned function)
 	// start counting at one, because semaphore 0 is used for return control
-	unsigned int semNumber = 1;
+	const unsigned int firstSemNumber = 1;
+	unsigned int semNumber = firstSemNumber;
+
+	// precompute the vertices with branches, the device type and the execution order of each partition
+	unsigned int vertexCount = pGraph.getVertexCount();
+	std::vector<bool> vertexContainsBranch(vertexCount, false);
+	for (unsigned int vd=0; vd<vertexCount; vd++) {
+		std::vector<Instruction*> &instructions = pGraph.getInstructions(vd);
+		for (std::vector<Instruction*>::iterator it = instructions.begin(); it != instructions.end(); ++it)
+			if (isa<BranchInst>(*it))
+				vertexContainsBranch[vd] = true;
+	}
 
-	// loop over dependencies and insert appropriate function calls to handle dependencies between partitions
-	for (InstructionDependencyList::iterator listIt = dependencies.begin(); listIt != dependencies.end(); ++listIt) {
-		InstructionDependencyEntry depEntry = *listIt;
-		Instruction *tgtInstr = depEntry.tgtInstruction;
-		std::vector<InstructionDependency> instrDep = depEntry.dependencies;
-		PartitioningGraph::VertexDescriptor instrVertex = pGraph.getVertexForInstruction(tgtInstr);
-		if (instrVertex == NO_SUCH_VERTEX)
-			// the instruction is not part of the Graph -> continue with the next instruction
-			continue;
-		for (std::vector<InstructionDependency>::iterator depValIt = instrDep.begin(); depValIt != instrDep.end(); ++depValIt) {
-			Instruction *depInstr = depValIt->depInstruction;
+	HardwareInformation hInfo;
+	std::vector<DeviceInformation::DeviceType> deviceTypes;
+	for (std::vector<std::string>::iterator it = partitioningDevices.begin(); it != partitioningDevices.end(); ++it)
+		deviceTypes.push_back(hInfo.getDeviceInfo(*it)->getType());
+
+	// position of each vertex in the execution order of its partition
+	std::vector<unsigned int> positionInSchedule(vertexCount, 0);
+	std::vector<std::vector<PartitioningGraph::VertexDescriptor> > &partitionOrders = schedules[F.getName().str()].partitionOrders;
+	for (unsigned int p=0; p<partitionOrders.size(); p++)
+		for (unsigned int i=0; i<partitionOrders[p].size(); i++)
+			positionInSchedule[partitionOrders[p][i]] = i;
+
+	std::vector<DependencyTransfer> transfers = collectTransfers(pGraph, dependencies, deviceTypes, positionInSchedule);
+
+	// coalesce data transfers between the same pair of partitions into multi-word messages:
+	// the values are sent one after another over the same mailbox after the last of them is available,
+	// the sender must not wait for data between the producers, otherwise we could create a deadlock
+	std::vector<std::vector<unsigned int> > messages;
+	std::vector<bool> isInMessage(transfers.size(), false);
+	if (!NoMessageCoalescing) {
+		std::vector<bool> isReceivingVertex(vertexCount, false);
+		std::vector<std::vector<unsigned int> > transfersOfVertex(vertexCount);
+		for (unsigned int i=0; i<transfers.size(); i++) {
+			isReceivingVertex[transfers[i].tgtVertex] = true;
+			if (!transfers[i].useSemaphores && !transfers[i].depInstr->getType()->isVoidTy())
+				transfersOfVertex[transfers[i].depVertex].push_back(i);
+		}
+
+		for (unsigned int p=0; p<partitionOrders.size(); p++) {
+			// open message for each target partition and type
+			std::map<std::pair<unsigned int, Type*>, unsigned int> openMessages;
+			for (std::vector<PartitioningGraph::VertexDescriptor>::iterator vIt = partitionOrders[p].begin(); vIt != partitionOrders[p].end(); ++vIt) {
+				if (isReceivingVertex[*vIt])
+					openMessages.clear();
+				std::vector<unsigned int> &vertexTransfers = transfersOfVertex[*vIt];
+				for (std::vector<unsigned int>::iterator it = vertexTransfers.begin(); it != vertexTransfers.end(); ++it) {
+					DependencyTransfer &transfer = transfers[*it];
+					std::pair<unsigned int, Type*> key(pGraph.getPartition(transfer.tgtVertex), transfer.depInstr->getType());
+					std::map<std::pair<unsigned int, Type*>, unsigned int>::iterator msgIt = openMessages.find(key);
+					if (msgIt == openMessages.end()) {
+						msgIt = openMessages.insert(std::make_pair(key, messages.size())).first;
+						messages.push_back(std::vector<unsigned int>());
+					}
+					messages[msgIt->second].push_back(*it);
+					isInMessage[*it] = true;
+				}
+			}
+		}
+	}
+	// A message must fit into its channel: the sender must not block in the middle of a message
+	// while the receiver waits for another message of the same sender, so we split larger ones.
+	std::vector<std::vector<unsigned int> > splitMessages;
+	for (std::vector<std::vector<unsigned int> >::iterator msgIt = messages.begin(); msgIt != messages.end(); ++msgIt) {
+		std::vector<Type*> types;
+		for (std::vector<unsigned int>::iterator it = msgIt->begin(); it != msgIt->end(); ++it)
+			types.push_back(transfers[*it].depInstr->getType());
+		std::vector<unsigned int> partSizes = splitMessage(types, ChannelWords);
+		std::vector<unsigned int>::iterator partBegin = msgIt->begin();
+		for (std::vector<unsigned int>::iterator sizeIt = partSizes.begin(); sizeIt != partSizes.end(); ++sizeIt) {
+			splitMessages.push_back(std::vector<unsigned int>(partBegin, partBegin + *sizeIt));
+			partBegin += *sizeIt;
+		}
+	}
+	messages.swap(splitMessages);
+
+	// all other transfers are sent on their own
+	for (unsigned int i=0; i<transfers.size(); i++)
+		if (!isInMessage[i])
+			messages.push_back(std::vector<unsigned int>(1, i));
+
+	// calls that have to be inserted before/after an instruction of a vertex
+	std::map<Instruction*, std::vector<Instruction*> > insertBefore, insertAfter;
+	std::set<PartitioningGraph::VertexDescriptor> modifiedVertices;
+	std::set<Instruction*> movableCalls;
+
+	// add function calls to handle dependencies between partitions
+	for (std::vector<std::vector<unsigned int> >::iterator msgIt = messages.begin(); msgIt != messages.end(); ++msgIt) {
+		// send the message after the last producer and receive it before the first user
+		DependencyTransfer *sendPoint = &transfers[msgIt->front()], *receivePoint = &transfers[msgIt->front()];
+		for (std::vector<unsigned int>::iterator it = msgIt->begin(); it != msgIt->end(); ++it) {
+			DependencyTransfer &transfer = transfers[*it];
+			unsigned int depPos = positionInSchedule[transfer.depVertex], sendPos = positionInSchedule[sendPoint->depVertex];
+			if (depPos > sendPos || (depPos == sendPos && transfer.depPosition > sendPoint->depPosition))
+				sendPoint = &transfer;
+			unsigned int tgtPos = positionInSchedule[transfer.tgtVertex], receivePos = positionInSchedule[receivePoint->tgtVertex];
+			if (tgtPos < receivePos || (tgtPos == receivePos && transfer.tgtPosition < receivePoint->tgtPosition))
+				receivePoint = &transfer;
+		}
+
+		// insert get: if we are inside an if statement we should insert the get method 
+		// at the beginning of the statement, otherwise we can insert it directly before the target instruction
+		PartitioningGraph::VertexDescriptor getVertex = receivePoint->tgtVertex;
+		Instruction *getTarget = receivePoint->tgtInstr;
+		if (vertexContainsBranch[getVertex])
+			getTarget = pGraph.getInstructions(getVertex).front();
+
+		// insert put: if we are inside an if statement we should insert the put method 
+		// at the end of the statement, otherwise we can insert it directly after the dependency instruction
+		PartitioningGraph::VertexDescriptor putVertex = sendPoint->depVertex;
+		Instruction *putTarget = sendPoint->depInstr;
+		if (vertexContainsBranch[putVertex])
+			putTarget = pGraph.getInstructions(putVertex).back();
+
+		// messages and semaphores between two processors can use the ring buffers of the runtime
+		bool betweenProcessors = deviceTypes[pGraph.getPartition(getVertex)] == DeviceInformation::CPU_LINUX
+			&& deviceTypes[pGraph.getPartition(putVertex)] == DeviceInformation::CPU_LINUX;
+		bool useRing = useRingBuffers && betweenProcessors;
+
+		// create dependency and semaphore number (shared by all values of the message)
+		Value *depNumberVal = ConstantInt::get(Type::getInt32Ty(M.getContext()), depNumber);
+		Value *semNumberVal = ConstantInt::get(Type::getInt32Ty(M.getContext()), semNumber);
+		bool depNumberUsed = false;
+		bool semNumberUsed = false;
+
+		// the data calls between two processors may be moved to hide the latency of the communication
+		std::vector<Type*> messageTypes;
+		for (std::vector<unsigned int>::iterator it = msgIt->begin(); it != msgIt->end(); ++it) {
+			Instruction *depInstr = transfers[*it].depInstr;
+			messageTypes.push_back(depInstr->getType()->isVoidTy() ? depInstr->getOperand(0)->getType() : depInstr->getType());
+		}
+		bool isMovable = betweenProcessors && isMovableMessage(messageTypes, ChannelWords);
+
+		for (std::vector<unsigned int>::iterator it = msgIt->begin(); it != msgIt->end(); ++it) {
+			DependencyTransfer &transfer = transfers[*it];
+			Instruction *depInstr = transfer.depInstr;
+			Instruction *tgtInstr = transfer.tgtInstr;
 			Type *instrType = depInstr->getType();
-			PartitioningGraph::VertexDescriptor depVertex = pGraph.getVertexForInstruction(depInstr);
-			bool depNumberUsed = false;
-			bool semNumberUsed = false;
-			if (depVertex == NO_SUCH_VERTEX)
-				// the dependency is not part of the Graph -> continue with the next instruction
-				continue;
-			if (pGraph.getPartition(instrVertex) != pGraph.getPartition(depVertex)) {				
-				// create dependency and semaphore number
-				Value *depNumberVal = ConstantInt::get(Type::getInt32Ty(M.getContext()), depNumber);
-				Value *semNumberVal = ConstantInt::get(Type::getInt32Ty(M.getContext()), semNumber);
-
-				// determine partition hardware types
-				HardwareInformation hInfo;
-				DeviceInformation::DeviceType t1, t2;
-				t1 =hInfo.getDeviceInfo(
-					partitioningDevices[pGraph.getPartition(instrVertex)])->getType();
-				t2 =hInfo.getDeviceInfo(
-					partitioningDevices[pGraph.getPartition(depVertex)])->getType();
-
-				// determine whether to use mboxes or semaphores
-				// currently we do not use semaphores for the communication with the FPGA, only for control flow
-				// so we use data dependency methods every time we communicate with the FPGA
-				// or we communicate between two processor cores and the current dependency is a register dependency
-				bool useSemaphores;
-				if (useDataDepForAllFPGACom)
-					useSemaphores = depValIt->isCtrlDep
-					|| (t1 != DeviceInformation::FPGA_RECONOS && t2 != DeviceInformation::FPGA_RECONOS && depValIt->isMemDep);
-				else
-					useSemaphores = depValIt->isCtrlDep || depValIt->isMemDep;
 
-				// determine whether we handle a calculation instruction (return type int/real) or a load/store instruction (void)
-				bool isVoidInstr = instrType->isVoidTy();
-				Type *operandType = NULL;
+			// determine whether we handle a calculation instruction (return type int/real) or a load/store instruction (void)
+			bool isVoidInstr = instrType->isVoidTy();
+			Type *valueType = (isVoidInstr ? depInstr->getOperand(0)->getType() : instrType);
+
+			CallInst *getInstr = NULL, *putInstr = NULL;
+			if (transfer.useSemaphores) {
+				getInstr = CallInst::Create(useRing ? ringSemWaitFunc : newSemWaitFunc, semNumberVal);
+				putInstr = CallInst::Create(useRing ? ringSemPostFunc : newSemPostFunc, semNumberVal);
+				semNumberUsed = true;
+			}
+			else { // we use data dependencies
+				std::vector<Value*> params;
+				params.push_back(depNumberVal);
+				// for load/store add the operand to the parameter list, else we can use the instruction itself
 				if (isVoidInstr)
-					operandType = depInstr->getOperand(0)->getType();
-
-				// add function calls to handle dependencies between partitions
-				std::vector<Instruction*> tgtInstrList = pGraph.getInstructions(instrVertex);
-				std::vector<Instruction*>::iterator instrIt = std::find(tgtInstrList.begin(), tgtInstrList.end(), tgtInstr);
-				if (instrIt != tgtInstrList.end()) {
-					CallInst *newInstr;
-					// create the new function depending on the target hardware and the communication type
-					if (useSemaphores) {
-						newInstr = CallInst::Create(newSemWaitFunc, semNumberVal);
-						semNumberUsed = true;
+					params.push_back(depInstr->getOperand(0));
+				else
+					params.push_back(depInstr);
+
+				std::string dataType;
+				if (valueType->isIntegerTy()) {
+					if (valueType->getIntegerBitWidth() == 1) {
+						getInstr = CallInst::Create(useRing ? ringGetBoolFunc : newGetBoolFunc, depNumberVal, "data");
+						putInstr = CallInst::Create(useRing ? ringPutBoolFunc : newPutBoolFunc, params);
 					}
-					else { // we use data dependencies
-						if (instrType->isIntegerTy() || (isVoidInstr && operandType->isIntegerTy())) {
-							if (instrType->getIntegerBitWidth() == 1)
-								newInstr = CallInst::Create(newGetBoolFunc, depNumberVal, "data");
-							else
-								newInstr = CallInst::Create(newGetIntFunc, depNumberVal, "data");
-							dataDependencies.push_back("IntT");
-						}
-						else if (instrType->isFloatingPointTy() || (isVoidInstr && operandType->isFloatingPointTy())) {
-							newInstr = CallInst::Create(newGetFloatFunc, depNumberVal, "data");
-							dataDependencies.push_back("RealT");
-						}
-						else {
-							errs() 	<< "ERROR: unhandled type while using get_data: TypeID "
-									<< instrType->getTypeID() << "\n";
-							errs() << "Instruction: " << *depInstr << "\n";
-							continue;
-						}
-						depNumberUsed = true;
+					else {
+						getInstr = CallInst::Create(useRing ? ringGetIntFunc : newGetIntFunc, depNumberVal, "data");
+						putInstr = CallInst::Create(useRing ? ringPutIntFunc : newPutIntFunc, params);
 					}
-					// add metadata to specify the target operand for the get_data call
-					// for load/store add the operand to the metadata, else we can use the instruction itself
-					std::stringstream ss;
-					if(isVoidInstr)
-						ss << tgtInstr;
-					else
-						ss << depInstr;
-					LLVMContext &context = tgtInstr->getContext();
-					MDNode* mdn = MDNode::get(context, MDString::get(context, ss.str()));
-					newInstr->setMetadata("targetop", mdn);
-					
-					// insert instruction: if we are inside an if statement we should insert the get method 
-					// at the beginning of the statement, otherwise we can insert it directly before the target instruction
-					std::vector<Instruction*>::iterator insertTarget = instrIt;
-					bool containsBranch = false;
-					for (std::vector<Instruction*>::iterator it = tgtInstrList.begin(); it != tgtInstrList.end(); ++it)
-						if (isa<BranchInst>(*it)) 
-							containsBranch = true;
-					if (containsBranch)
-						insertTarget = tgtInstrList.begin();
-
-					// add instruction to function
-					Instruction *tgt = *insertTarget;
-					tgt->getParent()->getInstList().insert(tgt, newInstr);
-					// add instruction to vertex instruction list
-					tgtInstrList.insert(insertTarget, newInstr);
-					pGraph.setInstructions(instrVertex, tgtInstrList);
+					dataType = "IntT";
 				}
+				else if (valueType->isFloatingPointTy()) {
+					getInstr = CallInst::Create(useRing ? ringGetFloatFunc : newGetFloatFunc, depNumberVal, "data");
+					putInstr = CallInst::Create(useRing ? ringPutFloatFunc : newPutFloatFunc, params);
+					dataType = "RealT";
+				}
+				else {
+					errs() 	<< "ERROR: unhandled type while using get_data: TypeID "
+							<< valueType->getTypeID() << "\n";
+					errs() << "Instruction: " << *depInstr << "\n";
+					continue;
+				}
+				// all values of a message have the same type
+				if (!depNumberUsed)
+					dataDependencies.push_back(dataType);
+				depNumberUsed = true;
+
+				// add metadata to specify the target operand for the get_data call
+				// for load/store add the operand to the metadata, else we can use the instruction itself
+				std::stringstream ss;
+				if(isVoidInstr)
+					ss << tgtInstr;
+				else
+					ss << depInstr;
+				LLVMContext &context = tgtInstr->getContext();
+				MDNode* mdn = MDNode::get(context, MDString::get(context, ss.str()));
+				getInstr->setMetadata("targetop", mdn);
+			}
+
+			// the calls of a message keep their order
+			getTarget->getParent()->getInstList().insert(getTarget, getInstr);
+			insertBefore[getTarget].push_back(getInstr);
+			modifiedVertices.insert(getVertex);
+
+			std::vector<Instruction*> &putsAfterTarget = insertAfter[putTarget];
+			Instruction *putPosition = (putsAfterTarget.empty() ? putTarget : putsAfterTarget.back());
+			putPosition->getParent()->getInstList().insertAfter(putPosition, putInstr);
+			putsAfterTarget.push_back(putInstr);
+			modifiedVertices.insert(putVertex);
 
-				std::vector<Instruction*> depInstrList = pGraph.getInstructions(depVertex);
-				std::vector<Instruction*>::iterator depIt = std::find(depInstrList.begin(), depInstrList.end(), depInstr);
-				if (depIt != tgtInstrList.end()) {
-					CallInst *newInstr;
-					if (useSemaphores) {
-						newInstr = CallInst::Create(newSemPostFunc, semNumberVal);
-						semNumberUsed = true;
+			if (isMovable && !transfer.useSemaphores) {
+				movableCalls.insert(getInstr);
+				movableCalls.insert(putInstr);
+			}
+		}
+
+		if (depNumberUsed)
+			depNumber++;
+		if (semNumberUsed)
+			semNumber++;
+	}
+
+	// add the new calls to the instruction lists of the vertices
+	for (std::set<PartitioningGraph::VertexDescriptor>::iterator vIt = modifiedVertices.begin(); vIt != modifiedVertices.end(); ++vIt) {
+		std::vector<Instruction*> &instructions = pGraph.getInstructions(*vIt);
+		std::vector<Instruction*> newInstructions;
+		for (std::vector<Instruction*>::iterator it = instructions.begin(); it != instructions.end(); ++it) {
+			std::map<Instruction*, std::vector<Instruction*> >::iterator beforeIt = insertBefore.find(*it);
+			if (beforeIt != insertBefore.end())
+				newInstructions.insert(newInstructions.end(), beforeIt->second.begin(), beforeIt->second.end());
+			newInstructions.push_back(*it);
+			std::map<Instruction*, std::vector<Instruction*> >::iterator afterIt = insertAfter.find(*it);
+			if (afterIt != insertAfter.end())
+				newInstructions.insert(newInstructions.end(), afterIt->second.begin(), afterIt->second.end());
+		}
+		pGraph.setInstructions(*vIt, newInstructions);
+	}
+
+	// receive the data as late and send it as early as possible
+	// (before the semaphores are removed, because this changes the ordering of the partitions)
+	if (!NoLatencyHiding)
+		hideCommunicationLatency(F, pGraph, movableCalls);
+
+	// remove semaphores whose ordering is already guaranteed by other communication
+	if (!KeepRedundantSemaphores)
+		semNumber = removeRedundantSemaphores(F, pGraph, firstSemNumber, semNumber);
+
+	// set maximum number of semaphore counts
+	semNumberMax = std::max(semNumberMax, semNumber);
+}
+
+
+namespace {
+	// communication between two partitions: everything before the sending call
+	// happens before everything after the receiving call
+	struct SynchronizationEdge {
+		CallInst *sendInstr, *receiveInstr;
+		unsigned int srcPartition, srcPosition, tgtPartition, tgtPosition;
+		bool isSemaphore, isAlwaysExecuted, isRemoved;
+	};
+
+	unsigned int getCommunicationNumber(CallInst *call) {
+		return cast<ConstantInt>(call->getArgOperand(0))->getZExtValue();
+	}
+
+	bool isSemaphoreCall(CallInst *call) {
+		std::string name = call->getCalledFunction()->getName().str();
+		return name == "_sem_post" || name == "_ring_sem_post" || name == "_sem_wait" || name == "_ring_sem_wait";
+	}
+}
+
+
+std::set<unsigned int> Partitioning::findRedundantSemaphores(Function &F, PostDominatorTree &PDT,
+	const std::vector<std::vector<Instruction*> > &executionOrders, const std::vector<bool> &isSequential) {
+	// only calls in blocks that are executed in every run can be used to imply an ordering
+	BasicBlock *entryBlock = &F.getEntryBlock();
+	unsigned int partitionCount = executionOrders.size();
+
+	// find the communication calls and their position in the execution order of their partition
+	// (the k-th put of a dependency number belongs to the k-th get, each semaphore is used once)
+	std::map<CallInst*, std::pair<unsigned int, unsigned int> > positions;
+	std::map<unsigned int, std::vector<CallInst*> > puts, gets, posts, waits;
+	for (unsigned int p=0; p<partitionCount; p++) {
+		for (unsigned int position=0; position<executionOrders[p].size(); position++) {
+			CallInst *call = dyn_cast<CallInst>(executionOrders[p][position]);
+			if (call == NULL || call->getCalledFunction() == NULL)
+				continue;
+			std::string name = call->getCalledFunction()->getName().str();
+			if (name == "_sem_post" || name == "_ring_sem_post")
+				posts[getCommunicationNumber(call)].push_back(call);
+			else if (name == "_sem_wait" || name == "_ring_sem_wait")
+				waits[getCommunicationNumber(call)].push_back(call);
+			else if (boost::starts_with(name, "_put_") || boost::starts_with(name, "_ring_put_"))
+				puts[getCommunicationNumber(call)].push_back(call);
+			else if (boost::starts_with(name, "_get_") || boost::starts_with(name, "_ring_get_"))
+				gets[getCommunicationNumber(call)].push_back(call);
+			else
+				continue;
+			positions[call] = std::make_pair(p, position);
+		}
+	}
+
+	// create the happens-before edges between the partitions
+	std::vector<SynchronizationEdge> edges;
+	for (int semaphore=0; semaphore<2; semaphore++) {
+		std::map<unsigned int, std::vector<CallInst*> > &sends = (semaphore ? posts : puts), &receives = (semaphore ? waits : gets);
+		for (std::map<unsigned int, std::vector<CallInst*> >::iterator it = sends.begin(); it != sends.end(); ++it) {
+			std::vector<CallInst*> &receiveCalls = receives[it->first];
+			for (unsigned int k=0; k<it->second.size() && k<receiveCalls.size(); k++) {
+				SynchronizationEdge edge;
+				edge.sendInstr = it->second[k];
+				edge.receiveInstr = receiveCalls[k];
+				boost::tie(edge.srcPartition, edge.srcPosition) = positions[edge.sendInstr];
+				boost::tie(edge.tgtPartition, edge.tgtPosition) = positions[edge.receiveInstr];
+				edge.isSemaphore = semaphore;
+				edge.isAlwaysExecuted = PDT.dominates(edge.sendInstr->getParent(), entryBlock) 
+					&& PDT.dominates(edge.receiveInstr->getParent(), entryBlock);
+				edge.isRemoved = false;
+				// the FPGA does not execute its operations in program order,
+				// so we cannot use it to build a chain of synchronizations
+				if (!isSequential[edge.srcPartition] || !isSequential[edge.tgtPartition])
+					edge.isAlwaysExecuted = false;
+				edges.push_back(edge);
+			}
+		}
+	}
+
+	// transitive reduction: a semaphore can be removed if its receiving call is reached
+	// from its sending call by a chain of the remaining edges and the program order of the partitions
+	std::set<unsigned int> redundantSemaphores;
+	for (std::vector<SynchronizationEdge>::iterator edgeIt = edges.begin(); edgeIt != edges.end(); ++edgeIt) {
+		if (!edgeIt->isSemaphore)
+			continue;
+
+		if (isSequential[edgeIt->srcPartition] && isSequential[edgeIt->tgtPartition]) {
+			// earliest position in each partition that is known to happen after the sending call
+			std::vector<unsigned int> reached(partitionCount, UINT_MAX);
+			reached[edgeIt->srcPartition] = edgeIt->srcPosition;
+			bool changed = true;
+			while (changed) {
+				changed = false;
+				for (std::vector<SynchronizationEdge>::iterator it = edges.begin(); it != edges.end(); ++it) {
+					if (it == edgeIt || it->isRemoved || !it->isAlwaysExecuted)
+						continue;
+					if (reached[it->srcPartition] <= it->srcPosition && it->tgtPosition < reached[it->tgtPartition]) {
+						reached[it->tgtPartition] = it->tgtPosition;
+						changed = true;
 					}
-					else { // we use data dependencies
-						std::vector<Value*> params;
-						params.push_back(depNumberVal);
-						// for load/store add the operand to the parameter list, else we can use the instruction itself
-						if (isVoidInstr)
-							params.push_back(depInstr->getOperand(0));
-						else
-							params.push_back(depInstr);
-						if (instrType->isIntegerTy() || (isVoidInstr && operandType->isIntegerTy())) {
-							if (instrType->getIntegerBitWidth() == 1)
-								newInstr = CallInst::Create(newPutBoolFunc, params);
-							else
-								newInstr = CallInst::Create(newPutIntFunc, params);
-						}
-						else if (instrType->isFloatingPointTy() || (isVoidInstr && operandType->isFloatingPointTy())) {
-							newInstr = CallInst::Create(newPutFloatFunc, params);
-						}
-						else {
-							errs() 	<< "ERROR: unhandled type while using put_data: TypeID "
-									<< instrType->getTypeID() << "\n";
-							errs() << "Instruction: " << *depInstr << "\n";
-							continue;
-						}
-						depNumberUsed = true;
+				}
+			}
+			if (reached[edgeIt->tgtPartition] < edgeIt->tgtPosition) {
+				edgeIt->isRemoved = true;
+				redundantSemaphores.insert(getCommunicationNumber(edgeIt->sendInstr));
+			}
+		}
+	}
+	return redundantSemaphores;
+}
+
+unsigned int Partitioning::removeRedundantSemaphores(Function &F, PartitioningGraph &pGraph, 
+	unsigned int firstSemNumber, unsigned int semNumberEnd) {
+	PostDominatorTree &PDT = getAnalysis<PostDominatorTree>(F);
+
+	ListScheduler::Schedule &schedule = schedules[F.getName().str()];
+	std::vector<std::vector<PartitioningGraph::VertexDescriptor> > &partitionOrders = schedule.partitionOrders;
+	std::vector<std::vector<Instruction*> > executionOrders(partitionOrders.size());
+	for (unsigned int p=0; p<partitionOrders.size(); p++)
+		for (std::vector<PartitioningGraph::VertexDescriptor>::iterator vIt = partitionOrders[p].begin(); vIt != partitionOrders[p].end(); ++vIt)
+			executionOrders[p].insert(executionOrders[p].end(), pGraph.getInstructions(*vIt).begin(), pGraph.getInstructions(*vIt).end());
+
+	std::set<unsigned int> removedSemaphores = findRedundantSemaphores(F, PDT, executionOrders, schedule.isSequential);
+
+	errs() << "Removed " << removedSemaphores.size() << " of " << (semNumberEnd - firstSemNumber)
+		<< " semaphores in " << F.getName() << "\n";
+	if (removedSemaphores.empty())
+		return semNumberEnd;
+
+	// renumber the remaining semaphores, so we do not need more semaphores than before
+	std::map<unsigned int, unsigned int> newNumbers;
+	unsigned int semNumber = firstSemNumber;
+	for (unsigned int oldNumber=firstSemNumber; oldNumber<semNumberEnd; oldNumber++)
+		if (!contains(removedSemaphores, oldNumber))
+			newNumbers[oldNumber] = semNumber++;
+
+	// delete the calls of the removed semaphores
+	for (unsigned int vd=0; vd<pGraph.getVertexCount(); vd++) {
+		std::vector<Instruction*> &instructions = pGraph.getInstructions(vd);
+		std::vector<Instruction*> newInstructions, removedCalls;
+		for (std::vector<Instruction*>::iterator it = instructions.begin(); it != instructions.end(); ++it) {
+			CallInst *call = dyn_cast<CallInst>(*it);
+			if (call == NULL || call->getCalledFunction() == NULL || !isSemaphoreCall(call)) {
+				newInstructions.push_back(*it);
+				continue;
+			}
+			unsigned int oldNumber = getCommunicationNumber(call);
+			if (contains(removedSemaphores, oldNumber))
+				removedCalls.push_back(call);
+			else {
+				call->setArgOperand(0, ConstantInt::get(Type::getInt32Ty(F.getContext()), newNumbers[oldNumber]));
+				newInstructions.push_back(call);
+			}
+		}
+		if (removedCalls.empty())
+			continue;
+		pGraph.setInstructions(vd, newInstructions);
+		for (std::vector<Instruction*>::iterator it = removedCalls.begin(); it != removedCalls.end(); ++it)
+			(*it)->eraseFromParent();
+	}
+	return semNumber;
+}
+
+
+namespace {
+	// communication calls of one message, they are moved together (see hideCommunicationLatency)
+	struct CommunicationGroup {
+		std::vector<CallInst*> calls;
+		bool isReceive;
+		// vertex in the execution order of the partition and position among the instructions that are not moved
+		unsigned int vertex, position;
+		// new place: at the old position, at the beginning or at the end of the target vertex
+		enum Placement { STAY, FRONT, BACK } placement;
+		unsigned int targetVertex;
+	};
+
+	bool usesAnyOf(Instruction *instr, const std::set<Value*> &values) {
+		if (contains(values, (Value*)instr))
+			return true;
+		for (User::op_iterator opIt = instr->op_begin(); opIt != instr->op_end(); ++opIt)
+			if (contains(values, opIt->get()))
+				return true;
+		return false;
+	}
+
+	// the C code generator places the label of a basic block before its first instruction
+	bool startsBranchTarget(Function &F, const std::vector<Instruction*> &instructions) {
+		if (instructions.empty())
+			return false;
+		BasicBlock *block = instructions.front()->getParent();
+		return instructions.front() == &block->front() && block != &F.getEntryBlock();
+	}
+}
+
+
+bool Partitioning::isMovableMessage(const std::vector<Type*> &types, unsigned int channelWords) {
+	unsigned int words = 0;
+	for (std::vector<Type*>::const_iterator it = types.begin(); it != types.end(); ++it)
+		words += getMessageWords(*it);
+	return words <= channelWords;
+}
+
+// A partition only waits in gets and semaphore waits, as long as its puts don't wait (see
+// isMovableMessage). Receiving a value later and sending one earlier only removes waits in
+// front of the puts, so every message is still sent, if it was sent before.
+unsigned int Partitioning::moveCommunicationCalls(Function &F, std::vector<std::vector<Instruction*> > &vertices,
+		const std::set<Instruction*> &movableCalls, unsigned int &messageCount) {
+	unsigned int vertexCount = vertices.size();
+
+	// separate the calls that may be moved from the instructions that stay in their vertex,
+	// calls inside of conditional regions are not moved
+	std::vector<std::vector<Instruction*> > fixed(vertexCount);
+	std::vector<CommunicationGroup> groups;
+	for (unsigned int k=0; k<vertexCount; k++) {
+		std::vector<Instruction*> &instructions = vertices[k];
+		bool containsBranch = false;
+		for (std::vector<Instruction*>::iterator it = instructions.begin(); it != instructions.end(); ++it)
+			containsBranch |= isa<BranchInst>(*it);
+
+		bool continuesGroup = false;
+		for (std::vector<Instruction*>::iterator it = instructions.begin(); it != instructions.end(); ++it) {
+			if (containsBranch || !contains(movableCalls, *it)) {
+				fixed[k].push_back(*it);
+				continuesGroup = false;
+				continue;
+			}
+			CallInst *call = cast<CallInst>(*it);
+			bool isReceive = !call->getType()->isVoidTy();
+			if (continuesGroup && groups.back().isReceive == isReceive
+					&& getCommunicationNumber(groups.back().calls.back()) == getCommunicationNumber(call)) {
+				groups.back().calls.push_back(call);
+				continue;
+			}
+			CommunicationGroup group;
+			group.calls.push_back(call);
+			group.isReceive = isReceive;
+			group.vertex = k;
+			group.position = fixed[k].size();
+			group.placement = CommunicationGroup::STAY;
+			group.targetVertex = k;
+			groups.push_back(group);
+			continuesGroup = true;
+		}
+	}
+	if (groups.empty())
+		return 0;
+
+	// receive the data at the beginning of the first vertex that uses one of the values
+	// (or that leaves the function)
+	for (std::vector<CommunicationGroup>::iterator groupIt = groups.begin(); groupIt != groups.end(); ++groupIt) {
+		if (!groupIt->isReceive)
+			continue;
+		std::set<Value*> receivedValues;
+		for (std::vector<CallInst*>::iterator it = groupIt->calls.begin(); it != groupIt->calls.end(); ++it)
+			receivedValues.insert(getReceivedValue(*it));
+
+		unsigned int useVertex = vertexCount;
+		for (unsigned int k=groupIt->vertex; k<vertexCount && useVertex == vertexCount; k++) {
+			unsigned int start = (k == groupIt->vertex ? groupIt->position : 0);
+			for (unsigned int i=start; i<fixed[k].size(); i++) {
+				Instruction *instr = fixed[k][i];
+				if (usesAnyOf(instr, receivedValues) || (isa<TerminatorInst>(instr) && !isa<BranchInst>(instr)))
+					useVertex = k;
+			}
+			// a received value may be forwarded to another partition
+			for (std::vector<CommunicationGroup>::iterator it = groups.begin(); it != groups.end(); ++it) {
+				if (it->isReceive || it->vertex != k || (k == groupIt->vertex && it->position < start))
+					continue;
+				for (std::vector<CallInst*>::iterator callIt = it->calls.begin(); callIt != it->calls.end(); ++callIt)
+					if (contains(receivedValues, (*callIt)->getArgOperand(1)))
+						useVertex = k;
+			}
+		}
+		if (useVertex == vertexCount)
+			useVertex = vertexCount - 1;
+		if (useVertex == groupIt->vertex)
+			continue;
+
+		if (!startsBranchTarget(F, fixed[useVertex])) {
+			groupIt->placement = CommunicationGroup::FRONT;
+			groupIt->targetVertex = useVertex;
+		}
+		else if (useVertex - 1 > groupIt->vertex) {
+			groupIt->placement = CommunicationGroup::BACK;
+			groupIt->targetVertex = useVertex - 1;
+		}
+	}
+
+	// vertex in which each value is computed or received
+	std::map<Value*, unsigned int> definitionVertex;
+	for (unsigned int k=0; k<vertexCount; k++)
+		for (std::vector<Instruction*>::iterator it = fixed[k].begin(); it != fixed[k].end(); ++it) {
+			definitionVertex[*it] = k;
+			if (Value *received = getReceivedValue(*it))
+				definitionVertex[received] = k;
+		}
+	for (std::vector<CommunicationGroup>::iterator groupIt = groups.begin(); groupIt != groups.end(); ++groupIt)
+		if (groupIt->isReceive)
+			for (std::vector<CallInst*>::iterator it = groupIt->calls.begin(); it != groupIt->calls.end(); ++it)
+				definitionVertex[getReceivedValue(*it)] = groupIt->targetVertex;
+
+	// send the data at the end of the vertex that computes the last value of the message
+	for (std::vector<CommunicationGroup>::iterator groupIt = groups.begin(); groupIt != groups.end(); ++groupIt) {
+		if (groupIt->isReceive)
+			continue;
+		int producerVertex = -1;
+		bool isMovable = true;
+		for (std::vector<CallInst*>::iterator it = groupIt->calls.begin(); it != groupIt->calls.end(); ++it) {
+			Value *value = (*it)->getArgOperand(1);
+			// the generated code reads a loaded value where it is used, so it must not be moved across a store
+			if (isa<LoadInst>(value))
+				isMovable = false;
+			else if (isa<Instruction>(value)) {
+				std::map<Value*, unsigned int>::iterator defIt = definitionVertex.find(value);
+				if (defIt == definitionVertex.end())
+					isMovable = false;
+				else
+					producerVertex = std::max(producerVertex, (int)defIt->second);
+			}
+		}
+		if (!isMovable || producerVertex >= (int)groupIt->vertex)
+			continue;
+
+		if (producerVertex >= 0) {
+			groupIt->placement = CommunicationGroup::BACK;
+			groupIt->targetVertex = producerVertex;
+		}
+		else if (!startsBranchTarget(F, fixed[0])) {
+			// the values are parameters or constants
+			groupIt->placement = CommunicationGroup::FRONT;
+			groupIt->targetVertex = 0;
+		}
+	}
+
+	// put the calls at their new places
+	std::vector<std::vector<unsigned int> > frontGroups(vertexCount), backGroups(vertexCount), stayingGroups(vertexCount);
+	unsigned int movedCount = 0;
+	for (unsigned int i=0; i<groups.size(); i++) {
+		if (groups[i].placement == CommunicationGroup::FRONT)
+			frontGroups[groups[i].targetVertex].push_back(i);
+		else if (groups[i].placement == CommunicationGroup::BACK)
+			backGroups[groups[i].targetVertex].push_back(i);
+		else
+			stayingGroups[groups[i].vertex].push_back(i);
+		if (groups[i].placement != CommunicationGroup::STAY)
+			movedCount++;
+	}
+	for (unsigned int k=0; k<vertexCount; k++) {
+		std::vector<Instruction*> newInstructions;
+		for (std::vector<unsigned int>::iterator it = frontGroups[k].begin(); it != frontGroups[k].end(); ++it)
+			newInstructions.insert(newInstructions.end(), groups[*it].calls.begin(), groups[*it].calls.end());
+		std::vector<unsigned int>::iterator stayIt = stayingGroups[k].begin();
+		for (unsigned int i=0; i<=fixed[k].size(); i++) {
+			for (; stayIt != stayingGroups[k].end() && groups[*stayIt].position == i; ++stayIt)
+				newInstructions.insert(newInstructions.end(), groups[*stayIt].calls.begin(), groups[*stayIt].calls.end());
+			if (i < fixed[k].size())
+				newInstructions.push_back(fixed[k][i]);
+		}
+		for (std::vector<unsigned int>::iterator it = backGroups[k].begin(); it != backGroups[k].end(); ++it)
+			newInstructions.insert(newInstructions.end(), groups[*it].calls.begin(), groups[*it].calls.end());
+		vertices[k].swap(newInstructions);
+	}
+
+	messageCount += groups.size();
+	return movedCount;
+}
+
+
+void Partitioning::hideCommunicationLatency(Function &F, PartitioningGraph &pGraph, const std::set<Instruction*> &movableCalls) {
+	// The vertices keep their order, but a partition should not wait for data while there is still
+	// work that does not need it and it should not delay the data for other partitions.
+	ListScheduler::Schedule &schedule = schedules[F.getName().str()];
+	unsigned int messageCount = 0, movedCount = 0;
+	for (unsigned int p=0; p<schedule.partitionOrders.size(); p++) {
+		std::vector<PartitioningGraph::VertexDescriptor> &order = schedule.partitionOrders[p];
+		if (!schedule.isSequential[p] || order.empty())
+			continue;
+
+		std::vector<std::vector<Instruction*> > vertices;
+		for (std::vector<PartitioningGraph::VertexDescriptor>::iterator vIt = order.begin(); vIt != order.end(); ++vIt)
+			vertices.push_back(pGraph.getInstructions(*vIt));
+		movedCount += moveCommunicationCalls(F, vertices, movableCalls, messageCount);
+		for (unsigned int k=0; k<order.size(); k++)
+			if (vertices[k] != pGraph.getInstructions(order[k]))
+				pGraph.setInstructions(order[k], vertices[k]);
+	}
+
+	if (messageCount > 0)
+		errs() << "Moved " << movedCount << " of " << messageCount << " messages between processors in " << F.getName() << "\n";
+}
+
+
+// global variable or parameter that is accessed through a pointer
+static Value *getAccessedObject(Value *pointer) {
+	pointer = pointer->stripPointerCasts();
+	while (GEPOperator *gep = dyn_cast<GEPOperator>(pointer))
+		pointer = gep->getPointerOperand()->stripPointerCasts();
+	// parameters are accessed through a pointer that is loaded from their stack variable
+	if (LoadInst *lInstr = dyn_cast<LoadInst>(pointer))
+		pointer = lInstr->getPointerOperand();
+	return pointer;
+}
+
+
+void Partitioning::insertSplitPhaseFPGAInvocations(Module &M, Function &F, PartitioningGraph &pGraph) {
+	// the calls are markers for savePartitioning, which replaces them by the interface code of the FPGA
+	Function *startFunc = cast<Function>(
+		M.getOrInsertFunction("_fpga_start",
+			Type::getVoidTy(M.getContext()),
+			Type::getInt32Ty(M.getContext()),
+			(Type *)0));
+	Function *collectFunc = cast<Function>(
+		M.getOrInsertFunction("_fpga_collect",
+			Type::getVoidTy(M.getContext()),
+			Type::getInt32Ty(M.getContext()),
+			(Type *)0));
+
+	std::string functionName = F.getName().str();
+	std::vector<std::vector<PartitioningGraph::VertexDescriptor> > &partitionOrders = schedules[functionName].partitionOrders;
+
+	// the first processor partition that has any vertices hosts the FPGA partitions
+	HardwareInformation hInfo;
+	int hostPartition = -1;
+	std::vector<unsigned int> fpgaPartitions;
+	for (unsigned int p=0; p<partitionOrders.size(); p++) {
+		if (partitionOrders[p].empty())
+			continue;
+		if (hInfo.getDeviceInfo(partitioningDevices[p])->getType() == DeviceInformation::FPGA_RECONOS)
+			fpgaPartitions.push_back(p);
+		else if (hostPartition < 0)
+			hostPartition = p;
+	}
+	if (hostPartition < 0)
+		return;
+
+	for (std::vector<unsigned int>::iterator fpgaIt = fpgaPartitions.begin(); fpgaIt != fpgaPartitions.end(); ++fpgaIt) {
+		// the memory the FPGA writes is only updated when its results are collected
+		std::set<Value*> writtenObjects;
+		bool containsReturn = false;
+		for (std::vector<PartitioningGraph::VertexDescriptor>::iterator vIt = partitionOrders[*fpgaIt].begin(); vIt != partitionOrders[*fpgaIt].end(); ++vIt) {
+			std::vector<Instruction*> &instructions = pGraph.getInstructions(*vIt);
+			for (std::vector<Instruction*>::iterator it = instructions.begin(); it != instructions.end(); ++it) {
+				if (StoreInst *sInstr = dyn_cast<StoreInst>(*it))
+					writtenObjects.insert(getAccessedObject(sInstr->getPointerOperand()));
+				else if (isa<ReturnInst>(*it))
+					containsReturn = true;
+			}
+		}
+
+		// collect the results before the first load of written memory in the host partition or at its end
+		Instruction *collectPoint = NULL;
+		PartitioningGraph::VertexDescriptor collectVertex = partitionOrders[hostPartition].back();
+		bool isReadByOtherPartition = false;
+		for (unsigned int p=0; p<partitionOrders.size(); p++) {
+			if (p == *fpgaIt)
+				continue;
+			for (std::vector<PartitioningGraph::VertexDescriptor>::iterator vIt = partitionOrders[p].begin(); vIt != partitionOrders[p].end(); ++vIt) {
+				std::vector<Instruction*> &instructions = pGraph.getInstructions(*vIt);
+				for (std::vector<Instruction*>::iterator it = instructions.begin(); it != instructions.end(); ++it) {
+					LoadInst *lInstr = dyn_cast<LoadInst>(*it);
+					if (lInstr == NULL || !contains(writtenObjects, getAccessedObject(lInstr->getPointerOperand())))
+						continue;
+					if (p != (unsigned int)hostPartition)
+						isReadByOtherPartition = true;
+					else if (collectPoint == NULL) {
+						collectPoint = lInstr;
+						collectVertex = *vIt;
 					}
-					
-					// insert instruction: if we are inside an if statement we should insert the put method 
-					// at the end of the statement, otherwise we can insert it directly after the target instruction
-					std::vector<Instruction*>::iterator insertTarget = depIt;
-					bool containsBranch = false;
-					for (std::vector<Instruction*>::iterator it = depInstrList.begin(); it != depInstrList.end(); ++it)
-						if (isa<BranchInst>(*it)) 
-							containsBranch = true;
-					if (containsBranch)
-						insertTarget = depInstrList.end()-1;
-
-					// add instruction to function
-					Instruction *tgt = *insertTarget;
-					depInstr->getParent()->getInstList().insertAfter(tgt, newInstr);
-					// add instruction to vertex instruction list
-					depInstrList.insert(insertTarget+1, newInstr);
-					pGraph.setInstructions(depVertex, depInstrList);
 				}
-				if (depNumberUsed)
-					depNumber++;
-				if (semNumberUsed)
-					semNumber++;
 			}
 		}
+
+		// the return value of the FPGA is returned by the waiting thread
+		// and other threads must not read the results before they are collected
+		if (containsReturn || isReadByOtherPartition) {
+			errs() << "WARNING: The FPGA partition " << *fpgaIt << " of " << functionName 
+				<< " is not invoked split-phase, because " << (containsReturn ? "it returns the result" : "other partitions read its results") << "\n";
+			continue;
+		}
+
+		Value *partitionVal = ConstantInt::get(Type::getInt32Ty(M.getContext()), *fpgaIt);
+		std::vector<Instruction*> newInstructions;
+
+		// start the FPGA at the beginning: its inputs are the parameters of the function
+		PartitioningGraph::VertexDescriptor startVertex = partitionOrders[hostPartition].front();
+		std::vector<Instruction*> &startInstructions = pGraph.getInstructions(startVertex);
+		std::vector<Instruction*>::iterator startIt = startInstructions.begin();
+		while (startIt != startInstructions.end() && isa<PHINode>(*startIt))
+			++startIt;
+		CallInst *startInstr = CallInst::Create(startFunc, partitionVal);
+		if (startIt != startInstructions.end())
+			startInstr->insertBefore(*startIt);
+		else
+			startInstr->insertAfter(startInstructions.back());
+		newInstructions.insert(newInstructions.end(), startInstructions.begin(), startIt);
+		newInstructions.push_back(startInstr);
+		newInstructions.insert(newInstructions.end(), startIt, startInstructions.end());
+		pGraph.setInstructions(startVertex, newInstructions);
+
+		CallInst *collectInstr = CallInst::Create(collectFunc, partitionVal);
+		std::vector<Instruction*> &collectInstructions = pGraph.getInstructions(collectVertex);
+		if (collectPoint == NULL) {
+			// before the return statement or after the last instruction
+			Instruction *lastInstr = collectInstructions.back();
+			if (isa<TerminatorInst>(lastInstr))
+				collectPoint = lastInstr;
+			else
+				collectInstr->insertAfter(lastInstr);
+		}
+		if (collectPoint != NULL)
+			collectInstr->insertBefore(collectPoint);
+		newInstructions.clear();
+		for (std::vector<Instruction*>::iterator it = collectInstructions.begin(); it != collectInstructions.end(); ++it) {
+			if (*it == collectPoint)
+				newInstructions.push_back(collectInstr);
+			newInstructions.push_back(*it);
+		}
+		if (collectPoint == NULL)
+			newInstructions.push_back(collectInstr);
+		pGraph.setInstructions(collectVertex, newInstructions);
+
+		fpgaHostPartitions[functionName][*fpgaIt] = hostPartition;
 	}
-	// set maximum number of semaphore counts
-	semNumberMax = std::max(semNumberMax, semNumber);
 }
 
 
@@ -462,6 +1426,431 @@ struct GenerateHardwareThreadFileFromTemplate {
 };
 
 
+// name of a global variable or of an element of a global array in the C code, e.g. "Vp[3]"
+// (the name is empty, if the index of the element is not constant)
+static GlobalVariable *getGlobalElement(Value *pointer, std::string &name) {
+	pointer = pointer->stripPointerCasts();
+	if (GlobalVariable *global = dyn_cast<GlobalVariable>(pointer)) {
+		name = global->getName().str();
+		return global;
+	}
+	GEPOperator *gep = dyn_cast<GEPOperator>(pointer);
+	if (gep == NULL)
+		return NULL;
+	GlobalVariable *global = dyn_cast<GlobalVariable>(gep->getPointerOperand()->stripPointerCasts());
+	if (global == NULL)
+		return NULL;
+	name = "";
+	if (gep->hasAllConstantIndices() && gep->getNumIndices() == 2)
+		name = global->getName().str() + "[" + cast<ConstantInt>(*(gep->idx_end()-1))->getValue().toString(10, true) + "]";
+	return global;
+}
+
+
+// Global variables that are read by the function, but never written in the module,
+// are parameters of the model. They are invariant inputs of an FPGA partition,
+// all other inputs (e.g. the parameters of the function) change in every step.
+// The caches of the parameter hoisting are only written when the parameters change.
+static void findInvariantInputs(Function &F, std::vector<std::pair<Function*, GlobalVariable*> > &parameterInitFunctions,
+		std::set<std::string> &inputs) {
+	std::set<std::string> writtenElements;
+	std::set<GlobalVariable*> writtenGlobals;
+	std::set<Function*> initFunctions;
+	for (unsigned int i=0; i<parameterInitFunctions.size(); i++)
+		initFunctions.insert(parameterInitFunctions[i].first);
+	Module *M = F.getParent();
+	for (Module::iterator fIt = M->begin(); fIt != M->end(); ++fIt) {
+		if (contains(initFunctions, &*fIt))
+			continue;
+		for (inst_iterator it = inst_begin(*fIt); it != inst_end(*fIt); ++it) {
+			std::string name;
+			if (StoreInst *sInstr = dyn_cast<StoreInst>(&*it)) {
+				if (GlobalVariable *global = getGlobalElement(sInstr->getPointerOperand(), name)) {
+					if (name.empty())
+						writtenGlobals.insert(global);
+					else
+						writtenElements.insert(name);
+				}
+			}
+			else if (CallInst *cInstr = dyn_cast<CallInst>(&*it)) {
+				// the called function may write a global array that is passed to it
+				for (unsigned int i=0; i<cInstr->getNumArgOperands(); i++)
+					if (GlobalVariable *global = dyn_cast<GlobalVariable>(getAccessedObject(cInstr->getArgOperand(i))))
+						writtenGlobals.insert(global);
+			}
+		}
+	}
+
+	for (inst_iterator it = inst_begin(F); it != inst_end(F); ++it) {
+		LoadInst *lInstr = dyn_cast<LoadInst>(&*it);
+		if (lInstr == NULL)
+			continue;
+		std::string name;
+		GlobalVariable *global = getGlobalElement(lInstr->getPointerOperand(), name);
+		if (global != NULL && !name.empty() && !contains(writtenGlobals, global) && !contains(writtenElements, name))
+			inputs.insert(name);
+	}
+}
+
+
+static std::string getCDatatype(Type *type) {
+	if (type->isPointerTy())
+		return getCDatatype(type->getPointerElementType()) + " *";
+	else if (type->isIntegerTy())
+		return "int";
+	else if (type->isFloatingPointTy())
+		return "double";
+	else
+		return "void";
+}
+
+// Writes the C implementation of a hardware thread for the ReconOS emulation (see runtime/reconos_emu).
+// It uses the same protocol as the VHDL implementation, so the partition is compiled from the same
+// instructions. The hardware thread has its own copy of the global variables like the registers of
+// the FPGA, so it only sees the values that are sent to it.
+static void writeEmulatedHardwareThread(const std::string &filename, unsigned int slot, Function &func,
+		const std::vector<Instruction*> &instructions, VHDLBackend *backend, unsigned int dataDependencyCount,
+		std::vector<SimpleCCodeGenerator::GlobalArrayVariable> &globalVariables,
+		std::vector<std::pair<Function*, GlobalVariable*> > &parameterInitFunctions) {
+	SimpleCCodeGenerator codeGen;
+	std::string calculation = codeGen.createCCode(func, instructions);
+
+	std::ostringstream code;
+	code << "// C implementation of hardware thread " << slot << " for the ReconOS emulation (generated by -fpga-emulation)\n"
+	     << "#include \"reconos.h\"\n"
+	     << "#include \"mbox.h\"\n"
+	     << "#include \"reconos_emu.h\"\n"
+	     << "#include <stdint.h>\n"
+	     << "#include <math.h>\n"
+	     << "#include <semaphore.h>\n\n";
+
+	for (std::vector<SimpleCCodeGenerator::GlobalArrayVariable>::iterator gvIt = globalVariables.begin(); gvIt != globalVariables.end(); ++gvIt)
+		code << "static " << gvIt->type << " " << gvIt->name << "[" << gvIt->numElem << "];\n";
+	for (std::vector<std::pair<Function*, GlobalVariable*> >::iterator initIt = parameterInitFunctions.begin(); initIt != parameterInitFunctions.end(); ++initIt) {
+		ArrayType *cacheType = cast<ArrayType>(initIt->second->getType()->getElementType());
+		code << "static double " << initIt->second->getName().str() << "[" << cacheType->getNumElements() << "];\n";
+	}
+
+	// data dependencies and semaphores are the resources after the start and stop mailbox
+	code << "\nstatic struct reconos_resource* resources;\n"
+	     << "#define _get_real(dep) reconos_emu_mbox_get_real((struct mbox*)resources[2 + (dep)].ptr)\n"
+	     << "#define _get_int(dep) reconos_emu_mbox_get_int((struct mbox*)resources[2 + (dep)].ptr)\n"
+	     << "#define _get_bool(dep) reconos_emu_mbox_get_int((struct mbox*)resources[2 + (dep)].ptr)\n"
+	     << "#define _put_real(dep, value) reconos_emu_mbox_put_real((struct mbox*)resources[2 + (dep)].ptr, (value))\n"
+	     << "#define _put_int(dep, value) reconos_emu_mbox_put_int((struct mbox*)resources[2 + (dep)].ptr, (value))\n"
+	     << "#define _put_bool(dep, value) reconos_emu_mbox_put_int((struct mbox*)resources[2 + (dep)].ptr, (value))\n"
+	     << "#define _sem_wait(sem) sem_wait((sem_t*)resources[2 + " << dataDependencyCount << " + (sem)].ptr)\n"
+	     << "#define _sem_post(sem) sem_post((sem_t*)resources[2 + " << dataDependencyCount << " + (sem)].ptr)\n\n";
+
+	std::ostringstream params, args, locals;
+	for (Function::arg_iterator argIt = func.arg_begin(); argIt != func.arg_end(); ++argIt) {
+		std::string name = argIt->getName().str();
+		std::string declaration = getCDatatype(argIt->getType()) + (argIt->getType()->isPointerTy() ? "" : " ") + name;
+		if (argIt != func.arg_begin()) {
+			params << ", ";
+			args << ", ";
+		}
+		params << declaration;
+		args << name;
+		// a pointer parameter points to a local value of the hardware thread
+		if (argIt->getType()->isPointerTy()) {
+			locals << "\t" << getCDatatype(argIt->getType()->getPointerElementType()) << " " << name << "_value = 0;\n"
+			       << "\t" << declaration << " = &" << name << "_value;\n";
+		}
+		else
+			locals << "\t" << declaration << " = 0;\n";
+	}
+	std::ostringstream call;
+	call << "hwt_" << slot << "_calculation(" << args.str() << ")";
+
+	code << "static " << getCDatatype(func.getReturnType()) << " hwt_" << slot << "_calculation("
+	     << (params.str().empty() ? "void" : params.str()) << ")\n{\n"
+	     << calculation
+	     << "}\n\n"
+	     << "static void hwt_" << slot << "_emulation(struct reconos_hwt* hwt)\n{\n"
+	     << "\tstruct mbox* mbox_start = (struct mbox*)hwt->resources[0].ptr;\n"
+	     << "\tstruct mbox* mbox_stop  = (struct mbox*)hwt->resources[1].ptr;\n"
+	     << locals.str()
+	     << "\tresources = hwt->resources;\n\n"
+	     << prefixAllLines("\t", backend->getEmulationCode(call.str()))
+	     << "}\n\n"
+	     << "__attribute__((constructor)) static void register_hwt_" << slot << "(void)\n{\n"
+	     << "\treconos_emu_register_hwt(" << slot << ", hwt_" << slot << "_emulation);\n"
+	     << "}\n";
+
+	TemplateWriter::writeToFile(filename, code.str());
+}
+
+
+namespace {
+	// a data dependency or semaphore in the report of the wait counters
+	struct CommunicationDescription {
+		Value *source;		// first value of the message or instruction before the semaphore post
+		std::string sender, receiver;
+		unsigned int values;
+
+		CommunicationDescription() : source(NULL), values(0) {}
+	};
+}
+
+static bool isCommunicationCall(Instruction *instr, const char *suffix) {
+	CallInst *cInstr = dyn_cast<CallInst>(instr);
+	if (cInstr == NULL || cInstr->getCalledFunction() == NULL)
+		return false;
+	std::string name = cInstr->getCalledFunction()->getName().str();
+	std::string suffixStr = suffix;
+	return name.compare(0, suffixStr.size()+1, "_" + suffixStr) == 0
+		|| name.compare(0, suffixStr.size()+6, "_ring_" + suffixStr) == 0;
+}
+
+// Finds the senders and receivers of the data dependencies and semaphores in the instructions of a partition.
+static void collectCommunication(const std::string &partitionName, const std::vector<Instruction*> &instructions,
+		std::vector<CommunicationDescription> &dependencies, std::vector<CommunicationDescription> &semaphores) {
+	Instruction *lastComputation = NULL;
+	for (std::vector<Instruction*>::const_iterator it = instructions.begin(); it != instructions.end(); ++it) {
+		bool isPut = isCommunicationCall(*it, "put_"), isGet = isCommunicationCall(*it, "get_");
+		bool isPost = isCommunicationCall(*it, "sem_post"), isWait = isCommunicationCall(*it, "sem_wait");
+		if (!isPut && !isGet && !isPost && !isWait) {
+			lastComputation = *it;
+			continue;
+		}
+
+		CallInst *cInstr = cast<CallInst>(*it);
+		unsigned int number = cast<ConstantInt>(cInstr->getArgOperand(0))->getZExtValue();
+		std::vector<CommunicationDescription> &descriptions = (isPut || isGet ? dependencies : semaphores);
+		if (number >= descriptions.size())
+			continue;
+		CommunicationDescription &description = descriptions[number];
+		if (isPut) {
+			if (description.source == NULL)
+				description.source = cInstr->getArgOperand(1);
+			description.sender = partitionName;
+			description.values++;
+		}
+		else if (isPost) {
+			description.source = lastComputation;
+			description.sender = partitionName;
+		}
+		else
+			description.receiver = partitionName;
+	}
+}
+
+bool Partitioning::hasRoundTrip(const std::vector<Instruction*> *instructionsForPartition, unsigned int partitionCount,
+		unsigned int partition) {
+	// position of the first reached communication call in each partition, everything after it
+	// happens after a put or post of the partition
+	std::vector<unsigned int> reached(partitionCount, UINT_MAX);
+	std::vector<unsigned int> worklist;
+	for (unsigned int k = 0; k < instructionsForPartition[partition].size(); ++k) {
+		Instruction *instr = instructionsForPartition[partition][k];
+		if (isCommunicationCall(instr, "put_") || isCommunicationCall(instr, "sem_post")) {
+			reached[partition] = k;
+			worklist.push_back(partition);
+			break;
+		}
+	}
+
+	while (!worklist.empty()) {
+		unsigned int sender = worklist.back();
+		worklist.pop_back();
+		for (unsigned int k = reached[sender]; k < instructionsForPartition[sender].size(); ++k) {
+			Instruction *instr = instructionsForPartition[sender][k];
+			bool isPut = isCommunicationCall(instr, "put_");
+			if (!isPut && !isCommunicationCall(instr, "sem_post"))
+				continue;
+			unsigned int number = cast<ConstantInt>(cast<CallInst>(instr)->getArgOperand(0))->getZExtValue();
+
+			// the receivers of this message can only continue after it has been sent
+			for (unsigned int receiver = 0; receiver < partitionCount; ++receiver) {
+				if (receiver == sender)
+					continue;
+				const std::vector<Instruction*> &instructions = instructionsForPartition[receiver];
+				for (unsigned int l = 0; l < instructions.size(); ++l) {
+					bool isReceive = (isPut ? isCommunicationCall(instructions[l], "get_")
+						: isCommunicationCall(instructions[l], "sem_wait"));
+					if (!isReceive || cast<ConstantInt>(cast<CallInst>(instructions[l])->getArgOperand(0))->getZExtValue() != number)
+						continue;
+					if (receiver == partition && isPut)
+						return true;
+					if (l < reached[receiver]) {
+						reached[receiver] = l;
+						worklist.push_back(receiver);
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+static std::string quoteCString(const std::string &str) {
+	std::string quoted = "\"";
+	for (std::string::const_iterator it = str.begin(); it != str.end(); ++it) {
+		if (*it == '"' || *it == '\\')
+			quoted += '\\';
+		quoted += *it;
+	}
+	return quoted + "\"";
+}
+
+static void writeCStringArray(std::ostream &stream, const std::string &name, const std::vector<std::string> &strings) {
+	stream << "static const char* const " << name << "[] = {\n";
+	for (std::vector<std::string>::const_iterator it = strings.begin(); it != strings.end(); ++it)
+		stream << "\t" << quoteCString(*it) << ",\n";
+	// C doesn't allow empty arrays
+	if (strings.empty())
+		stream << "\t0\n";
+	stream << "};\n";
+}
+
+static std::vector<std::string> describeCommunication(const std::vector<CommunicationDescription> &descriptions) {
+	std::vector<std::string> names;
+	for (std::vector<CommunicationDescription>::const_iterator it = descriptions.begin(); it != descriptions.end(); ++it) {
+		std::string source;
+		raw_string_ostream ss(source);
+		if (it->source != NULL)
+			ss << *it->source;
+		else
+			ss << "?";
+		ss.flush();
+		boost::algorithm::trim(source);
+		std::ostringstream name;
+		name << source;
+		if (it->values > 1)
+			name << " (and " << (it->values - 1) << " more values)";
+		name << " [" << it->sender << " -> " << it->receiver << "]";
+		names.push_back(name.str());
+	}
+	return names;
+}
+
+
+// global variables and functions that are used by an instruction (also in constant expressions)
+static void collectUsedGlobals(User *user, std::set<GlobalValue*> &globals) {
+	for (User::op_iterator opIt = user->op_begin(); opIt != user->op_end(); ++opIt) {
+		if (GlobalValue *global = dyn_cast<GlobalValue>(*opIt))
+			globals.insert(global);
+		else if (ConstantExpr *expr = dyn_cast<ConstantExpr>(*opIt))
+			collectUsedGlobals(expr, globals);
+	}
+}
+
+// Clones the instructions of a processor partition into a function of its own with the signature of
+// the partitioned function. The communication calls stay as they are and their results replace the
+// values of the other partitions. The control flow is kept, but the conditional branches of other
+// partitions become unconditional (a partition has no instructions in the conditional regions of others).
+Function *Partitioning::clonePartition(Module *module, Function &func, const std::string &name,
+		const std::vector<Instruction*> &instructions) {
+	// declare the used global variables and functions in the new module
+	ValueToValueMapTy valueMap;
+	std::set<GlobalValue*> globals;
+	for (inst_iterator it = inst_begin(func); it != inst_end(func); ++it)
+		collectUsedGlobals(&*it, globals);
+	for (std::set<GlobalValue*>::iterator it = globals.begin(); it != globals.end(); ++it) {
+		GlobalValue *declaration = module->getNamedValue((*it)->getName());
+		if (declaration == NULL) {
+			if (Function *usedFunc = dyn_cast<Function>(*it))
+				declaration = Function::Create(usedFunc->getFunctionType(), GlobalValue::ExternalLinkage,
+					usedFunc->getName(), module);
+			else
+				declaration = new GlobalVariable(*module, (*it)->getType()->getElementType(), false,
+					GlobalValue::ExternalLinkage, NULL, (*it)->getName());
+		}
+		valueMap[*it] = declaration;
+	}
+
+	Function *partFunc = Function::Create(func.getFunctionType(), GlobalValue::ExternalLinkage, name, module);
+	Function::arg_iterator newArgIt = partFunc->arg_begin();
+	for (Function::arg_iterator argIt = func.arg_begin(); argIt != func.arg_end(); ++argIt, ++newArgIt) {
+		newArgIt->setName(argIt->getName());
+		valueMap[&*argIt] = &*newArgIt;
+	}
+	SmallVector<ReturnInst*, 4> returns;
+	CloneFunctionInto(partFunc, &func, valueMap, true, returns);
+
+	std::set<Instruction*> partition;
+	for (std::vector<Instruction*>::const_iterator it = instructions.begin(); it != instructions.end(); ++it)
+		partition.insert(cast<Instruction>((Value*)valueMap[*it]));
+
+	// use the received values instead of the values of the other partitions
+	for (std::vector<Instruction*>::const_iterator it = instructions.begin(); it != instructions.end(); ++it) {
+		Value *receivedValue = getReceivedValue(*it);
+		if (receivedValue == NULL)
+			continue;
+		Instruction *received = cast<Instruction>((Value*)valueMap[*it]);
+		received->setMetadata("targetop", NULL);
+		Value *original = valueMap[receivedValue];
+		std::vector<User*> users(original->use_begin(), original->use_end());
+		for (std::vector<User*>::iterator userIt = users.begin(); userIt != users.end(); ++userIt) {
+			Instruction *user = dyn_cast<Instruction>(*userIt);
+			if (user != NULL && user != received && contains(partition, user))
+				user->replaceUsesOfWith(original, received);
+		}
+	}
+
+	// remove the instructions of the other partitions, but keep the parameters in their allocas
+	std::vector<Instruction*> removed;
+	std::vector<TerminatorInst*> terminators;
+	for (inst_iterator it = inst_begin(partFunc); it != inst_end(partFunc); ++it) {
+		Instruction *instr = &*it;
+		if (contains(partition, instr) || isa<AllocaInst>(instr)
+				|| (isa<StoreInst>(instr) && isa<Argument>(instr->getOperand(0))))
+			continue;
+		if (TerminatorInst *terminator = dyn_cast<TerminatorInst>(instr))
+			terminators.push_back(terminator);
+		else
+			removed.push_back(instr);
+	}
+	for (std::vector<TerminatorInst*>::iterator it = terminators.begin(); it != terminators.end(); ++it) {
+		if (BranchInst *bInstr = dyn_cast<BranchInst>(*it)) {
+			if (bInstr->isConditional()) {
+				BranchInst::Create(bInstr->getSuccessor(0), bInstr);
+				bInstr->getSuccessor(1)->removePredecessor(bInstr->getParent());
+				bInstr->eraseFromParent();
+			}
+		}
+		else if (ReturnInst *rInstr = dyn_cast<ReturnInst>(*it)) {
+			// the return value is computed by another partition
+			if (rInstr->getReturnValue() != NULL) {
+				ReturnInst::Create(func.getContext(), UndefValue::get(rInstr->getReturnValue()->getType()), rInstr);
+				rInstr->eraseFromParent();
+			}
+		}
+	}
+	for (std::vector<Instruction*>::iterator it = removed.begin(); it != removed.end(); ++it) {
+		for (Value::use_iterator useIt = (*it)->use_begin(); useIt != (*it)->use_end(); ++useIt)
+			if (Instruction *user = dyn_cast<Instruction>(*useIt))
+				if (contains(partition, user)) {
+					errs() << "ERROR: " << name << " uses a value of another partition that is not sent to it: " << **it << "\n";
+					break;
+				}
+		(*it)->replaceAllUsesWith(UndefValue::get((*it)->getType()));
+	}
+	for (std::vector<Instruction*>::iterator it = removed.begin(); it != removed.end(); ++it)
+		(*it)->eraseFromParent();
+
+	if (verifyFunction(*partFunc, ReturnStatusAction))
+		errs() << "ERROR: The LLVM function of partition " << name << " is invalid\n";
+
+	return partFunc;
+}
+
+static std::string getCPrototype(Function &func) {
+	std::ostringstream prototype;
+	prototype << getCDatatype(func.getReturnType()) << " " << func.getName().str() << "(";
+	for (Function::arg_iterator argIt = func.arg_begin(); argIt != func.arg_end(); ++argIt) {
+		std::string type = getCDatatype(argIt->getType());
+		prototype << (argIt == func.arg_begin() ? "" : ", ") << type << (argIt->getType()->isPointerTy() ? "" : " ")
+		          << argIt->getName().str();
+	}
+	if (func.arg_empty())
+		prototype << "void";
+	prototype << ");";
+	return prototype.str();
+}
+
+
 void Partitioning::savePartitioning(std::map<std::string, Function*> &functions, 
 	std::map<std::string, PartitioningGraph*> &graphs, std::map<std::string, unsigned int> partitioningNumbers) {
 	// set template and output files
@@ -489,7 +1878,27 @@ void Partitioning::savePartitioning(std::map<std::string, Function*> &functions,
 	std::stringstream globVarOutput;
 	for (std::vector<SimpleCCodeGenerator::GlobalArrayVariable>::iterator gvIt = globalVariables.begin(); gvIt != globalVariables.end(); ++gvIt)
 		codeGen.createExternArray(globVarOutput, *gvIt);
-	tWriter.setValue("GLOBAL_VARIABLES", globVarOutput.str());
+	if (HardwareInformation::useRingBuffersForCPUs())
+		globVarOutput << "#include \"mehari_channel.h\"\n";
+	if (CacheFPGAInputs)
+		globVarOutput << "#include <string.h>\n";
+	if (HardwareInformation::useSLPPackingForCPUs())
+		globVarOutput << "typedef double mehari_v2df __attribute__((vector_size(16)));\n";
+	if (AtomicFPGAMessages)
+		globVarOutput << "#include \"mehari_message.h\"\n"
+		              << "static struct mehari_message_channel fpga_messages = MEHARI_MESSAGE_CHANNEL_INITIALIZER;\n"
+		              << "static __thread uint32_t fpga_ticket;\n";
+	// the caches of the parameter hoisting and the functions that update them
+	for (std::vector<std::pair<Function*, GlobalVariable*> >::iterator initIt = parameterInitFunctions.begin(); initIt != parameterInitFunctions.end(); ++initIt) {
+		std::vector<Instruction*> instructions;
+		for (inst_iterator it = inst_begin(*initIt->first); it != inst_end(*initIt->first); ++it)
+			instructions.push_back(&*it);
+		ArrayType *cacheType = cast<ArrayType>(initIt->second->getType()->getElementType());
+		globVarOutput << "double " << initIt->second->getName().str() << "[" << cacheType->getNumElements() << "];\n"
+		              << "void " << initIt->first->getName().str() << "(void)\n{\n"
+		              << codeGen.createCCode(*initIt->first, instructions)
+		              << "}\n";
+	}
 
 	// write number of used semaphores
 	std::string semCountStr = static_cast<std::ostringstream*>( &(std::ostringstream() << (semNumberMax)))->str();
@@ -523,6 +1932,17 @@ void Partitioning::savePartitioning(std::map<std::string, Function*> &functions,
 	// create an instance of HardwareInformation
 	boost::scoped_ptr<HardwareInformation> hw_info(new HardwareInformation());
 
+	// names of the partitions, dependencies and semaphores for the wait counters
+	std::vector<std::string> waitPartitionNames;
+	std::vector<unsigned int> waitPredictedCycles;
+	std::vector<CommunicationDescription> dependencyDescriptions(dataDependencies.size());
+	std::vector<CommunicationDescription> semaphoreDescriptions(semNumberMax);
+
+	// module for the LLVM functions of the processor partitions
+	boost::scoped_ptr<Module> irModule;
+	if (!IROutput.empty() && IROutput != "ll" && IROutput != "bc")
+		errs() << "ERROR: Unknown format for -partitioning-ir-output: " << IROutput << " (use ll or bc)\n";
+
 	// write partitioning for each function
 	unsigned int functionIndex = 0;
 	unsigned int putParamStart = 0;
@@ -561,17 +1981,17 @@ void Partitioning::savePartitioning(std::map<std::string, Function*> &functions,
 				"FUNCTION_NAME", currentFunction);	
 		}
 
-		// collect the instructions for each partition
+		// collect the instructions for each partition in the order of the schedule
 		std::vector<Instruction*> instructionsForPartition[partitioningNumbers[currentFunction]];
-		PartitioningGraph::VertexIterator vIt = pGraph->getFirstIterator(); 
-		PartitioningGraph::VertexIterator vEnd = pGraph->getEndIterator();
-		for (; vIt != vEnd; ++vIt) {
-			PartitioningGraph::VertexDescriptor vd = *vIt;
-			unsigned int partitionNumber = pGraph->getPartition(vd);
-			std::vector<Instruction*> instructions = pGraph->getInstructions(vd);
-			for (std::vector<Instruction*>::iterator it = instructions.begin(); it != instructions.end(); ++it) {
-				Instruction *instr = dyn_cast<Instruction>(*it);
-				instructionsForPartition[partitionNumber].push_back(instr);
+		std::vector<std::vector<PartitioningGraph::VertexDescriptor> > &partitionOrders = schedules[currentFunction].partitionOrders;
+		for (unsigned int partitionNumber=0; partitionNumber<partitionOrders.size(); partitionNumber++) {
+			std::vector<PartitioningGraph::VertexDescriptor> &partitionOrder = partitionOrders[partitionNumber];
+			for (std::vector<PartitioningGraph::VertexDescriptor>::iterator vIt = partitionOrder.begin(); vIt != partitionOrder.end(); ++vIt) {
+				std::vector<Instruction*> instructions = pGraph->getInstructions(*vIt);
+				for (std::vector<Instruction*>::iterator it = instructions.begin(); it != instructions.end(); ++it) {
+					Instruction *instr = dyn_cast<Instruction>(*it);
+					instructionsForPartition[partitionNumber].push_back(instr);
+				}
 			}
 		}
 
@@ -589,10 +2009,21 @@ void Partitioning::savePartitioning(std::map<std::string, Function*> &functions,
 		}
 
 		// generate C code for each partition of this function and write it into template
+		// (the bodies are written at the end, because a processor partition may contain the invocation of the FPGA)
+		std::vector<std::string> functionBodies(partitioningNumbers[currentFunction]);
+		std::map<unsigned int, unsigned int> &hostPartitions = fpgaHostPartitions[currentFunction];
+		std::map<unsigned int, std::pair<std::string, std::string> > fpgaInvocations;	// start and collect code
+		unsigned int firstWaitPartition = waitPartitionNames.size();
 		for (unsigned int i=0; i<partitioningNumbers[currentFunction]; i++) {
 			std::string partitionNumber = static_cast<std::ostringstream*>( &(std::ostringstream() << i))->str();
 			std::string functionName = currentFunction + "_" + partitionNumber;
 
+			if (WaitCounters) {
+				waitPartitionNames.push_back(functionName);
+				waitPredictedCycles.push_back(criticalPathCosts[currentFunction]);
+				collectCommunication(functionName, instructionsForPartition[i], dependencyDescriptions, semaphoreDescriptions);
+			}
+
 			// create a new thread for the evaluation functions 1+
 			if (i > 0) {
 				// add thread declaration
@@ -624,28 +2055,100 @@ void Partitioning::savePartitioning(std::map<std::string, Function*> &functions,
 			// create new function
 			tWriter.setValueInSubTemplate(functionTemplate, currentFunctionUppercase + "_FUNCTIONS", functionName + "_FUNCTIONS",
 				"FUNCTION_NUMBER", partitionNumber);
-			if (deviceTypes[i] == DeviceInformation::CPU_LINUX) {
-				SimpleCCodeGenerator codeGen;
-				std::string functionBody = codeGen.createCCode(*func, instructionsForPartition[i]);
-				tWriter.setValueInSubTemplate(functionTemplate, currentFunctionUppercase + "_FUNCTIONS", functionName + "_FUNCTIONS",
-					"FUNCTION_BODY", functionBody);
+			// the start and collect code of the FPGA is inserted into the C code of its host partition
+			bool isFPGAHost = false;
+			for (std::map<unsigned int, unsigned int>::iterator hostIt = hostPartitions.begin(); hostIt != hostPartitions.end(); ++hostIt)
+				isFPGAHost |= (hostIt->second == i);
+
+			if (deviceTypes[i] == DeviceInformation::CPU_LINUX && (IROutput == "ll" || IROutput == "bc") && !isFPGAHost
+					&& !WaitCounters && !HardwareInformation::useSLPPackingForCPUs()) {
+				if (!irModule) {
+					irModule.reset(new Module("mehari_partitions", func->getContext()));
+					irModule->setDataLayout(func->getParent()->getDataLayout());
+					irModule->setTargetTriple(func->getParent()->getTargetTriple());
+				}
+				Function *partFunc = clonePartition(irModule.get(), *func, functionName + "_llvm", instructionsForPartition[i]);
+				globVarOutput << getCPrototype(*partFunc) << "\n";
+
+				// only the partition with the return instruction returns the value
+				bool returnsValue = false;
+				for (std::vector<Instruction*>::iterator it = instructionsForPartition[i].begin(); it != instructionsForPartition[i].end(); ++it)
+					if (ReturnInst *rInstr = dyn_cast<ReturnInst>(*it))
+						returnsValue |= (rInstr->getReturnValue() != NULL);
+				std::ostringstream call;
+				call << "\t" << (returnsValue ? "return " : "") << partFunc->getName().str() << "(";
+				for (Function::arg_iterator argIt = func->arg_begin(); argIt != func->arg_end(); ++argIt)
+					call << (argIt == func->arg_begin() ? "" : ", ") << argIt->getName().str();
+				call << ");\n";
+				functionBodies[i] = call.str();
+			}
+			else if (deviceTypes[i] == DeviceInformation::CPU_LINUX) {
+				CCodeBackend *cBackend = new CCodeBackend();
+				if (WaitCounters)
+					cBackend->setWaitCounters(firstWaitPartition + i, firstWaitPartition);
+				SimpleCCodeGenerator codeGen(cBackend);
+				codeGen.setSLPPacking(HardwareInformation::useSLPPackingForCPUs());
+				functionBodies[i] = codeGen.createCCode(*func, instructionsForPartition[i]);
 			} else {
 				VHDLBackend *backend = new VHDLBackend("calculation");
 				backend->setDataDependencyCount(dataDependencies.size());
+				if (CacheFPGAInputs) {
+					std::set<std::string> invariantInputs;
+					findInvariantInputs(*func, parameterInitFunctions, invariantInputs);
+					backend->setInvariantInputs(invariantInputs);
+				}
+				setOperatorLimits(backend);
+				// The static schedule needs all values of the other partitions before it sends its
+				// results, so they must not depend on them.
+				bool roundTrip = FPGAStaticSchedule && hasRoundTrip(instructionsForPartition, partitioningNumbers[currentFunction], i);
+				if (roundTrip)
+					errs() << "WARNING: Cannot schedule the hardware thread of partition " << i
+						<< " statically (it receives values that depend on its results), so it uses handshakes.\n";
+				backend->setStaticSchedule(FPGAStaticSchedule && !roundTrip);
 				SimpleCCodeGenerator codeGen(backend);
 				std::string vhdl_calculation = codeGen.createCCode(*func, instructionsForPartition[i]);
+				if (FPGAStaticSchedule && !roundTrip && !backend->isStaticallyScheduled()) {
+					errs() << "WARNING: Cannot schedule the hardware thread of partition " << i
+						<< " statically (it calls functions without a fixed latency), so it uses handshakes.\n";
+					backend->setStaticSchedule(false);
+					vhdl_calculation = codeGen.createCCode(*func, instructionsForPartition[i]);
+				}
+				errs() << backend->getResourceReport();
 
 				// writeToFile creates the directory, if it doesn't exist
 				TemplateWriter::writeToFile(fpgaCalcOutput, vhdl_calculation);
 				saveOperator(reconosOutput, backend->getReconOSOperator(), hardwareThreadName);
 
+				// the version of the cached inputs replaces the start word
+				std::string startWord = (backend->hasCachedInputs() ? "" : "\tmbox_put(&mbox_start, 42);\n");
+				std::string startCode = startWord + prefixAllLines("\t", backend->getStartCode());
+				std::string collectCode = prefixAllLines("\t", backend->getCollectCode()) + "\t(void)mbox_get(&mbox_stop);\n";
+				if (AtomicFPGAMessages) {
+					startCode = "\tfpga_ticket = mehari_message_send_begin(&fpga_messages);\n"
+						+ startCode + "\tmehari_message_send_end(&fpga_messages);\n";
+					collectCode = "\tmehari_message_receive_begin(&fpga_messages, fpga_ticket);\n"
+						+ collectCode + "\tmehari_message_receive_end(&fpga_messages);\n";
+				}
 				std::ostringstream body;
-				body << "\tmbox_put(&mbox_start, 42);\n\n"
-				     << prefixAllLines("\t", backend->getInterfaceCode()) << "\n"
-				     << "\t(void)mbox_get(&mbox_stop);\n";
-
-				tWriter.setValueInSubTemplate(functionTemplate, currentFunctionUppercase + "_FUNCTIONS", functionName + "_FUNCTIONS",
-					"FUNCTION_BODY", body.str());
+				if (contains(hostPartitions, i)) {
+					// split-phase: the host partition starts the FPGA and collects the results where they are needed
+					fpgaInvocations[i] = std::make_pair(startCode, collectCode);
+					body << "\t// the FPGA is started and collected by partition " << hostPartitions[i] << "\n";
+				}
+				else if (WaitCounters) {
+					std::string waitPartition = static_cast<std::ostringstream*>( &(std::ostringstream() << (firstWaitPartition + i)))->str();
+					body << "\tuint64_t _mehari_wait_start, _mehari_partition_start = _mehari_wait_begin();\n"
+					     << startCode << "\n"
+					     << "\t_mehari_wait_start = _mehari_wait_begin();\n"
+					     << collectCode
+					     << "\t_mehari_wait_end(" << waitPartition << ", MEHARI_WAIT_FPGA, " << waitPartition << ", _mehari_wait_start);\n"
+					     << "\t_mehari_partition_end(" << waitPartition << ", _mehari_partition_start);\n";
+				}
+				else {
+					body << startCode << "\n"
+					     << collectCode;
+				}
+				functionBodies[i] = body.str();
 
 
 				GenerateHardwareThreadFileFromTemplate ghtfft = { TemplateDir, hardwareThreadDir,
@@ -655,15 +2158,65 @@ void Partitioning::savePartitioning(std::map<std::string, Function*> &functions,
 				ghtfft.generate("hwt.tcl.tpl",    "data/" + hardwareThreadName + "_v2_1_0.tcl");
 				ghtfft.generate("setup_zynq.tpl", "../setup_zynq");
 
+				if (EmulateFPGA) {
+					// each hardware thread registers itself for its slot
+					std::string slot = static_cast<std::ostringstream*>( &(std::ostringstream() << hwThreadCount))->str();
+					writeEmulatedHardwareThread(OutputDir + "/linux/" + hardwareThreadName + "_" + slot + "_emulation.c", hwThreadCount,
+						*func, instructionsForPartition[i], backend, dataDependencies.size(), globalVariables, parameterInitFunctions);
+				}
+
 				// increment hardware thread count to write it to template
 				hwThreadCount++;
 			}
 		}
 
+		// replace the markers of the split-phase invocations and write the function bodies
+		for (std::map<unsigned int, std::pair<std::string, std::string> >::iterator it = fpgaInvocations.begin(); it != fpgaInvocations.end(); ++it) {
+			std::string &hostBody = functionBodies[hostPartitions[it->first]];
+			std::string partitionNumber = static_cast<std::ostringstream*>( &(std::ostringstream() << it->first))->str();
+			hostBody = replace("\t_fpga_start(" + partitionNumber + ");\n", it->second.first, hostBody);
+			hostBody = replace("\t_fpga_collect(" + partitionNumber + ");\n", it->second.second, hostBody);
+		}
+		for (unsigned int i=0; i<partitioningNumbers[currentFunction]; i++) {
+			std::string partitionNumber = static_cast<std::ostringstream*>( &(std::ostringstream() << i))->str();
+			std::string functionName = currentFunction + "_" + partitionNumber;
+			tWriter.setValueInSubTemplate(functionTemplate, currentFunctionUppercase + "_FUNCTIONS", functionName + "_FUNCTIONS",
+				"FUNCTION_BODY", functionBodies[i]);
+		}
+
 		// update parameter start index for the next function
 		putParamStart += (partitioningNumbers[currentFunction]-1);
 	}
 
+	if (irModule) {
+		std::string contents;
+		raw_string_ostream stream(contents);
+		if (IROutput == "bc")
+			WriteBitcodeToFile(irModule.get(), stream);
+		else
+			irModule->print(stream, NULL);
+		stream.flush();
+		TemplateWriter::writeToFile(OutputDir + "/linux/partitions." + IROutput, contents);
+	}
+
+	// the tables of the wait counters need the communication of all partitions
+	if (WaitCounters) {
+		globVarOutput << "#include \"mehari_waits.h\"\n";
+		writeCStringArray(globVarOutput, "mehari_wait_partitions", waitPartitionNames);
+		globVarOutput << "static const uint32_t mehari_wait_predicted_cycles[] = {";
+		for (std::vector<unsigned int>::iterator it = waitPredictedCycles.begin(); it != waitPredictedCycles.end(); ++it)
+			globVarOutput << (it == waitPredictedCycles.begin() ? " " : ", ") << *it;
+		globVarOutput << " };\n";
+		writeCStringArray(globVarOutput, "mehari_wait_dependencies", describeCommunication(dependencyDescriptions));
+		writeCStringArray(globVarOutput, "mehari_wait_semaphores", describeCommunication(semaphoreDescriptions));
+		globVarOutput << "__attribute__((constructor)) static void mehari_wait_counters_init(void)\n{\n"
+		              << "\t_mehari_waits_init(mehari_wait_partitions, mehari_wait_predicted_cycles, " << waitPartitionNames.size() << ",\n"
+		              << "\t\tmehari_wait_dependencies, " << dependencyDescriptions.size() << ",\n"
+		              << "\t\tmehari_wait_semaphores, " << semaphoreDescriptions.size() << ");\n"
+		              << "}\n";
+	}
+	tWriter.setValue("GLOBAL_VARIABLES", globVarOutput.str());
+
 	// after counting all hardware threads now we can insert the number into the template
 	std::string hwThreadCountStr = static_cast<std::ostringstream*>( &(std::ostringstream() << hwThreadCount))->str();
 	tWriter.setValue("THREAD_COUNT_HW", hwThreadCountStr);
@@ -15,6 +15,28 @@
 AbstractPartitioningMethod::~AbstractPartitioningMethod() {}
 
 
+AbstractPartitioningMethod *createPartitioningMethod(const std::string &name) {
+	if (name == "random")
+		return new RandomPartitioning();
+	else if (name == "clustering")
+		return new HierarchicalClustering();
+	else if (name == "sa")
+		return new SimulatedAnnealing();
+	else if (name == "k-lin")
+		return new KernighanLin();
+	return NULL;
+}
+
+
+void createInitialPartitioning(const std::string &name, PartitioningGraph &pGraph, std::vector<std::string> &targetDevices) {
+	RandomPartitioning rPM;
+	if (name == "k-lin")
+		rPM.balancedBiPartitioning(pGraph);
+	else if (name == "sa")
+		rPM.apply(pGraph, targetDevices);
+}
+
+
 // -----------------------------------
 // Random Partitioning
 // -----------------------------------
@@ -336,6 +358,9 @@ unsigned int SimulatedAnnealing::apply(PartitioningGraph &pGraph, std::vector<st
 	iterationMax = std::min(iterationMax, 2000);
 	tempAcceptenceMultiplicator = 3.0;
 	tempDecreasingFactor = 0.95;
+	// moving a vertex that is not on the critical path cannot improve the critical path,
+	// so choose the vertex for a move from the critical vertices in most cases
+	criticalMoveProbability = 0.75;
 
 	// run simulated annealing algorithm
 	simulatedAnnealing(pGraph, Tinit);
@@ -350,6 +375,7 @@ void SimulatedAnnealing::simulatedAnnealing(State &state, Temperature initialTem
 	Temperature T = initialTemperature;
 	
 	srand(time(0));
+	updateCriticalVertices(S);
 
 	while (!frozen(T)) {
 		int itCount = 0;
@@ -363,6 +389,7 @@ void SimulatedAnnealing::simulatedAnnealing(State &state, Temperature initialTem
 			if (acceptNewState(deltaCostNorm, T) > randomNumber()) {
 				S = newS;
 				currentCost = newCost;
+				updateCriticalVertices(S);
 			}
 			itCount++;
 		}
@@ -413,7 +440,11 @@ float SimulatedAnnealing::normalizeCostDifference(int deltaCost, unsigned int K)
 
 void SimulatedAnnealing::randomMove(State &state) {
 	// NOTE: the state is stored in a PartitioningGraph
-	PartitioningGraph::VertexDescriptor vd = state.getRandomVertex();
+	PartitioningGraph::VertexDescriptor vd;
+	if (!criticalVertices.empty() && randomNumber() < criticalMoveProbability)
+		vd = criticalVertices[rand() % criticalVertices.size()];
+	else
+		vd = state.getRandomVertex();
 	unsigned int oldPartition = state.getPartition(vd);
 	unsigned int newPartition;
 	do {
@@ -423,6 +454,11 @@ void SimulatedAnnealing::randomMove(State &state) {
 }
 
 
+void SimulatedAnnealing::updateCriticalVertices(State &state) {
+	criticalVertices = state.getCriticalVertices(devices);
+}
+
+
 double SimulatedAnnealing::randomNumber(void) {
 	return (rand() / double(RAND_MAX));
 }
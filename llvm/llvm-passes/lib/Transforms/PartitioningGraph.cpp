@@ -1,21 +1,27 @@
 #include "mehari/Transforms/PartitioningGraph.h"
+#include "mehari/Transforms/ListScheduler.h"
 
 #include "llvm/IR/Instructions.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "mehari/HardwareInformation.h"
+#include "mehari/Analysis/SLPPacking.h"
 #include "mehari/CodeGen/SimpleCCodeGenerator.h"
+#include "mehari/CodeGen/GenerateVHDL.h"
+#include "mehari/utils/ContainerUtils.h"
 
 // user RandomGenerator and random_vertex
 #include <boost/graph/random.hpp>
 #include <boost/random.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <boost/graph/iteration_macros.hpp>
-#include <boost/graph/bellman_ford_shortest_paths.hpp>
 
 #include <ctime> // for using random generator with time
+#include <fstream>
 #include <sstream>
 #include <set>
+#include <algorithm>
 
 
 PartitioningGraph::PartitioningGraph() {}
@@ -27,6 +33,10 @@ PartitioningGraph::PartitioningGraph(const PartitioningGraph &cSource) {
 	instructionList = cSource.instructionList;
 	copyGraph(cSource.pGraph, pGraph);
 	initVertex = cSource.initVertex;
+	measuredDevice = cSource.measuredDevice;
+	measuredCycles = cSource.measuredCycles;
+	blockFrequencies = cSource.blockFrequencies;
+	orderingConstraints = cSource.orderingConstraints;
 }
 
 PartitioningGraph &PartitioningGraph::operator=(const PartitioningGraph &cSource) {
@@ -38,6 +48,10 @@ PartitioningGraph &PartitioningGraph::operator=(const PartitioningGraph &cSource
 	instructionList = cSource.instructionList;
 	copyGraph(cSource.pGraph, pGraph);
 	initVertex = cSource.initVertex;
+	measuredDevice = cSource.measuredDevice;
+	measuredCycles = cSource.measuredCycles;
+	blockFrequencies = cSource.blockFrequencies;
+	orderingConstraints = cSource.orderingConstraints;
 
 	return *this;
 }
@@ -74,15 +88,18 @@ void PartitioningGraph::createVertices(std::vector<Instruction*> &instructions)
 	pGraph[initVertex].name = "init";
 	pGraph[initVertex].partition = -1;
 	std::vector<Instruction*> currentInstrutions;
+	std::vector<unsigned int> currentInstructionIds;
 	for (std::vector<Instruction*>::iterator instrIt = instructions.begin(); instrIt != instructions.end(); ++instrIt) {
 		Instruction *instr = dyn_cast<Instruction>(*instrIt);
 		currentInstrutions.push_back(instr);
+		currentInstructionIds.push_back(instrNumber);
 		// handle init vertex
 		if (instrNumber == 2*paramCount-1) {
 				pGraph[initVertex].instructions = currentInstrutions;
 				// save the instruction list the graph is based on
 				addInstructionsToList(currentInstrutions);
 				currentInstrutions.clear();
+				currentInstructionIds.clear();
 		}
 		// handle the calculations
 		else if (instrNumber >= 2*paramCount) {
@@ -116,9 +133,11 @@ void PartitioningGraph::createVertices(std::vector<Instruction*> &instructions)
 					ss << vertexNumber++;
 					pGraph[newVertex].name = ss.str();
 					pGraph[newVertex].instructions = currentInstrutions;
+					pGraph[newVertex].instructionIds = currentInstructionIds;
 					pGraph[newVertex].partition = 0;
 					addInstructionsToList(currentInstrutions);
 					currentInstrutions.clear();
+					currentInstructionIds.clear();
 					isBlock = false;
 					isBlockCompleted = false;
 				}
@@ -158,13 +177,20 @@ void PartitioningGraph::addEdges(InstructionDependencyList &dependencies) {
 				Graph::edge_descriptor ed;
 				bool inserted;
 				boost::tie(ed, inserted) = boost::add_edge(dependencyVertex, targetVertex, pGraph);
+				Communication &com = pGraph[ed];
 				CommunicationType newCommunication;
 				// TODO: find appropriate values for data and memory dependency costs
-				if (depIt->isRegdep) // register depdendency -> use of a data dependency method (e.g. mbox)
+				if (depIt->isRegdep) { // register depdendency -> use of a data dependency method (e.g. mbox)
 					newCommunication = DataDependency;
+					// a value is only sent once, even if several instructions of the target use it
+					if (std::find(com.comSources.begin(), com.comSources.end(), depIt->depInstruction) != com.comSources.end())
+						continue;
+				}
 				else // memory or control dependency -> use of a semaphore
 					newCommunication = OrderDependency;
-				pGraph[ed].comOperations.push_back(newCommunication);
+				com.comOperations.push_back(newCommunication);
+				com.comInstructions.push_back(*instrIt);
+				com.comSources.push_back(depIt->depInstruction);
 			}	
 		}
 	}
@@ -266,6 +292,13 @@ unsigned int PartitioningGraph::getPartition(VertexDescriptor vd) {
 
 void PartitioningGraph::setInstructions(VertexDescriptor vd, std::vector<Instruction*> &instructions) {
 	pGraph[vd].instructions = instructions;
+	orderingConstraints.reset();
+
+	// the costs of the vertex and its incoming edges (probability of the target instruction) change
+	pGraph[vd].executionTimes.clear();
+	Graph::in_edge_iterator ieIt, ieEnd;
+	for (boost::tie(ieIt, ieEnd) = boost::in_edges(vd, pGraph); ieIt != ieEnd; ++ieIt)
+		pGraph[*ieIt].comCosts.clear();
 }
 
 
@@ -274,26 +307,69 @@ std::vector<Instruction*> &PartitioningGraph::getInstructions(VertexDescriptor v
 }
 
 
+// number of 32 bit words that are needed to send the value of an instruction
+static unsigned int getWordCount(Instruction *instr) {
+	if (instr == NULL)
+		return 1;
+	// for a store we send the stored value
+	Type *type = (instr->getType()->isVoidTy() && instr->getNumOperands() > 0) ? instr->getOperand(0)->getType() : instr->getType();
+	unsigned int bits = type->getPrimitiveSizeInBits();
+	return std::max(1u, (bits + 31) / 32);
+}
+
+
 unsigned int PartitioningGraph::calcEdgeCost(EdgeDescriptor ed, 
 		std::string &sourceDevice, std::string &targetDevice) {
-	unsigned int costs = 0;
+	Communication &com = pGraph[ed];
+	DevicePair devices(sourceDevice, targetDevice);
+	std::map<DevicePair, unsigned int>::iterator cacheIt = com.comCosts.find(devices);
+	if (cacheIt != com.comCosts.end())
+		return cacheIt->second;
+
+	float costs = 0, messageExecutions = 0;
 	HardwareInformation hwInfo;
   	DeviceInformation *devInfo = hwInfo.getDeviceInfo(sourceDevice);
   	CommunicationInformation *comInfo = devInfo->getCommunicationInfo(targetDevice);
-  	for (std::vector<CommunicationType>::iterator it = pGraph[ed].comOperations.begin(); 
-		it != pGraph[ed].comOperations.end(); ++it) 
-		costs += comInfo->getCommunicationCost(*it);
-	return costs;
+	for (unsigned int i=0; i<com.comOperations.size(); i++) {
+		// the communication is needed each time the target instruction is executed
+		Instruction *tgtInstr = (i < com.comInstructions.size() ? com.comInstructions[i] : NULL);
+		float executions = getExpectedExecutionCount(boost::target(ed, pGraph), tgtInstr);
+		if (com.comOperations[i] == DataDependency) {
+			// the values of an edge are sent in one message
+			messageExecutions = std::max(messageExecutions, executions);
+			costs += executions * getWordCount(i < com.comSources.size() ? com.comSources[i] : NULL) 
+				* comInfo->getCommunicationCost(DataWord);
+		}
+		else
+			costs += executions * comInfo->getCommunicationCost(com.comOperations[i]);
+	}
+	costs += messageExecutions * comInfo->getCommunicationCost(DataDependency);
+	return com.comCosts[devices] = (unsigned int)(costs + 0.5);
 }
 
 
 unsigned int PartitioningGraph::calcDeviceIndependentEdgeCost(EdgeDescriptor ed) {
-	unsigned int costs = 0;
+	Communication &com = pGraph[ed];
+	DevicePair noDevices("", "");
+	std::map<DevicePair, unsigned int>::iterator cacheIt = com.comCosts.find(noDevices);
+	if (cacheIt != com.comCosts.end())
+		return cacheIt->second;
+
+	float costs = 0, messageExecutions = 0;
 	HardwareInformation hwInfo;
-  	for (std::vector<CommunicationType>::iterator it = pGraph[ed].comOperations.begin(); 
-		it != pGraph[ed].comOperations.end(); ++it) 
-		costs += hwInfo.getDeviceIndependentCommunicationCost(*it);
-	return costs;
+	for (unsigned int i=0; i<com.comOperations.size(); i++) {
+		Instruction *tgtInstr = (i < com.comInstructions.size() ? com.comInstructions[i] : NULL);
+		float executions = getExpectedExecutionCount(boost::target(ed, pGraph), tgtInstr);
+		if (com.comOperations[i] == DataDependency) {
+			messageExecutions = std::max(messageExecutions, executions);
+			costs += executions * getWordCount(i < com.comSources.size() ? com.comSources[i] : NULL) 
+				* hwInfo.getDeviceIndependentCommunicationCost(DataWord);
+		}
+		else
+			costs += executions * hwInfo.getDeviceIndependentCommunicationCost(com.comOperations[i]);
+	}
+	costs += messageExecutions * hwInfo.getDeviceIndependentCommunicationCost(DataDependency);
+	return com.comCosts[noDevices] = (unsigned int)(costs + 0.5);
 }
 
 
@@ -327,16 +403,97 @@ unsigned int PartitioningGraph::getDeviceIndependentCommunicationCost(VertexDesc
 
 
 unsigned int PartitioningGraph::getExecutionTime(VertexDescriptor vd, std::string &targetDevice) {
-	// TODO: implement this function by using the HardwareInformation class
+	// the costs are calculated once for each device (or loaded with the graph)
+	std::map<std::string, unsigned int>::iterator cacheIt = pGraph[vd].executionTimes.find(targetDevice);
+	if (cacheIt != pGraph[vd].executionTimes.end())
+		return cacheIt->second;
+
 	HardwareInformation hwInfo;
 	DeviceInformation *devInfo = hwInfo.getDeviceInfo(targetDevice);
-	unsigned int texe = 0;
+	bool useMeasuredCycles = measuredCycles && targetDevice == measuredDevice;
+	float texe = 0;
 	std::vector<Instruction*> instrList = getInstructions(vd);
+	// the code generator executes the same pairs of operations together
+	boost::scoped_ptr<SLPPacking> packing;
+	if (HardwareInformation::useSLPPackingForCPUs() && devInfo->getType() == DeviceInformation::CPU_LINUX)
+		packing.reset(new SLPPacking(instrList));
+	// vertices that we cannot generate hardware for are as expensive as a call, so they stay on a CPU
+	if (devInfo->getType() == DeviceInformation::FPGA_RECONOS && !isFPGAEligible(vd))
+		texe += devInfo->getInstructionInfo("call")->getCycleCount();
 	for (std::vector<Instruction*>::iterator it = instrList.begin(); it != instrList.end(); ++it) {
-		InstructionInformation *instrInfo = devInfo->getInstructionInfo(*it);
-		instrInfo != NULL ? texe += instrInfo->getCycleCount() : texe += 1;		
+		unsigned int cycles;
+		std::map<Instruction*, unsigned int>::iterator measuredIt;
+		InstructionInformation *packInfo = NULL;
+		if (useMeasuredCycles && (measuredIt = measuredCycles->find(*it)) != measuredCycles->end())
+			cycles = measuredIt->second;
+		else if (packing && packing->getPack(*it) && (packInfo = devInfo->getPackedInstructionInfo(*it)) != NULL)
+			// the second operation of a pair counts the costs of both
+			cycles = (packing->isFirstOfPack(*it) ? 0 : packInfo->getCycleCount());
+		else {
+			InstructionInformation *instrInfo = devInfo->getInstructionInfo(*it);
+			instrInfo != NULL ? cycles = instrInfo->getCycleCount() : cycles = 1;
+		}
+		// instructions in conditional regions and loops count with their expected number of executions
+		texe += getExpectedExecutionCount(vd, *it) * cycles;
+	}
+	return pGraph[vd].executionTimes[targetDevice] = (unsigned int)(texe + 0.5);
+}
+
+bool PartitioningGraph::isFPGAEligible(VertexDescriptor vd) {
+	std::vector<Instruction*> &instrList = getInstructions(vd);
+	for (std::vector<Instruction*>::iterator it = instrList.begin(); it != instrList.end(); ++it)
+		if (!VHDLBackend::isSupported(*it))
+			return false;
+	return true;
+}
+
+
+void PartitioningGraph::setMeasuredExecutionTimes(const std::string &device, std::map<Instruction*, unsigned int> &cycles) {
+	// the measured values are shared between all copies of the graph
+	measuredDevice = device;
+	measuredCycles.reset(new std::map<Instruction*, unsigned int>(cycles));
+	clearCostCache();
+}
+
+
+void PartitioningGraph::setBlockFrequencies(std::map<BasicBlock*, float> &frequencies) {
+	blockFrequencies.reset(new std::map<BasicBlock*, float>(frequencies));
+	clearCostCache();
+}
+
+
+void PartitioningGraph::clearCostCache(void) {
+	VertexIterator vIt, vEnd;
+	for (boost::tie(vIt, vEnd) = boost::vertices(pGraph); vIt != vEnd; ++vIt)
+		pGraph[*vIt].executionTimes.clear();
+	EdgeIterator eIt, eEnd;
+	for (boost::tie(eIt, eEnd) = boost::edges(pGraph); eIt != eEnd; ++eIt)
+		pGraph[*eIt].comCosts.clear();
+}
+
+
+float PartitioningGraph::getExpectedExecutionCount(VertexDescriptor vd, Instruction *instr) {
+	// the frequencies are relative to the function, so we divide by the frequency of the vertex
+	if (!blockFrequencies || instr == NULL || pGraph[vd].instructions.empty())
+		return 1.0;
+
+	std::map<BasicBlock*, float>::iterator entryIt, blockIt;
+	entryIt = blockFrequencies->find(pGraph[vd].instructions.front()->getParent());
+	blockIt = blockFrequencies->find(instr->getParent());
+	if (entryIt == blockFrequencies->end() || blockIt == blockFrequencies->end() || entryIt->second <= 0)
+		return 1.0;
+
+	return blockIt->second / entryIt->second;
+}
+
+
+PartitioningGraph::VertexPairList &PartitioningGraph::getOrderingConstraints(void) {
+	// the constraints do not depend on the partitioning, so we only calculate them once
+	if (!orderingConstraints) {
+		orderingConstraints.reset(new VertexPairList());
+		ListScheduler::calcOrderingConstraints(*this, *orderingConstraints);
 	}
-	return texe;
+	return *orderingConstraints;
 }
 
 
@@ -365,101 +522,335 @@ boost::tuple<unsigned int, unsigned int> PartitioningGraph::getInternalExternalC
 
 
 unsigned int PartitioningGraph::getCriticalPathCost(std::vector<std::string> &partitioningDevices) {
-	// create new simple graph type for critical path analysis
-	typedef boost::adjacency_list<
-		boost::setS, 				// store out-edges of each vertex in a set to avoid parallel edges
-		boost::vecS, 				// store vertex set in a std::vector
-		boost::directedS, 			// the graph has got directed edges
-		boost::no_property,			// the vertices have no property
-		boost::property<boost::edge_weight_t, int>	// the edges weight is of integer type
-		> cpGraph;
-
-	// new graph
-	cpGraph tmpGraph;
-
-	// copy vertices to new graph
-	for (unsigned int i=0; i<boost::num_vertices(pGraph); i++)
-		boost::add_vertex(tmpGraph);
-
-	// create edges and set edge weight of new Graph:
+	return getCriticalityAnalysis(partitioningDevices).criticalPathCost;
+}
+
+
+PartitioningGraph::CriticalityAnalysis PartitioningGraph::getCriticalityAnalysis(std::vector<std::string> &partitioningDevices) {
+	unsigned int vertexCount = boost::num_vertices(pGraph);
+
+	CriticalityAnalysis analysis;
+	analysis.criticalPathCost = 0;
+	analysis.vertexTimings.resize(vertexCount);
+
+	// execution time of each vertex on the device of its partition
+	std::vector<unsigned int> executionTimes(vertexCount);
+	for (unsigned int i=0; i<vertexCount; i++)
+		executionTimes[i] = getExecutionTime(i, partitioningDevices[pGraph[i].partition]);
+
+	// create the edges of the schedule:
 	// only keep communication cost if the two vertices of the are in different partitions
-	// add execution time of the target vertex to each edge weight
+	typedef std::pair<VertexDescriptor, unsigned int> ScheduleEdge; // (vertex, communication cost)
+	std::vector<std::vector<ScheduleEdge> > successors(vertexCount), predecessors(vertexCount);
 	EdgeIterator eIt, eEnd;
-	boost::tie(eIt, eEnd) = boost::edges(pGraph);
-	for( ; eIt != eEnd; ++eIt) {
-		// calculate edge weight
-		int edgeWeight = 0;
+	for (boost::tie(eIt, eEnd) = boost::edges(pGraph); eIt != eEnd; ++eIt) {
 		VertexDescriptor u = boost::source(*eIt, pGraph), v = boost::target(*eIt, pGraph);
+		unsigned int comCost = 0;
 		if (pGraph[u].partition != pGraph[v].partition)
-			edgeWeight += calcEdgeCost(*eIt, partitioningDevices[pGraph[u].partition], partitioningDevices[pGraph[v].partition]);
-		edgeWeight += getExecutionTime(v, partitioningDevices[pGraph[v].partition]);
-		edgeWeight *= (-1);
-		// create new edge and set edge weight in temporary graph
-		boost::add_edge(u, v, edgeWeight, tmpGraph);
-	}
-
-	// if we calculate the critical path for a processor execution, we need to schedule the operations
-	// if we use a FPGA we can run everything in parallel, so we do not need a scheduling
-	// we can create a schedule for a partition that is executed on the processor
-	// by connecting every consecutive vertices (determined by vertex number) of the same partition
-
-	// TODO: use a parameter to get the partitions and also the device that is used by the partition
-	// 		 to only apply this modification for processor partitions
-	// collect the used partitions 
-	if (true) {
-		std::set<unsigned int> partitions;
-		for (unsigned int i=0; i<boost::num_vertices(pGraph); i++)
-			partitions.insert(pGraph[i].partition);
-		// create a schedule for each partition
-		for (std::set<unsigned int>::iterator it = partitions.begin(); it != partitions.end(); ++it) {
-			int currentVertex = (-1);
-			for (int i=boost::num_vertices(pGraph)-1; i>=0; i--) {
-				// check the current partition
-				if (pGraph[i].partition == *it) {
-					if (currentVertex >= 0) {
-						// add an edge with the edge cost of the execution time of the target vertex 
-						// if there is no edge yet
-						bool exists = boost::edge(i, currentVertex, tmpGraph).second;
-						if (!exists) 
-							boost::add_edge(i, currentVertex, (-1)*getExecutionTime(currentVertex, 
-								partitioningDevices[pGraph[currentVertex].partition]), tmpGraph);
-					}
-					currentVertex = i;
-				}
+			comCost = calcEdgeCost(*eIt, partitioningDevices[pGraph[u].partition], partitioningDevices[pGraph[v].partition]);
+		successors[u].push_back(ScheduleEdge(v, comCost));
+		predecessors[v].push_back(ScheduleEdge(u, comCost));
+	}
+
+	// vertices of the same partition that access the same memory etc. have to keep their order
+	VertexPairList &constraints = getOrderingConstraints();
+	for (VertexPairList::iterator it = constraints.begin(); it != constraints.end(); ++it) {
+		if (pGraph[it->first].partition != pGraph[it->second].partition)
+			continue;
+		successors[it->first].push_back(ScheduleEdge(it->second, 0));
+		predecessors[it->second].push_back(ScheduleEdge(it->first, 0));
+	}
+
+	// a processor executes the vertices of its partition one after another in the order that 
+	// is determined by the list scheduler (and that is used by the code generator),
+	// the FPGA can run independent vertices in parallel
+	ListScheduler::Schedule schedule = ListScheduler().schedule(*this, partitioningDevices);
+	for (unsigned int p=0; p<schedule.partitionOrders.size(); p++) {
+		std::vector<VertexDescriptor> &partitionOrder = schedule.partitionOrders[p];
+		if (!schedule.isSequential[p])
+			continue;
+		for (unsigned int i=1; i<partitionOrder.size(); i++) {
+			successors[partitionOrder[i-1]].push_back(ScheduleEdge(partitionOrder[i], 0));
+			predecessors[partitionOrder[i]].push_back(ScheduleEdge(partitionOrder[i-1], 0));
+		}
+	}
+
+	// determine a topological order of the schedule
+	std::vector<VertexDescriptor> order;
+	std::vector<unsigned int> remainingPredecessors(vertexCount);
+	for (unsigned int i=0; i<vertexCount; i++) {
+		remainingPredecessors[i] = predecessors[i].size();
+		if (remainingPredecessors[i] == 0)
+			order.push_back(i);
+	}
+	for (unsigned int i=0; i<order.size(); i++) {
+		for (std::vector<ScheduleEdge>::iterator it = successors[order[i]].begin(); it != successors[order[i]].end(); ++it)
+			if (--remainingPredecessors[it->first] == 0)
+				order.push_back(it->first);
+	}
+	if (order.size() != vertexCount) {
+		errs() << "ERROR: The partitioning graph contains a cycle. The critical path could not be determined!\n";
+		return analysis;
+	}
+
+	// earliest start: longest path from any start vertex to the vertex
+	for (std::vector<VertexDescriptor>::iterator vIt = order.begin(); vIt != order.end(); ++vIt) {
+		Timing &timing = analysis.vertexTimings[*vIt];
+		for (std::vector<ScheduleEdge>::iterator it = predecessors[*vIt].begin(); it != predecessors[*vIt].end(); ++it)
+			timing.earliestStart = std::max(timing.earliestStart, 
+				analysis.vertexTimings[it->first].earliestStart + executionTimes[it->first] + it->second);
+		analysis.criticalPathCost = std::max(analysis.criticalPathCost, timing.earliestStart + executionTimes[*vIt]);
+	}
+
+	// the results of the FPGA have to be collected by a processor before the function is finished:
+	// either in the first processor partition, which can work on other vertices in the meantime (split-phase),
+	// or by a thread that waits for the FPGA and has to notify the calling thread afterwards
+	HardwareInformation hwInfo;
+	std::vector<unsigned int> partitionTails(partitioningDevices.size(), 0);
+	std::string hostDevice;
+	for (std::vector<std::string>::iterator it = partitioningDevices.begin(); it != partitioningDevices.end() && hostDevice.empty(); ++it)
+		if (hwInfo.getDeviceInfo(*it)->getType() == DeviceInformation::CPU_LINUX)
+			hostDevice = *it;
+	if (!hostDevice.empty()) {
+		for (unsigned int p=0; p<partitioningDevices.size(); p++) {
+			DeviceInformation *devInfo = hwInfo.getDeviceInfo(partitioningDevices[p]);
+			if (devInfo->getType() != DeviceInformation::FPGA_RECONOS)
+				continue;
+			partitionTails[p] = devInfo->getCommunicationInfo(hostDevice)->getCommunicationCost(DataDependency);
+			if (!HardwareInformation::useSplitPhaseFPGAInvocation())
+				partitionTails[p] += hwInfo.getDeviceInfo(hostDevice)->getCommunicationInfo(hostDevice)->getCommunicationCost(OrderDependency);
+		}
+		for (unsigned int i=0; i<vertexCount; i++)
+			analysis.criticalPathCost = std::max(analysis.criticalPathCost, 
+				analysis.vertexTimings[i].earliestStart + executionTimes[i] + partitionTails[pGraph[i].partition]);
+	}
+
+	// latest start: latest time that does not extend the critical path
+	for (std::vector<VertexDescriptor>::reverse_iterator vIt = order.rbegin(); vIt != order.rend(); ++vIt) {
+		Timing &timing = analysis.vertexTimings[*vIt];
+		unsigned int latestEnd = analysis.criticalPathCost - partitionTails[pGraph[*vIt].partition];
+		for (std::vector<ScheduleEdge>::iterator it = successors[*vIt].begin(); it != successors[*vIt].end(); ++it)
+			latestEnd = std::min(latestEnd, analysis.vertexTimings[it->first].latestStart - it->second);
+		timing.latestStart = latestEnd - executionTimes[*vIt];
+		timing.slack = timing.latestStart - timing.earliestStart;
+	}
+
+	// the communication of an edge can start when the source vertex has finished
+	for (boost::tie(eIt, eEnd) = boost::edges(pGraph); eIt != eEnd; ++eIt) {
+		VertexDescriptor u = boost::source(*eIt, pGraph), v = boost::target(*eIt, pGraph);
+		unsigned int comCost = 0;
+		if (pGraph[u].partition != pGraph[v].partition)
+			comCost = calcEdgeCost(*eIt, partitioningDevices[pGraph[u].partition], partitioningDevices[pGraph[v].partition]);
+		Timing &timing = analysis.getEdgeTiming(u, v);
+		timing.earliestStart = analysis.vertexTimings[u].earliestStart + executionTimes[u];
+		timing.latestStart = analysis.vertexTimings[v].latestStart - comCost;
+		timing.slack = timing.latestStart - timing.earliestStart;
+	}
+
+	return analysis;
+}
+
+
+std::vector<PartitioningGraph::VertexDescriptor> PartitioningGraph::getCriticalVertices(std::vector<std::string> &partitioningDevices) {
+	CriticalityAnalysis analysis = getCriticalityAnalysis(partitioningDevices);
+	std::vector<VertexDescriptor> criticalVertices;
+	for (unsigned int i=0; i<analysis.vertexTimings.size(); i++)
+		if (analysis.isCritical(i))
+			criticalVertices.push_back(i);
+	return criticalVertices;
+}
+
+
+bool PartitioningGraph::save(const std::string &filename, const std::string &functionName, std::vector<std::string> &devices) {
+	// file format (one entry per line, '#' starts a comment):
+	//   graph <function name> <vertex count>
+	//   devices <device count> <device>...
+	//   vertex <index> <name> <partition> <execution time for each device> <instruction count> <instruction id>...
+	//   edge <source> <target> <device independent cost> <cost for each pair of source and target device>
+	//   order <first vertex> <second vertex>
+	std::ofstream file(filename.c_str());
+	if (!file.is_open()) {
+		errs() << "ERROR: Could not write partitioning graph " << filename << "\n";
+		return false;
+	}
+
+	file << "# mehari partitioning graph\n";
+	file << "graph " << functionName << " " << getVertexCount() << "\n";
+	file << "devices " << devices.size();
+	for (std::vector<std::string>::iterator it = devices.begin(); it != devices.end(); ++it)
+		file << " " << *it;
+	file << "\n";
+
+	VertexIterator vIt, vEnd;
+	for (boost::tie(vIt, vEnd) = boost::vertices(pGraph); vIt != vEnd; ++vIt) {
+		ComputationUnit &cu = pGraph[*vIt];
+		file << "vertex " << *vIt << " " << cu.name << " " << cu.partition;
+		for (std::vector<std::string>::iterator it = devices.begin(); it != devices.end(); ++it)
+			file << " " << getExecutionTime(*vIt, *it);
+		file << " " << cu.instructionIds.size();
+		for (std::vector<unsigned int>::iterator it = cu.instructionIds.begin(); it != cu.instructionIds.end(); ++it)
+			file << " " << *it;
+		file << "\n";
+	}
+
+	EdgeIterator eIt, eEnd;
+	for (boost::tie(eIt, eEnd) = boost::edges(pGraph); eIt != eEnd; ++eIt) {
+		file << "edge " << boost::source(*eIt, pGraph) << " " << boost::target(*eIt, pGraph) 
+			<< " " << calcDeviceIndependentEdgeCost(*eIt);
+		for (std::vector<std::string>::iterator srcIt = devices.begin(); srcIt != devices.end(); ++srcIt)
+			for (std::vector<std::string>::iterator tgtIt = devices.begin(); tgtIt != devices.end(); ++tgtIt)
+				file << " " << calcEdgeCost(*eIt, *srcIt, *tgtIt);
+		file << "\n";
+	}
+
+	VertexPairList &constraints = getOrderingConstraints();
+	for (VertexPairList::iterator it = constraints.begin(); it != constraints.end(); ++it)
+		file << "order " << it->first << " " << it->second << "\n";
+
+	return true;
+}
+
+
+bool PartitioningGraph::load(const std::string &filename, std::string &functionName, std::vector<std::string> &devices) {
+	std::ifstream file(filename.c_str());
+	if (!file.is_open()) {
+		errs() << "ERROR: Could not open partitioning graph " << filename << "\n";
+		return false;
+	}
+
+	pGraph.clear();
+	instructionList.clear();
+	orderingConstraints.reset(new VertexPairList());
+
+	devices.clear();
+	unsigned int vertexCount = 0;
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream iss(line);
+		std::string entryType;
+		iss >> entryType;
+
+		bool valid;
+		if (entryType == "graph") {
+			valid = !(iss >> functionName >> vertexCount).fail();
+			for (unsigned int i=0; valid && i<vertexCount; i++)
+				boost::add_vertex(pGraph);
+		}
+		else if (entryType == "devices") {
+			unsigned int deviceCount;
+			valid = !(iss >> deviceCount).fail();
+			devices.resize(deviceCount);
+			for (unsigned int i=0; valid && i<deviceCount; i++)
+				valid = !(iss >> devices[i]).fail();
+		}
+		else if (entryType == "vertex") {
+			unsigned int index, instrCount;
+			valid = !(iss >> index).fail() && index < vertexCount;
+			if (valid) {
+				ComputationUnit &cu = pGraph[index];
+				valid = !(iss >> cu.name >> cu.partition).fail();
+				for (unsigned int i=0; valid && i<devices.size(); i++)
+					valid = !(iss >> cu.executionTimes[devices[i]]).fail();
+				valid = valid && !(iss >> instrCount).fail();
+				cu.instructionIds.resize(valid ? instrCount : 0);
+				for (unsigned int i=0; valid && i<instrCount; i++)
+					valid = !(iss >> cu.instructionIds[i]).fail();
+			}
+		}
+		else if (entryType == "edge") {
+			unsigned int source, target;
+			valid = !(iss >> source >> target).fail() && source < vertexCount && target < vertexCount;
+			if (valid) {
+				EdgeDescriptor ed = boost::add_edge(source, target, pGraph).first;
+				Communication &com = pGraph[ed];
+				valid = !(iss >> com.comCosts[DevicePair("", "")]).fail();
+				for (unsigned int i=0; valid && i<devices.size(); i++)
+					for (unsigned int j=0; valid && j<devices.size(); j++)
+						valid = !(iss >> com.comCosts[DevicePair(devices[i], devices[j])]).fail();
 			}
 		}
+		else if (entryType == "order") {
+			unsigned int first, second;
+			valid = !(iss >> first >> second).fail() && first < vertexCount && second < vertexCount;
+			if (valid)
+				orderingConstraints->push_back(std::make_pair(first, second));
+		}
+		else
+			valid = false;
+
+		if (!valid) {
+			errs() << "ERROR: Invalid entry in partitioning graph " << filename << ":" << lineNumber << "\n";
+			return false;
+		}
 	}
 
-	// run shortest path algorithm to determine critical path (because of negative edge weight)
+	return true;
+}
 
-	unsigned int vertexCount = boost::num_vertices(tmpGraph);
 
-	// init predecessors and distances
-	std::vector<cpGraph::vertex_descriptor> predecessors(vertexCount);
-	for (unsigned int i=0; i<vertexCount; i++)
-		predecessors[i] = i;
-	std::vector<int> distances(vertexCount);
-	distances[0] = 0;
-
-	// gets the weight property
-	boost::property_map<cpGraph, boost::edge_weight_t>::type weight_pmap = get(boost::edge_weight, tmpGraph);
-
-	// call the algorithm
-	bool bellmanFordSucceeded = bellman_ford_shortest_paths(
-		tmpGraph,
-		vertexCount,
-		weight_map(weight_pmap).
-		distance_map(&distances[0]).
-		predecessor_map(&predecessors[0])
-	);
-
-	unsigned int pathCost = 0;
-	if (!bellmanFordSucceeded)
-		errs() << "ERROR: Bellman Ford could not be applied!\n";
-	else
-		pathCost = std::abs(*std::min_element(distances.begin(), distances.end()));
-	
-	return pathCost; 
+bool PartitioningGraph::saveAssignment(const std::string &filename, const std::string &functionName, unsigned int partitionCount) {
+	// file format: the line "function <name> <partition count> <vertex count>" followed by
+	// one line "<vertex> <partition>" for each vertex (files of several functions can be concatenated)
+	std::ofstream file(filename.c_str());
+	if (!file.is_open()) {
+		errs() << "ERROR: Could not write partitioning assignment " << filename << "\n";
+		return false;
+	}
+
+	file << "function " << functionName << " " << partitionCount << " " << getVertexCount() << "\n";
+	VertexIterator vIt, vEnd;
+	for (boost::tie(vIt, vEnd) = boost::vertices(pGraph); vIt != vEnd; ++vIt)
+		file << *vIt << " " << pGraph[*vIt].partition << "\n";
+
+	return true;
+}
+
+
+bool PartitioningGraph::loadAssignment(const std::string &filename, const std::string &functionName, unsigned int &partitionCount) {
+	std::ifstream file(filename.c_str());
+	if (!file.is_open()) {
+		errs() << "ERROR: Could not open partitioning assignment " << filename << "\n";
+		return false;
+	}
+
+	std::string entryType, name;
+	unsigned int vertexCount;
+	while (file >> entryType >> name >> partitionCount >> vertexCount) {
+		if (entryType != "function") {
+			errs() << "ERROR: Invalid partitioning assignment " << filename << "\n";
+			return false;
+		}
+
+		bool isWantedFunction = (name == functionName);
+		if (isWantedFunction && vertexCount != getVertexCount()) {
+			errs() << "ERROR: The partitioning assignment of " << functionName << " was created for a different graph ("
+				<< vertexCount << " instead of " << getVertexCount() << " vertices)\n";
+			return false;
+		}
+
+		std::vector<unsigned int> partitions(vertexCount);
+		for (unsigned int i=0; i<vertexCount; i++) {
+			unsigned int vertex, partition;
+			if (!(file >> vertex >> partition) || vertex >= vertexCount || partition >= partitionCount) {
+				errs() << "ERROR: Invalid partitioning assignment " << filename << "\n";
+				return false;
+			}
+			partitions[vertex] = partition;
+		}
+
+		if (isWantedFunction) {
+			for (unsigned int i=0; i<vertexCount; i++)
+				setPartition(i, partitions[i]);
+			return true;
+		}
+	}
+
+	return false;
 }
 
 
@@ -508,7 +899,7 @@ void PartitioningGraph::printGraphviz(Function &func, const std::string &name, s
 
 	Graph::vertex_iterator vertexIt, vertexEnd;
 	for (boost::tie(vertexIt, vertexEnd) = boost::vertices(pGraph); vertexIt != vertexEnd; ++vertexIt) {
-		dotfile << "  " << pGraph[*vertexIt].name << "[style=filled, fillcolor=" << nodeColors[pGraph[*vertexIt].partition] << ", label=\"" << pGraph[*vertexIt].name << ":\\n\\n\"\n";
+		dotfile << "  " << pGraph[*vertexIt].name << "[style=filled, fillcolor=" << nodeColors[pGraph[*vertexIt].partition % 5] << ", label=\"" << pGraph[*vertexIt].name << ":\\n\\n\"\n";
 		std::vector<Instruction*> instructions = pGraph[*vertexIt].instructions;
 		if (false) {
 			for (std::vector<Instruction*>::iterator instrIt = instructions.begin(); instrIt != instructions.end(); ++instrIt) {
@@ -543,6 +934,53 @@ void PartitioningGraph::printGraphviz(Function &func, const std::string &name, s
 }
 
 
+void PartitioningGraph::printCriticalityGraphviz(const std::string &name, std::string &outputDir, 
+		std::vector<std::string> &partitioningDevices) {
+	// the border shows the partition (same colors as in printGraphviz) and the fill color the criticality
+	const char *nodeColors[] = { "greenyellow", "gold", "cornflowerblue", "darkorange", "aquamarine1" };
+
+	CriticalityAnalysis analysis = getCriticalityAnalysis(partitioningDevices);
+	unsigned int pathCost = std::max(analysis.criticalPathCost, 1u);
+
+	std::string filename = outputDir + "/criticality-graph-" + name + ".dot";
+	std::ofstream dotfile(filename.c_str());
+
+	dotfile << "digraph G {\n"
+		<< "  label=\"critical path: " << analysis.criticalPathCost << "\";\n"
+		<< "  node[shape=\"rectangle\", style=filled, penwidth=3];\n";
+
+	Graph::vertex_iterator vertexIt, vertexEnd;
+	for (boost::tie(vertexIt, vertexEnd) = boost::vertices(pGraph); vertexIt != vertexEnd; ++vertexIt) {
+		Timing &timing = analysis.vertexTimings[*vertexIt];
+		const char *fillColor;
+		if (timing.slack == 0)
+			fillColor = "red";
+		else if (timing.slack < pathCost/10)
+			fillColor = "orange";
+		else if (timing.slack < pathCost/3)
+			fillColor = "yellow";
+		else
+			fillColor = "white";
+		dotfile << "  " << pGraph[*vertexIt].name << "[fillcolor=" << fillColor 
+			<< ", color=" << nodeColors[pGraph[*vertexIt].partition % 5] 
+			<< ", label=\"" << pGraph[*vertexIt].name << " (partition " << pGraph[*vertexIt].partition << ")\\n"
+			<< "start: " << timing.earliestStart << " - " << timing.latestStart << "\\n"
+			<< "slack: " << timing.slack << "\"];\n";
+	}
+
+	Graph::edge_iterator edgeIt, edgeEnd;
+	for (boost::tie(edgeIt, edgeEnd) = boost::edges(pGraph); edgeIt != edgeEnd; ++edgeIt) {
+		Graph::vertex_descriptor u = boost::source(*edgeIt, pGraph), v = boost::target(*edgeIt, pGraph);
+		Timing &timing = analysis.getEdgeTiming(u, v);
+		dotfile << "  " << pGraph[u].name << "->" << pGraph[v].name << "[label=\"slack: " << timing.slack << "\"";
+		if (timing.slack == 0)
+			dotfile << ", color=red, style=bold";
+		dotfile << "];\n";
+	}
+	dotfile << "}";
+}
+
+
 void PartitioningGraph::printPartitions(void) {
 	std::map<unsigned int, std::vector<VertexDescriptor> > partitions;
 	VertexIterator vertexIt, vertexEnd;
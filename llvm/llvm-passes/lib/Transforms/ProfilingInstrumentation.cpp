@@ -0,0 +1,122 @@
+#include "mehari/Transforms/ProfilingInstrumentation.h"
+
+#include "mehari/Analysis/ExecutionProfile.h"
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+
+static cl::opt<std::string> TargetFunctions("profiling-functions",
+            cl::desc("Specify the functions that will be instrumented for profiling (seperated by whitespace)"),
+            cl::value_desc("target-functions"));
+
+
+ProfilingInstrumentation::ProfilingInstrumentation() : ModulePass(ID) {
+	parseTargetFunctions();
+}
+
+ProfilingInstrumentation::~ProfilingInstrumentation() {}
+
+
+bool ProfilingInstrumentation::runOnModule(Module &M) {
+	bool modified = false;
+	unsigned int functionId = 0;
+	for (std::vector<std::string>::iterator funcIt = targetFunctions.begin(); funcIt != targetFunctions.end(); ++funcIt) {
+		Function *func = M.getFunction(*funcIt);
+		if (!func || func->isDeclaration()) {
+			errs() << "ERROR: Function " << *funcIt << " not found!\n";
+			continue;
+		}
+		instrumentFunction(M, *func, functionId++);
+		modified = true;
+	}
+	return modified;
+}
+
+
+void ProfilingInstrumentation::instrumentFunction(Module &M, Function &F, unsigned int functionId) {
+	LLVMContext &context = M.getContext();
+
+	// runtime functions (see runtime/mehari_profile.c)
+	Function *enterFunc = cast<Function>(
+		M.getOrInsertFunction("_mehari_profile_enter",
+			Type::getVoidTy(context),
+			Type::getInt32Ty(context),
+			Type::getInt8PtrTy(context),
+			Type::getInt32Ty(context),
+			(Type *)0));
+	Function *beginFunc = cast<Function>(
+		M.getOrInsertFunction("_mehari_profile_begin",
+			Type::getInt64Ty(context),
+			(Type *)0));
+	Function *endFunc = cast<Function>(
+		M.getOrInsertFunction("_mehari_profile_end",
+			Type::getVoidTy(context),
+			Type::getInt32Ty(context),
+			Type::getInt32Ty(context),
+			Type::getInt64Ty(context),
+			(Type *)0));
+	Function *branchFunc = cast<Function>(
+		M.getOrInsertFunction("_mehari_profile_branch",
+			Type::getVoidTy(context),
+			Type::getInt32Ty(context),
+			Type::getInt32Ty(context),
+			Type::getInt32Ty(context),
+			(Type *)0));
+
+	// number the instructions before we insert any calls, so the numbers
+	// match the uninstrumented function that is used for the partitioning
+	std::vector<Instruction*> instructions = ExecutionProfile::getProfiledInstructions(F);
+
+	Value *functionIdVal = ConstantInt::get(Type::getInt32Ty(context), functionId);
+	for (unsigned int id=0; id<instructions.size(); id++) {
+		Instruction *instr = instructions[id];
+		Value *instrIdVal = ConstantInt::get(Type::getInt32Ty(context), id);
+
+		if (BranchInst *bInstr = dyn_cast<BranchInst>(instr)) {
+			// record the direction of conditional branches
+			if (bInstr->isConditional()) {
+				// the runtime takes an int, so we extend the condition instead of passing an i1
+				// whose upper bits are undefined in the calling convention
+				Value *condition = CastInst::CreateZExtOrBitCast(bInstr->getCondition(),
+					Type::getInt32Ty(context), "profile_condition", instr);
+				Value *params[] = { functionIdVal, instrIdVal, condition };
+				CallInst::Create(branchFunc, params, "", instr);
+			}
+		}
+		else if (!isa<PHINode>(instr) && !isa<TerminatorInst>(instr)) {
+			// measure the cycles between the calls before and after the instruction
+			CallInst *startTime = CallInst::Create(beginFunc, "profile_start", instr);
+			Value *params[] = { functionIdVal, instrIdVal, startTime };
+			CallInst *endCall = CallInst::Create(endFunc, params);
+			instr->getParent()->getInstList().insertAfter(instr, endCall);
+		}
+	}
+
+	// count the invocations of the function
+	Instruction *firstInstr = &F.getEntryBlock().front();
+	IRBuilder<> builder(firstInstr);
+	Value *params[] = {
+		functionIdVal,
+		builder.CreateGlobalStringPtr(F.getName(), "profile_name"),
+		ConstantInt::get(Type::getInt32Ty(context), instructions.size())
+	};
+	CallInst::Create(enterFunc, params, "", firstInstr);
+}
+
+
+void ProfilingInstrumentation::parseTargetFunctions() {
+	boost::algorithm::split(targetFunctions, TargetFunctions, boost::algorithm::is_any_of(" "));
+}
+
+
+// register pass so we can call it using opt
+char ProfilingInstrumentation::ID = 0;
+static RegisterPass<ProfilingInstrumentation>
+Y("profiling-instrumentation", "Instrument functions to record an execution profile for the partitioning.");
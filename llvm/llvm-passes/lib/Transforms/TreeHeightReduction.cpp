@@ -0,0 +1,185 @@
+#include "mehari/Transforms/TreeHeightReduction.h"
+
+#include "mehari/HardwareInformation.h"
+
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+#include <algorithm>
+
+
+static cl::opt<std::string> TargetFunctions("tree-height-functions",
+            cl::desc("Specify the functions whose floating point chains will be rebalanced (seperated by whitespace)"),
+            cl::value_desc("target-functions"));
+static cl::opt<bool> Reassociate("fp-reassociate",
+            cl::desc("Allow reassociation of floating point additions and multiplications (changes the rounding of the results)"));
+
+
+// statistics of the chains of one operation (fadd or fmul)
+struct ChainStatistics {
+	unsigned int chains;
+	unsigned int longest;
+	unsigned int depthBefore;
+	unsigned int depthAfter;
+	unsigned int savedCycles;
+
+	ChainStatistics() : chains(0), longest(0), depthBefore(0), depthAfter(0), savedCycles(0) {}
+};
+
+static unsigned int balancedDepth(unsigned int operands) {
+	unsigned int depth = 0;
+	while ((1u << depth) < operands)
+		depth++;
+	return depth;
+}
+
+
+TreeHeightReduction::TreeHeightReduction() : FunctionPass(ID), reassociate(Reassociate) {
+	parseTargetFunctions();
+}
+
+TreeHeightReduction::~TreeHeightReduction() {}
+
+
+bool TreeHeightReduction::runOnFunction(Function &func) {
+	std::string functionName = func.getName().str();
+
+	// just handle those functions specified by the command line parameter
+	if (std::find(targetFunctions.begin(), targetFunctions.end(), functionName) == targetFunctions.end())
+		return false;
+
+	// collect the roots first because rebalancing removes instructions
+	std::vector<Instruction*> roots;
+	for (inst_iterator instrIt = inst_begin(func); instrIt != inst_end(func); ++instrIt)
+		if (isChainRoot(&*instrIt))
+			roots.push_back(&*instrIt);
+
+	HardwareInformation hwInfo;
+	DeviceInformation *devInfo = hwInfo.getDeviceInfo("Cortex-A9");
+
+	ChainStatistics sums, products;
+	for (std::vector<Instruction*>::iterator rootIt = roots.begin(); rootIt != roots.end(); ++rootIt) {
+		std::vector<Value*> leaves;
+		std::vector<Instruction*> inner;
+		unsigned int depth = collectChain(*rootIt, leaves, inner);
+		unsigned int newDepth = balancedDepth(leaves.size());
+		if (depth <= newDepth)
+			continue;
+
+		ChainStatistics &stats = ((*rootIt)->getOpcode() == Instruction::FAdd ? sums : products);
+		stats.chains++;
+		stats.savedCycles += (depth - newDepth) * devInfo->getInstructionInfo(*rootIt)->getCycleCount();
+		if (leaves.size() > stats.longest) {
+			stats.longest = leaves.size();
+			stats.depthBefore = depth;
+			stats.depthAfter = newDepth;
+		}
+
+		if (reassociate)
+			rebalanceChain(*rootIt, leaves, inner);
+	}
+
+	errs() << "tree height reduction: " << functionName << ": "
+		<< sums.chains << " fadd chains, " << products.chains << " fmul chains"
+		<< (reassociate ? " rebalanced\n" : " could be rebalanced (enable with -fp-reassociate)\n");
+	if (sums.chains + products.chains == 0)
+		return false;
+
+	// Both orders have an error of at most depth*u relative to the sum of the absolute values
+	// of the terms (u = 2^-53 is the unit roundoff of a double), so the results may differ by
+	// the sum of both bounds. For products the error is at most (n-1)*u relative to the product
+	// for any order of the factors.
+	if (sums.chains > 0) {
+		errs() << "  longest fadd chain: " << sums.longest << " terms, depth " << sums.depthBefore
+			<< " -> " << sums.depthAfter << "\n";
+		errs() << "  error bound: " << sums.depthBefore << "*u -> " << sums.depthAfter
+			<< "*u relative to the sum of |terms|, results differ by at most "
+			<< (sums.depthBefore + sums.depthAfter) << "*u (u = 2^-53)\n";
+	}
+	if (products.chains > 0) {
+		errs() << "  longest fmul chain: " << products.longest << " factors, depth " << products.depthBefore
+			<< " -> " << products.depthAfter << "\n";
+		errs() << "  error bound: " << (products.longest - 1) << "*u relative to the product in both orders, "
+			<< "results differ by at most " << 2*(products.longest - 1) << "*u (u = 2^-53)\n";
+	}
+
+	errs() << "  sum of the depth reductions: " << (sums.savedCycles + products.savedCycles) << " cycles on Cortex-A9\n";
+
+	return reassociate;
+}
+
+
+// the last operation of a chain, i.e. its result is not only used by the same operation
+bool TreeHeightReduction::isChainRoot(Instruction *instr) {
+	if (instr->getOpcode() != Instruction::FAdd && instr->getOpcode() != Instruction::FMul)
+		return false;
+	if (!instr->hasOneUse())
+		return true;
+	Instruction *user = dyn_cast<Instruction>(*instr->use_begin());
+	return user == NULL || user->getOpcode() != instr->getOpcode() || user->getParent() != instr->getParent();
+}
+
+// Collects the operands of a chain and its inner nodes (each before its operands).
+// An operand is part of the chain, if it is the same operation in the same basic block
+// and it isn't used anywhere else. Returns the depth of the chain.
+unsigned int TreeHeightReduction::collectChain(Instruction *node, std::vector<Value*> &leaves,
+		std::vector<Instruction*> &inner) {
+	unsigned int depth = 0;
+	for (unsigned int i = 0; i < 2; i++) {
+		Instruction *operand = dyn_cast<Instruction>(node->getOperand(i));
+		if (operand && operand->getOpcode() == node->getOpcode() && operand->hasOneUse()
+				&& operand->getParent() == node->getParent()) {
+			inner.push_back(operand);
+			depth = std::max(depth, collectChain(operand, leaves, inner));
+		}
+		else
+			leaves.push_back(node->getOperand(i));
+	}
+	return depth + 1;
+}
+
+// Combines neighbouring operands pairwise until two are left, which become the
+// operands of the root. All operands are available at the root, so the new
+// instructions are inserted in front of it.
+void TreeHeightReduction::rebalanceChain(Instruction *root, std::vector<Value*> &leaves,
+		std::vector<Instruction*> &inner) {
+	std::vector<Value*> level(leaves);
+	while (level.size() > 2) {
+		std::vector<Value*> next;
+		for (unsigned int i = 0; i+1 < level.size(); i += 2)
+			next.push_back(BinaryOperator::Create((Instruction::BinaryOps)root->getOpcode(),
+				level[i], level[i+1], root->getName() + ".tree", root));
+		if (level.size() % 2 == 1)
+			next.push_back(level.back());
+		level.swap(next);
+	}
+	root->setOperand(0, level[0]);
+	root->setOperand(1, level[1]);
+
+	// each inner node was only used by its predecessor in the list (or by the root)
+	for (std::vector<Instruction*>::iterator innerIt = inner.begin(); innerIt != inner.end(); ++innerIt)
+		(*innerIt)->eraseFromParent();
+}
+
+
+void TreeHeightReduction::setTargetFunctions(const std::vector<std::string> &functions) {
+	targetFunctions = functions;
+}
+
+void TreeHeightReduction::setReassociate(bool enable) {
+	reassociate = enable;
+}
+
+void TreeHeightReduction::parseTargetFunctions() {
+	boost::algorithm::split(targetFunctions, TargetFunctions, boost::algorithm::is_any_of(" "));
+}
+
+
+char TreeHeightReduction::ID = 0;
+static RegisterPass<TreeHeightReduction>
+Y("tree-height-reduction", "Rebalance chains of floating point additions and multiplications.");
@@ -31,7 +31,10 @@ VHDLBackend::VHDLBackend(const std::string& name)
     instanceNameGenerator("inst"),
     vs_factory(new ValueStorageFactory()),
     ready_signals(new ReadySignals()),
+    firstResultPosition(std::string::npos),
     generateForTest(false),
+    static_schedule(false),
+    static_schedule_failed(false),
     dataDependencyCount(0)
 { }
 
@@ -44,7 +47,105 @@ ReconOSOperator* VHDLBackend::getReconOSOperator() {
 }
 
 std::string VHDLBackend::getInterfaceCode() {
-  return interface_ccode.str();
+  return getCachedInputsCode() + interface_ccode.str();
+}
+
+std::string VHDLBackend::getStartCode() {
+  std::string code = interface_ccode.str();
+  return getCachedInputsCode() + code.substr(0, std::min(firstResultPosition, code.size()));
+}
+
+std::string VHDLBackend::getCollectCode() {
+  std::string code = interface_ccode.str();
+  return (firstResultPosition < code.size() ? code.substr(firstResultPosition) : "");
+}
+
+void VHDLBackend::setInvariantInputs(const std::set<std::string>& inputs) {
+  invariant_inputs = inputs;
+}
+
+bool VHDLBackend::hasCachedInputs() {
+  return !cached_inputs.empty();
+}
+
+std::string VHDLBackend::getCachedInputsCode() {
+  if (cached_inputs.empty())
+    return "";
+
+  std::ostringstream code;
+  code << "{\n"
+       << "\tstatic unsigned int cached_inputs_version = 0;\n";
+  for (unsigned int i=0; i<cached_inputs.size(); i++)
+    code << "\tstatic " << (cached_inputs[i].first == "real" ? "double" : "int") << " cached_input_" << i << ";\n";
+
+  // compare the bits, so we notice a change of the sign of zero
+  code << "\tif (cached_inputs_version == 0";
+  for (unsigned int i=0; i<cached_inputs.size(); i++)
+    code << "\n\t\t\t|| memcmp(&cached_input_" << i << ", &" << cached_inputs[i].second
+         << ", sizeof(cached_input_" << i << ")) != 0";
+  code << ") {\n"
+       << "\t\t// the hardware starts with version 0 and 0xffffffff stops the thread\n"
+       << "\t\tcached_inputs_version = cached_inputs_version % 0xfffffffeu + 1;\n";
+  for (unsigned int i=0; i<cached_inputs.size(); i++)
+    code << "\t\tcached_input_" << i << " = " << cached_inputs[i].second << ";\n";
+  code << "\t\tmbox_put(&mbox_start, cached_inputs_version);\n";
+  for (unsigned int i=0; i<cached_inputs.size(); i++)
+    code << "\t\tmbox_put_" << cached_inputs[i].first << "(&mbox_start, cached_input_" << i << ");\n";
+  code << "\t} else\n"
+       << "\t\tmbox_put(&mbox_start, cached_inputs_version);\n"
+       << "}\n";
+
+  return code.str();
+}
+
+std::string VHDLBackend::getEmulationCode(const std::string& calculation) {
+  typedef std::pair<std::string, std::string> TypeAndCCode;
+  std::ostringstream code;
+
+  if (!cached_inputs.empty())
+    code << "uint32_t cached_inputs_version = 0;\n";
+  for (unsigned int i=0; i<cached_inputs.size(); i++)
+    code << (cached_inputs[i].first == "real" ? "double" : "int") << " cached_input_" << i << " = 0;\n";
+  if (!return_type.empty())
+    code << (return_type == "real" ? "double" : "int") << " return_value = 0;\n";
+
+  // the start word is the version of the cached inputs or a dummy value
+  code << "while (1) {\n"
+       << "\tuint32_t start_word = mbox_get(mbox_start);\n"
+       << "\tif (start_word == 0xffffffffu)\n"
+       << "\t\tbreak;\n";
+  if (!cached_inputs.empty()) {
+    code << "\tif (start_word != cached_inputs_version) {\n"
+         << "\t\tcached_inputs_version = start_word;\n";
+    for (unsigned int i=0; i<cached_inputs.size(); i++)
+      code << "\t\tcached_input_" << i << " = reconos_emu_mbox_get_" << cached_inputs[i].first << "(mbox_start);\n";
+    code << "\t}\n";
+    for (unsigned int i=0; i<cached_inputs.size(); i++)
+      code << "\t" << cached_inputs[i].second << " = cached_input_" << i << ";\n";
+  }
+  BOOST_FOREACH(const TypeAndCCode& input, mbox_inputs)
+    code << "\t" << input.second << " = reconos_emu_mbox_get_" << input.first << "(mbox_start);\n";
+
+  code << "\n\t" << (return_type.empty() ? "(void)" : "return_value = ") << calculation << ";\n\n";
+
+  BOOST_FOREACH(const TypeAndCCode& output, mbox_outputs)
+    code << "\treconos_emu_mbox_put_" << output.first << "(mbox_stop, " << output.second << ");\n";
+  code << "\tmbox_put(mbox_stop, start_word);\n"
+       << "}\n";
+
+  return code.str();
+}
+
+void VHDLBackend::setOperatorLimit(const std::string& name, unsigned int count) {
+  operator_limits[name] = count;
+}
+
+void VHDLBackend::setStaticSchedule(bool enabled) {
+  static_schedule = enabled;
+}
+
+bool VHDLBackend::isStaticallyScheduled() {
+  return static_schedule && !static_schedule_failed;
 }
 
 VHDLBackend* VHDLBackend::setTestMode() {
@@ -61,7 +162,21 @@ void VHDLBackend::init(SimpleCCodeGenerator* generator, std::ostream& stream) {
   usedVariableNames.reset();
   ready_signals->clear();
   interface_ccode.str("");
+  firstResultPosition = std::string::npos;
   read_values.clear();
+  cached_inputs.clear();
+  mbox_inputs.clear();
+  mbox_outputs.clear();
+  return_type.clear();
+  shared_cores.clear();
+  core_counts.clear();
+  operation_counts.clear();
+  finish_times.clear();
+  unshared_finish_times.clear();
+  static_schedule_failed = false;
+  ready_times.clear();
+  captured_inputs.clear();
+  scheduled_outputs.clear();
 
   op.reset(new MyOperator());
   op->setName(name);
@@ -74,6 +189,9 @@ void VHDLBackend::init(SimpleCCodeGenerator* generator, std::ostream& stream) {
   r_op.reset(new ReconOSOperator());
   r_op->setName("reconos");
   r_op->setCalculation(op.get());
+
+  if (static_schedule)
+    schedule_name = usedVariableNames.makeUnique("schedule");
 }
 
 void VHDLBackend::generateStore(Value *op1, Value *op2) {
@@ -146,6 +264,18 @@ OperatorInfo getBinaryOperator(unsigned opcode, unsigned width) {
   case Instruction::And:
     name = "bit_and";
     break;
+  case Instruction::Xor:
+    name = "bit_xor";
+    break;
+  case Instruction::Shl:
+    name = "shl";
+    break;
+  case Instruction::LShr:
+    name = "lshr";
+    break;
+  case Instruction::AShr:
+    name = "ashr";
+    break;
   default:
     assert(false);
   }
@@ -184,6 +314,49 @@ OperatorInfo getBinaryOperator(unsigned opcode, unsigned width) {
   return op_info;
 }
 
+// VHDL expression for the data of a channel that is used by inline code
+static std::string getDataExpression(ChannelP channel, Value* value) {
+  if (channel->direction != CONSTANT_OUT)
+    return channel->data_signal;
+
+  // The constant of an i1 value would be -1 or 0.
+  if (ConstantInt* ci = dyn_cast<ConstantInt>(value))
+    if (ci->getBitWidth() == 1)
+      return (ci->isOne() ? "\"1\"" : "\"0\"");
+
+  return channel->constant;
+}
+
+static std::string getValidExpression(ChannelP channel) {
+  return (channel->direction != CONSTANT_OUT ? channel->valid_signal : "'1'");
+}
+
+void VHDLBackend::generateBitwiseOperator(std::string tmpVar, Value *op1, Value *op2, unsigned opcode) {
+  // Boolean operations are cheap enough to do them without a component.
+  ChannelP write = vs_factory->getTemporaryVariable(tmpVar)->getWriteChannel(op.get());
+  ChannelP read1 = read(vs_factory->get(op1));
+  ChannelP read2 = read(vs_factory->get(op2));
+
+  std::string vhdl_op;
+  switch (opcode) {
+    case Instruction::And: vhdl_op = "and"; break;
+    case Instruction::Or:  vhdl_op = "or";  break;
+    case Instruction::Xor: vhdl_op = "xor"; break;
+    default: assert(false);
+  }
+
+  *op << "   " << write->data_signal << " <= "
+    << getDataExpression(read1, op1) << " " << vhdl_op << " " << getDataExpression(read2, op2) << ";\n";
+  *op << "   " << write->valid_signal << " <= "
+    << getValidExpression(read1) << " and " << getValidExpression(read2) << ";\n";
+
+  if (read1->direction != CONSTANT_OUT)
+    ready_signals->addConsumer(read1->ready_signal, write->ready_signal);
+  if (read2->direction != CONSTANT_OUT)
+    ready_signals->addConsumer(read2->ready_signal, write->ready_signal);
+  setReadyTime(write, std::max(getReadyTime(read1), getReadyTime(read2)));
+}
+
 void VHDLBackend::generateBinaryOperator(std::string tmpVar,
     Value *op1, Value *op2, unsigned opcode) {
   debug_print("generateBinaryOperator(" << tmpVar << ", " << op1 << ", " << op2 << ", "
@@ -192,19 +365,468 @@ void VHDLBackend::generateBinaryOperator(std::string tmpVar,
 
   ValueStorageP tmp = vs_factory->getTemporaryVariable(tmpVar);
 
+  if (tmp->width() == 1 && (opcode == Instruction::And || opcode == Instruction::Or || opcode == Instruction::Xor)) {
+    generateBitwiseOperator(tmpVar, op1, op2, opcode);
+    return;
+  }
+
   OperatorInfo op_info = getBinaryOperator(opcode, tmp->width());
 
+  if (!static_schedule && shareOperator(tmpVar, op1, op2, op_info, tmp->width()))
+    return;
+
   ChannelP input1 = Channel::make_component_input (op_info.op, op_info.input1, op_info);
   ChannelP input2 = Channel::make_component_input (op_info.op, op_info.input2, op_info);
   ChannelP output = Channel::make_component_output(op_info.op, op_info.output, op_info);
 
-  input1->connectToOutput(read(vs_factory->get(op1)),     op.get(), usedVariableNames, *ready_signals);
-  input2->connectToOutput(read(vs_factory->get(op2)),     op.get(), usedVariableNames, *ready_signals);
-  output->connectToInput (tmp->getWriteChannel(op.get()), op.get(), usedVariableNames, *ready_signals);
+  connectOperator(tmpVar, op_info,
+    input1, read(vs_factory->get(op1)),
+    input2, read(vs_factory->get(op2)),
+    output, tmp->getWriteChannel(op.get()));
 
   this->op->inPortMap(op_info.op, "aclk", "aclk");
 
   *this->op << this->op->instance(op_info.op, tmpVar);
+
+  std::vector<Value*> inputs;
+  inputs.push_back(op1);
+  inputs.push_back(op2);
+  addOperation(tmpVar, op_info.op->getName(), inputs);
+}
+
+struct OperatorResources {
+  const char* name;
+  unsigned int latency;   // in clock cycles
+  unsigned int luts, dsps;
+};
+
+// Double precision cores of the Xilinx Floating-Point Operator and our integer cores on
+// the xc7z020. The latencies are the FPGA costs in HardwareInformation. They are the
+// max-clock-cycles in operations.yaml, so the static schedule can rely on them.
+static const OperatorResources operatorResources[] = {
+  { "float_add",  13,  690,  3 },
+  { "float_sub",  13,  690,  3 },
+  { "float_mul",  10,  200, 11 },
+  { "float_div",  58, 3200,  0 },
+  { "float_cmp",   3,  150,  0 },
+  { "sin",        69, 2500, 10 },
+  { "cos",        69, 2500, 10 },
+  { "mul",         4,   40,  3 },
+  { "udiv",       34, 1100,  0 },
+  { "sdiv",       34, 1200,  0 },
+  { "urem",       34, 1100,  0 },
+  { "srem",       34, 1200,  0 },
+  { "sitofp",      1,  250,  0 },
+  { "uitofp",      1,  250,  0 },
+  { "fptosi",      1,  300,  0 },
+  { "fptoui",      1,  300,  0 }
+};
+
+static OperatorResources getOperatorResources(const std::string& name) {
+  for (unsigned int i = 0; i < sizeof(operatorResources) / sizeof(*operatorResources); i++)
+    if (name == operatorResources[i].name)
+      return operatorResources[i];
+
+  // simple 32-bit integer operations
+  OperatorResources resources = { "", 1, 32, 0 };
+  return resources;
+}
+
+static unsigned int getFinishTime(const std::map<std::string, unsigned int>& finish_times, const std::string& name) {
+  std::map<std::string, unsigned int>::const_iterator it = finish_times.find(name);
+  return (it != finish_times.end() ? it->second : 0);
+}
+
+void VHDLBackend::addOperation(const std::string& tmpVar, const std::string& operator_name,
+    const std::vector<Value*>& inputs, SharedCore* core) {
+  // The estimated latency ignores the handshakes and the other instructions.
+  unsigned int start = 0, unshared_start = 0;
+  BOOST_FOREACH(Value* input, inputs) {
+    const std::string& input_name = vs_factory->get(input)->name;
+    start          = std::max(start,          getFinishTime(finish_times,          input_name));
+    unshared_start = std::max(unshared_start, getFinishTime(unshared_finish_times, input_name));
+  }
+
+  unsigned int latency = getOperatorResources(operator_name).latency;
+  if (core) {
+    // a shared core executes one operation at a time
+    start = std::max(start, core->finish_time);
+    core->finish_time = start + latency;
+  } else
+    core_counts[operator_name]++;
+
+  finish_times[tmpVar]          = start + latency;
+  unshared_finish_times[tmpVar] = unshared_start + latency;
+  operation_counts[operator_name]++;
+}
+
+bool VHDLBackend::shareOperator(const std::string& tmpVar, Value *op1, Value *op2,
+    const OperatorInfo& op_info, unsigned int width) {
+  const std::string& operator_name = op_info.op->getName();
+  std::map<std::string, unsigned int>::iterator limit = operator_limits.find(operator_name);
+  if (limit == operator_limits.end() || limit->second == 0)
+    return false;
+
+  // bind the operation to the core that is done first (list scheduling in the order of the code)
+  std::vector<SharedCore>& cores = shared_cores[operator_name + "_" + toString(width)];
+  if (cores.size() < limit->second) {
+    SharedCore core;
+    core.name = usedVariableNames.makeUnique(operator_name + "_shared");
+    core.op_info = op_info;
+    core.width = width;
+    core.finish_time = 0;
+    cores.push_back(core);
+    core_counts[operator_name]++;
+  }
+  SharedCore* core = &cores.front();
+  for (std::vector<SharedCore>::iterator it = cores.begin(); it != cores.end(); ++it)
+    if (it->finish_time < core->finish_time)
+      core = &*it;
+
+  // The operation gets channels of its own. The core reads them when it is
+  // the turn of the operation and writes the result to a register.
+  SharedOperation operation;
+  operation.input1 = Channel::make_variable(op.get(), tmpVar + "_a",      width);
+  operation.input2 = Channel::make_variable(op.get(), tmpVar + "_b",      width);
+  operation.output = Channel::make_variable(op.get(), tmpVar + "_result", width);
+
+  ValueStorageP tmp = vs_factory->getTemporaryVariable(tmpVar);
+  operation.input1->connectToOutput(read(vs_factory->get(op1)),     op.get(), usedVariableNames, *ready_signals);
+  operation.input2->connectToOutput(read(vs_factory->get(op2)),     op.get(), usedVariableNames, *ready_signals);
+  operation.output->connectToInput (tmp->getWriteChannel(op.get()), op.get(), usedVariableNames, *ready_signals);
+
+  core->operations.push_back(operation);
+
+  std::vector<Value*> inputs;
+  inputs.push_back(op1);
+  inputs.push_back(op2);
+  addOperation(tmpVar, operator_name, inputs, core);
+
+  return true;
+}
+
+static std::string stepValue(unsigned int step, unsigned int width) {
+  return "std_logic_vector(to_unsigned(" + toString(step) + ", " + toString(width) + "))";
+}
+
+void VHDLBackend::generateSharedCore(SharedCore& core) {
+  const OperatorInfo& op_info = core.op_info;
+  const std::string& name = core.name;
+  unsigned int count = core.operations.size();
+  // step = count means that all operations of the iteration are done
+  unsigned int step_width = 1;
+  while ((1u << step_width) < count + 1)
+    step_width++;
+
+  std::string step         = op->declare(name + "_step", step_width, true);
+  std::string issued       = op->declare(name + "_issued");
+  std::string dropped      = op->declare(name + "_dropped");
+  std::string a_data       = op->declare(name + "_a_data", core.width, true);
+  std::string a_valid      = op->declare(name + "_a_valid");
+  std::string b_data       = op->declare(name + "_b_data", core.width, true);
+  std::string b_valid      = op->declare(name + "_b_valid");
+  std::string a_ready      = name + "_a_ready";
+  std::string b_ready      = name + "_b_ready";
+  std::string result_data  = name + "_result_data";
+  std::string result_valid = name + "_result_valid";
+
+  op->inPortMap   (op_info.op, "aclk", "aclk");
+  op->inPortMap   (op_info.op, op_info.input1 + op_info.data_suffix,  a_data);
+  op->inPortMap   (op_info.op, op_info.input1 + op_info.valid_suffix, a_valid);
+  op->outPortMap  (op_info.op, op_info.input1 + op_info.ready_suffix, a_ready);
+  op->inPortMap   (op_info.op, op_info.input2 + op_info.data_suffix,  b_data);
+  op->inPortMap   (op_info.op, op_info.input2 + op_info.valid_suffix, b_valid);
+  op->outPortMap  (op_info.op, op_info.input2 + op_info.ready_suffix, b_ready);
+  op->outPortMap  (op_info.op, op_info.output + op_info.data_suffix,  result_data);
+  op->outPortMap  (op_info.op, op_info.output + op_info.valid_suffix, result_valid);
+  op->inPortMapCst(op_info.op, op_info.output + op_info.ready_suffix, "'1'");
+  *op << op->instance(op_info.op, name);
+
+  // The core gets the inputs of the operation whose turn it is. We send them once,
+  // so both inputs have to be accepted together (like the cores in non-blocking mode do).
+  std::ostringstream a_mux, b_mux, valid_mux;
+  std::vector<std::string> inputs_valid;
+  for (unsigned int i = 0; i < count; i++) {
+    const SharedOperation& operation = core.operations[i];
+    inputs_valid.push_back(operation.input1->valid_signal + " = '1' and "
+      + operation.input2->valid_signal + " = '1'");
+
+    std::string condition = " WHEN " + step + " = " + stepValue(i, step_width) + " ELSE\n      ";
+    a_mux << operation.input1->data_signal << condition;
+    b_mux << operation.input2->data_signal << condition;
+    valid_mux << operation.input1->valid_signal << " and " << operation.input2->valid_signal
+      << " and not " << issued << condition;
+
+    *op << "   " << operation.input1->ready_signal << " <= " << a_ready
+      << " WHEN " << step << " = " << stepValue(i, step_width) << " ELSE '0';\n";
+    *op << "   " << operation.input2->ready_signal << " <= " << b_ready
+      << " WHEN " << step << " = " << stepValue(i, step_width) << " ELSE '0';\n";
+  }
+  *op << "   " << a_data  << " <= " << a_mux.str()     << "(others => 'X');\n";
+  *op << "   " << b_data  << " <= " << b_mux.str()     << "(others => 'X');\n";
+  *op << "   " << a_valid << " <= " << valid_mux.str() << "'0';\n";
+  *op << "   " << b_valid << " <= " << valid_mux.str() << "'0';\n";
+
+  // Save the result in the register of the operation and continue with the next one.
+  // The core stops after the last operation. Like the output of a core, the result
+  // is only valid as long as the inputs are.
+  *op << "   " << name << "_schedule : process(aclk)\n"
+      << "   begin\n"
+      << "      if reset = '1' then\n"
+      << "         " << step << " <= (others => '0');\n"
+      << "         " << issued << " <= '0';\n"
+      << "         " << dropped << " <= '0';\n";
+  BOOST_FOREACH(const SharedOperation& operation, core.operations) {
+    *op << "         " << operation.output->valid_signal << " <= '0';\n"
+        << "         " << operation.output->data_signal << " <= (others => '0');\n";
+  }
+  *op << "      elsif rising_edge(aclk) then\n";
+  BOOST_FOREACH(const SharedOperation& operation, core.operations) {
+    *op << "         if " << operation.input1->valid_signal << " = '0' or "
+        << operation.input2->valid_signal << " = '0' then\n"
+        << "            " << operation.output->valid_signal << " <= '0';\n"
+        << "         end if;\n";
+  }
+  *op << "         if " << a_valid << " = '1' and " << a_ready << " = '1' then\n"
+      << "            " << issued << " <= '1';\n"
+      << "            " << dropped << " <= '0';\n"
+      << "         end if;\n"
+      << "         if " << result_valid << " = '1' then\n"
+      << "            " << issued << " <= '0';\n";
+  for (unsigned int i = 0; i < count; i++) {
+    const SharedOperation& operation = core.operations[i];
+    *op << "            " << (i == 0 ? "if " : "elsif ") << step << " = " << stepValue(i, step_width)
+        << " and " << dropped << " = '0' and " << inputs_valid[i] << " then\n"
+        << "               " << operation.output->data_signal << " <= " << result_data << ";\n"
+        << "               " << operation.output->valid_signal << " <= '1';\n"
+        << "               " << step << " <= " << stepValue(i + 1, step_width) << ";\n";
+  }
+  *op << "            end if;\n"
+      << "         end if;\n";
+
+  // At the end of an iteration, the inputs of the operations become invalid. The core
+  // starts over at the first of them that it has already reached. A result that is
+  // still in flight belongs to the old inputs, so it is dropped when it arrives.
+  for (unsigned int i = count; i-- > 0; ) {
+    const SharedOperation& operation = core.operations[i];
+    *op << "         if (" << operation.input1->valid_signal << " = '0' or "
+        << operation.input2->valid_signal << " = '0')";
+    if (i > 0)
+      *op << " and unsigned(" << step << ") >= " << i;
+    *op << " then\n"
+        << "            " << step << " <= " << stepValue(i, step_width) << ";\n"
+        << "            " << dropped << " <= '1';\n"
+        << "         end if;\n";
+  }
+  *op << "      end if;\n"
+      << "   end process;\n";
+}
+
+std::string VHDLBackend::getResourceReport() {
+  unsigned int latency = 0, unshared_latency = 0, luts = 0, dsps = 0, operations = 0;
+  for (std::map<std::string, unsigned int>::iterator it = finish_times.begin(); it != finish_times.end(); ++it)
+    latency = std::max(latency, it->second);
+  for (std::map<std::string, unsigned int>::iterator it = unshared_finish_times.begin(); it != unshared_finish_times.end(); ++it)
+    unshared_latency = std::max(unshared_latency, it->second);
+
+  for (std::map<std::string, unsigned int>::iterator it = core_counts.begin(); it != core_counts.end(); ++it) {
+    OperatorResources resources = getOperatorResources(it->first);
+    luts += it->second * resources.luts;
+    dsps += it->second * resources.dsps;
+  }
+  // the input multiplexers of the shared cores (a LUT6 is a 4:1 multiplexer)
+  for (std::map<std::string, std::vector<SharedCore> >::iterator it = shared_cores.begin(); it != shared_cores.end(); ++it)
+    BOOST_FOREACH(const SharedCore& core, it->second)
+      luts += 2 * core.width * ((core.operations.size() + 1) / 3);
+
+  std::ostringstream details;
+  for (std::map<std::string, unsigned int>::iterator it = operation_counts.begin(); it != operation_counts.end(); ++it) {
+    unsigned int cores = core_counts[it->first];
+    details << "  " << it->first << ": " << it->second << " operations on "
+      << cores << (cores == 1 ? " core" : " cores") << "\n";
+    operations += it->second;
+  }
+
+  std::ostringstream report;
+  report << name << ": " << operations << " operations, latency about " << latency << " cycles";
+  if (!shared_cores.empty())
+    report << " (" << unshared_latency << " without sharing)";
+  report << ", about " << luts << " LUTs and " << dsps << " DSPs\n"
+    << details.str();
+  if (isStaticallyScheduled())
+    report << "  static schedule: " << getStaticLatency() << " cycles from the last input to the results\n";
+  return report.str();
+}
+
+void VHDLBackend::connectOperator(const std::string& tmpVar, const OperatorInfo& op_info,
+    ChannelP input1, ChannelP value1, ChannelP input2, ChannelP value2, ChannelP output, ChannelP result) {
+  if (!static_schedule) {
+    input1->connectToOutput(value1, op.get(), usedVariableNames, *ready_signals);
+    if (input2)
+      input2->connectToOutput(value2, op.get(), usedVariableNames, *ready_signals);
+    output->connectToInput(result, op.get(), usedVariableNames, *ready_signals);
+    return;
+  }
+
+  // The core starts as soon as all inputs are ready. They don't change until the
+  // end of the iteration, so it doesn't matter whether the core keeps them.
+  unsigned int start = getReadyTime(value1);
+  if (input2)
+    start = std::max(start, getReadyTime(value2));
+
+  std::string start_signal = op->declare(usedVariableNames.makeUnique(tmpVar + "_start"));
+  *op << "   " << start_signal << " <= " << scheduleCondition("=", start) << ";\n";
+
+  connectStaticInput(tmpVar, op_info, input1, value1, start_signal);
+  if (input2)
+    connectStaticInput(tmpVar, op_info, input2, value2, start_signal);
+
+  // The core sends the result only once, so we keep it in the register of the result.
+  std::string result_data  = usedVariableNames.makeUnique(tmpVar + "_core_data");
+  std::string result_valid = usedVariableNames.makeUnique(tmpVar + "_core_valid");
+  op->outPortMap  (op_info.op, output->data_signal,  result_data);
+  op->outPortMap  (op_info.op, output->valid_signal, result_valid);
+  op->inPortMapCst(op_info.op, output->ready_signal, "'1'");
+
+  *op << "   capture_" << tmpVar << " : process(aclk)\n"
+      << "   begin\n"
+      << "      if rising_edge(aclk) and " << result_valid << " = '1' then\n"
+      << "         " << result->data_signal << " <= " << result_data << ";\n"
+      << "      end if;\n"
+      << "   end process;\n";
+
+  unsigned int ready_time = start + getOperatorResources(op_info.op->getName()).latency + 1;
+  *op << "   " << result->valid_signal << " <= " << scheduleCondition(">=", ready_time) << ";\n";
+  setReadyTime(result, ready_time);
+}
+
+void VHDLBackend::connectStaticInput(const std::string& tmpVar, const OperatorInfo& op_info,
+    ChannelP input, ChannelP value, const std::string& start) {
+  if (value->direction == CONSTANT_OUT)
+    op->inPortMapCst(op_info.op, input->data_signal, value->constant);
+  else
+    op->inPortMap   (op_info.op, input->data_signal, value->data_signal);
+  op->inPortMap     (op_info.op, input->valid_signal, start);
+  op->outPortMap    (op_info.op, input->ready_signal, usedVariableNames.makeUnique(tmpVar + "_" + input->ready_signal));
+}
+
+ChannelP VHDLBackend::captureInput(ChannelP port) {
+  if (ChannelP* captured = getValueOrNull(captured_inputs, port->data_signal))
+    return *captured;
+
+  // The schedule starts when all inputs have arrived, so we keep them in registers
+  // and accept the next ones when the iteration is done.
+  std::string name = port->data_signal.substr(0, port->data_signal.size() - std::string("_data").size());
+  ChannelP captured = Channel::make_variable(op.get(), usedVariableNames.makeUnique(name + "_captured"), port->width);
+  captured_inputs[port->data_signal] = captured;
+
+  *op << "   " << port->ready_signal << " <= not " << captured->valid_signal << ";\n";
+  *op << "   capture_" << name << " : process(aclk)\n"
+      << "   begin\n"
+      << "      if reset = '1' then\n"
+      << "         " << captured->valid_signal << " <= '0';\n"
+      << "         " << captured->data_signal  << " <= (others => '0');\n"
+      << "      elsif rising_edge(aclk) then\n"
+      << "         if " << schedule_name << "_done = '1' then\n"
+      << "            " << captured->valid_signal << " <= '0';\n"
+      << "         elsif " << port->valid_signal << " = '1' and " << captured->valid_signal << " = '0' then\n"
+      << "            " << captured->valid_signal << " <= '1';\n"
+      << "            " << captured->data_signal  << " <= " << port->data_signal << ";\n"
+      << "         end if;\n"
+      << "      end if;\n"
+      << "   end process;\n";
+
+  return captured;
+}
+
+unsigned int VHDLBackend::getReadyTime(ChannelP channel) {
+  if (channel->direction == CONSTANT_OUT)
+    return 0;
+  return getFinishTime(ready_times, channel->data_signal);
+}
+
+void VHDLBackend::setReadyTime(ChannelP channel, unsigned int time) {
+  ready_times[channel->data_signal] = time;
+}
+
+std::string VHDLBackend::scheduleCondition(const std::string& comparison, unsigned int time) {
+  if (comparison == ">=" && time == 0)
+    return schedule_name + "_running";
+  return "'1' WHEN " + schedule_name + "_running = '1' and unsigned(" + schedule_name + "_counter) "
+    + comparison + " " + toString(time) + " ELSE '0'";
+}
+
+unsigned int VHDLBackend::getStaticLatency() {
+  unsigned int latency = 0;
+  for (std::map<std::string, unsigned int>::iterator it = ready_times.begin(); it != ready_times.end(); ++it)
+    latency = std::max(latency, it->second);
+  return latency;
+}
+
+void VHDLBackend::generateSchedule() {
+  // The counter starts when all inputs have arrived and stops at the cycle when the
+  // last result is ready. The next iteration starts after the ReconOS FSM has read
+  // all results.
+  unsigned int latency = getStaticLatency();
+  unsigned int counter_width = 1;
+  while ((1u << counter_width) <= latency)
+    counter_width++;
+
+  std::string counter = op->declare(schedule_name + "_counter", counter_width, true);
+  std::string running = op->declare(schedule_name + "_running");
+  std::string start   = op->declare(schedule_name + "_start");
+  std::string done    = op->declare(schedule_name + "_done");
+
+  std::ostringstream inputs_captured;
+  Seperator sep(" and ");
+  for (std::map<std::string, ChannelP>::iterator it = captured_inputs.begin(); it != captured_inputs.end(); ++it)
+    inputs_captured << sep << it->second->valid_signal;
+  *op << "   " << start << " <= " << (captured_inputs.empty() ? "'1'" : inputs_captured.str()) << ";\n";
+
+  std::vector<std::pair<ChannelP, std::string> > outputs;  // and the signal that it has been accepted
+  std::set<std::string> output_signals;
+  BOOST_FOREACH(ChannelP output, scheduled_outputs) {
+    if (contains(output_signals, output->data_signal))
+      continue;
+    output_signals.insert(output->data_signal);
+    std::string name = output->data_signal.substr(0, output->data_signal.size() - std::string("_data").size());
+    outputs.push_back(std::make_pair(output, op->declare(usedVariableNames.makeUnique(name + "_accepted"))));
+  }
+
+  *op << "   " << done << " <= '1' WHEN " << running << " = '1' and unsigned(" << counter << ") = " << latency;
+  for (unsigned int i = 0; i < outputs.size(); i++)
+    *op << "\n      and " << outputs[i].second << " = '1'";
+  *op << " ELSE '0';\n";
+
+  *op << "   " << schedule_name << " : process(aclk)\n"
+      << "   begin\n"
+      << "      if reset = '1' then\n"
+      << "         " << running << " <= '0';\n"
+      << "         " << counter << " <= (others => '0');\n";
+  for (unsigned int i = 0; i < outputs.size(); i++)
+    *op << "         " << outputs[i].second << " <= '0';\n";
+  *op << "      elsif rising_edge(aclk) then\n"
+      << "         if " << done << " = '1' then\n"
+      << "            " << running << " <= '0';\n"
+      << "         elsif " << running << " = '0' then\n"
+      << "            if " << start << " = '1' then\n"
+      << "               " << running << " <= '1';\n"
+      << "               " << counter << " <= (others => '0');\n"
+      << "            end if;\n"
+      << "         elsif unsigned(" << counter << ") /= " << latency << " then\n"
+      << "            " << counter << " <= std_logic_vector(unsigned(" << counter << ") + 1);\n"
+      << "         end if;\n";
+  for (unsigned int i = 0; i < outputs.size(); i++) {
+    ChannelP output = outputs[i].first;
+    const std::string& accepted = outputs[i].second;
+    *op << "         if " << done << " = '1' then\n"
+        << "            " << accepted << " <= '0';\n"
+        << "         elsif " << output->valid_signal << " = '1' and " << output->ready_signal << " = '1' then\n"
+        << "            " << accepted << " <= '1';\n"
+        << "         end if;\n";
+  }
+  *op << "      end if;\n"
+      << "   end process;\n";
 }
 
 Type* getElementType(Type* type) {
@@ -252,9 +874,12 @@ void VHDLBackend::generateCall(std::string funcName,
 
     mboxGetWithoutInterface(mbox, mbox_channel);
 
+    // Like the arguments, the values of other partitions are inputs of the static schedule.
+    // The partitioning makes sure that they don't depend on our results.
+    ChannelP value = (static_schedule ? captureInput(mbox_channel) : mbox_channel);
 
     ChannelP ch1 = tmp->getWriteChannel(op.get());
-    ch1->connectToOutput(mbox_channel, op.get(), usedVariableNames, *ready_signals);
+    ch1->connectToOutput(value, op.get(), usedVariableNames, *ready_signals);
 
     return;
   } else if (funcName == "_put_real" || funcName == "_put_int" || funcName == "_put_bool") {
@@ -303,6 +928,10 @@ void VHDLBackend::generateCall(std::string funcName,
     return;
   }
 
+  // The functions don't have a fixed latency.
+  if (static_schedule)
+    static_schedule_failed = true;
+
   if (funcName == "mod")
     // not a valid identifier in VHDL -> change it
     // Furthermore, we don't have a working implementation, so we call it 'dummy_mod'.
@@ -353,6 +982,8 @@ void VHDLBackend::generateCall(std::string funcName,
 
   std::string instance_name = (!tmpVar.empty() ? tmpVar : instanceNameGenerator.next());
   *this->op << this->op->instance(func, instance_name);
+
+  addOperation(instance_name, funcName, args);
 }
 
 void VHDLBackend::generateVoidCall(std::string funcName, std::vector<Value*> args) {
@@ -367,13 +998,7 @@ OperatorInfo getComparisonOperator(FCmpInst::Predicate comparePredicate, unsigne
   std::string name;
   bool is_floating_point = false;
   std::string code;
-  bool negate = false;
-# define ignore(x)
   switch (comparePredicate) {
-    case FCmpInst::FCMP_FALSE:
-      ignore("false");
-      assert(false);  // not supported
-      break;
     case FCmpInst::FCMP_OEQ:
       name = "float_cmp";
       is_floating_point = true;
@@ -404,89 +1029,46 @@ OperatorInfo getComparisonOperator(FCmpInst::Predicate comparePredicate, unsigne
       is_floating_point = true;
       code = "\"00101100\"";
       break;
-    case FCmpInst::FCMP_ORD:
-      name = "float_cmp";
-      is_floating_point = true;
-      code = "\"00000100\"";
-      negate = true;  // not supported
-      assert(false);
-      break;
     case FCmpInst::FCMP_UNO:
       name = "float_cmp";
       is_floating_point = true;
       code = "\"00000100\"";
       break;
-    case FCmpInst::FCMP_UEQ:
-      ignore("isnan || ==");
-      assert(false);  // not supported
-      break;
-    case FCmpInst::FCMP_UGT:
-      ignore("isnan || >");
-      assert(false);  // not supported
-      break;
-    case FCmpInst::FCMP_UGE:
-      ignore("isnan || >=");
-      assert(false);  // not supported
-      break;
-    case FCmpInst::FCMP_ULT:
-      ignore("isnan || <");
-      assert(false);  // not supported
-      break;
-    case FCmpInst::FCMP_ULE:
-      ignore("isnan || <=");
-      assert(false);  // not supported
-      break;
-    case FCmpInst::FCMP_UNE:
-      ignore("isnan || !=");
-      assert(false);  // not supported
-      break;
-    case FCmpInst::FCMP_TRUE:
-      ignore("true");
-      assert(false);  // not supported
-      break;
     case FCmpInst::ICMP_EQ:
-      ignore("==");
-      assert(false);  // not supported
+      name = "icmp_eq";
       break;
     case FCmpInst::ICMP_NE:
       name = "icmp_ne";
       break;
     case FCmpInst::ICMP_UGT:
-      ignore(">");
-      assert(false);  // not supported
+      name = "icmp_ugt";
       break;
     case FCmpInst::ICMP_UGE:
-      ignore(">=");
-      assert(false);  // not supported
+      name = "icmp_uge";
       break;
     case FCmpInst::ICMP_ULT:
-      ignore("<");
-      assert(false);  // not supported
+      name = "icmp_ult";
       break;
     case FCmpInst::ICMP_ULE:
-      ignore("<=");
-      assert(false);  // not supported
+      name = "icmp_ule";
       break;
     case FCmpInst::ICMP_SGT:
       name = "icmp_sgt";
       break;
     case FCmpInst::ICMP_SGE:
-      ignore(">=");
-      assert(false);  // not supported
+      name = "icmp_sge";
       break;
     case FCmpInst::ICMP_SLT:
-      ignore("<");
-      assert(false);  // not supported
+      name = "icmp_slt";
       break;
     case FCmpInst::ICMP_SLE:
-      ignore("<=");
-      assert(false);  // not supported
+      name = "icmp_sle";
       break;
     default:
+      // The other floating point predicates are mapped to these ones by generateComparison.
       assert(false);
       break;
   }
-# undef ignore
 
   std::string input_prefix, output_prefix, data_suffix, valid_suffix, ready_suffix;
   if (is_floating_point) {
@@ -521,10 +1103,6 @@ OperatorInfo getComparisonOperator(FCmpInst::Predicate comparePredicate, unsigne
     op->addOutput(input_prefix  + "operation" + ready_suffix);
   }
 
-  if (negate) {
-    //TODO
-  }
-
   OperatorInfo op_info = { op,
     input_prefix+"a", input_prefix+"b", output_prefix+"result",
     data_suffix, valid_suffix, ready_suffix,
@@ -540,26 +1118,58 @@ void VHDLBackend::generateComparison(std::string tmpVar, Value *op1, Value *op2,
 
   ValueStorageP tmp = vs_factory->getTemporaryVariable(tmpVar);
 
+  // The float comparator only knows the ordered predicates and UNO, so we use the
+  // inverse predicate for the others and negate the result. FALSE and TRUE still
+  // use a comparator, so they wait for their inputs.
+  bool negate = false;
+  std::string constant_result;
+  switch (comparePredicate) {
+    case FCmpInst::FCMP_FALSE:
+    case FCmpInst::FCMP_TRUE:
+      constant_result = (comparePredicate == FCmpInst::FCMP_TRUE ? "'1'" : "'0'");
+      comparePredicate = FCmpInst::FCMP_UNO;
+      break;
+    case FCmpInst::FCMP_ORD:
+    case FCmpInst::FCMP_UEQ:
+    case FCmpInst::FCMP_UGT:
+    case FCmpInst::FCMP_UGE:
+    case FCmpInst::FCMP_ULT:
+    case FCmpInst::FCMP_ULE:
+    case FCmpInst::FCMP_UNE:
+      negate = true;
+      comparePredicate = FCmpInst::getInversePredicate(comparePredicate);
+      break;
+    default:
+      break;
+  }
+
   OperatorInfo op_info = getComparisonOperator(comparePredicate, vs_factory->get(op1)->width());
 
   ChannelP input1 = Channel::make_component_input (op_info.op, op_info.input1, op_info);
   ChannelP input2 = Channel::make_component_input (op_info.op, op_info.input2, op_info);
   ChannelP output = Channel::make_component_output(op_info.op, op_info.output, op_info);
 
-  input1->connectToOutput(read(vs_factory->get(op1)),     op.get(), usedVariableNames, *ready_signals);
-  input2->connectToOutput(read(vs_factory->get(op2)),     op.get(), usedVariableNames, *ready_signals);
+  ChannelP read1 = read(vs_factory->get(op1));
+  ChannelP read2 = read(vs_factory->get(op2));
   if (output->width == 1) {
-    output->connectToInput (tmp->getWriteChannel(op.get()), op.get(), usedVariableNames, *ready_signals);
+    connectOperator(tmpVar, op_info, input1, read1, input2, read2, output, tmp->getWriteChannel(op.get()));
   } else {
     ValueStorageP tmp_8bit = vs_factory->makeAnonymousTemporaryVariable(IntegerType::get(tmp->type->getContext(), 8));
-    output->connectToInput (tmp_8bit->getWriteChannel(op.get()), op.get(), usedVariableNames, *ready_signals);
+    connectOperator(tmpVar, op_info, input1, read1, input2, read2, output, tmp_8bit->getWriteChannel(op.get()));
 
     ChannelP tmp_write = tmp->getWriteChannel(op.get());
     ChannelP tmp_8bit_read = tmp_8bit->getReadChannel(op.get());
 
-    *op << "   " << tmp_write->data_signal  << "(0) <= " << tmp_8bit_read->data_signal << "(0);\n";
+    std::string result = tmp_8bit_read->data_signal + "(0)";
+    if (!constant_result.empty())
+      result = constant_result;
+    else if (negate)
+      result = "not " + result;
+
+    *op << "   " << tmp_write->data_signal  << "(0) <= " << result << ";\n";
     *op << "   " << tmp_write->valid_signal << " <= " << tmp_8bit_read->valid_signal << ";\n";
     ready_signals->addConsumer(tmp_8bit_read->ready_signal, tmp_write->ready_signal);
+    setReadyTime(tmp_write, getReadyTime(tmp_8bit_read));
   }
 
   this->op->inPortMap(op_info.op, "aclk", "aclk");
@@ -570,6 +1180,11 @@ void VHDLBackend::generateComparison(std::string tmpVar, Value *op1, Value *op2,
   }
 
   *this->op << this->op->instance(op_info.op, tmpVar);
+
+  std::vector<Value*> inputs;
+  inputs.push_back(op1);
+  inputs.push_back(op2);
+  addOperation(tmpVar, op_info.op->getName(), inputs);
 }
 
 void VHDLBackend::generateIntegerExtension(std::string tmpVar, Value *value) {
@@ -592,6 +1207,147 @@ void VHDLBackend::generateIntegerExtension(std::string tmpVar, Value *value) {
 
   *op << "   " << write->valid_signal << " <= " << read->valid_signal << ";\n";
   ready_signals->addConsumer(read->ready_signal, write->ready_signal);
+  setReadyTime(write, getReadyTime(read));
+}
+
+OperatorInfo getConversionOperator(unsigned opcode, unsigned input_width, unsigned output_width) {
+  std::string name;
+  switch (opcode) {
+    case Instruction::SIToFP:
+      name = "sitofp";
+      break;
+    case Instruction::UIToFP:
+      name = "uitofp";
+      break;
+    case Instruction::FPToSI:
+      name = "fptosi";
+      break;
+    case Instruction::FPToUI:
+      name = "fptoui";
+      break;
+    default:
+      assert(false);
+  }
+
+  //TODO load from PivPav
+  ::Operator* op = new ::Operator();
+  op->setName(name);
+  op->addPort  ("aclk",1,1,1,0,0,0,0,0,0,0,0);
+  op->addInput ("a_data", input_width, true);
+  op->addOutput("result_data", output_width, 1, true);
+  op->addInput ("a_valid");
+  op->addOutput("result_valid");
+  op->addOutput("a_ready");
+  op->addInput ("result_ready");
+
+  OperatorInfo op_info = { op,
+    "a", "", "result",
+    "_data", "_valid", "_ready"
+  };
+  return op_info;
+}
+
+void VHDLBackend::generateUnaryOperator(std::string tmpVar, Value *value, const OperatorInfo& op_info) {
+  ValueStorageP tmp = vs_factory->getTemporaryVariable(tmpVar);
+
+  ChannelP input  = Channel::make_component_input (op_info.op, op_info.input1, op_info);
+  ChannelP output = Channel::make_component_output(op_info.op, op_info.output, op_info);
+
+  connectOperator(tmpVar, op_info,
+    input, read(vs_factory->get(value)),
+    ChannelP(), ChannelP(),
+    output, tmp->getWriteChannel(op.get()));
+
+  this->op->inPortMap(op_info.op, "aclk", "aclk");
+
+  *this->op << this->op->instance(op_info.op, tmpVar);
+
+  addOperation(tmpVar, op_info.op->getName(), std::vector<Value*>(1, value));
+}
+
+void VHDLBackend::generateCast(std::string tmpVar, Value *value, Type *type, unsigned opcode) {
+  debug_print("generateCast(" << tmpVar << ", " << value << ", " << Instruction::getOpcodeName(opcode) << ")");
+  return_if_dry_run();
+
+  switch (opcode) {
+    case Instruction::ZExt:
+      generateIntegerExtension(tmpVar, value);
+      return;
+    case Instruction::SIToFP:
+    case Instruction::UIToFP:
+    case Instruction::FPToSI:
+    case Instruction::FPToUI:
+      generateUnaryOperator(tmpVar, value, getConversionOperator(opcode,
+        vs_factory->get(value)->width(), vs_factory->getTemporaryVariable(tmpVar)->width()));
+      return;
+    default:
+      break;
+  }
+
+  // The other casts only change the wires.
+  ChannelP write = vs_factory->getTemporaryVariable(tmpVar)->getWriteChannel(op.get());
+  ChannelP read  = this->read(vs_factory->get(value));
+
+  std::string data = getDataExpression(read, value);
+  switch (opcode) {
+    case Instruction::SExt:
+      data = "std_logic_vector(resize(signed(" + data + "), " + toString(write->width) + "))";
+      break;
+    case Instruction::Trunc:
+      data = "std_logic_vector(resize(unsigned(" + data + "), " + toString(write->width) + "))";
+      break;
+    case Instruction::BitCast:
+      break;
+    default:
+      errs() << "ERROR: Cast " << Instruction::getOpcodeName(opcode) << " is not supported!\n";
+      assert(false);
+      break;
+  }
+
+  *op << "   " << write->data_signal << " <= " << data << ";\n";
+  *op << "   " << write->valid_signal << " <= " << getValidExpression(read) << ";\n";
+  if (read->direction != CONSTANT_OUT)
+    ready_signals->addConsumer(read->ready_signal, write->ready_signal);
+  setReadyTime(write, getReadyTime(read));
+}
+
+bool VHDLBackend::isSupported(Instruction* instr) {
+  if (BinaryOperator* binop = dyn_cast<BinaryOperator>(instr)) {
+    unsigned opcode = binop->getOpcode();
+    if (opcode == Instruction::FRem)
+      // we don't have a component for it
+      return false;
+    else if (binop->getType()->isIntegerTy(1))
+      return (opcode == Instruction::And || opcode == Instruction::Or || opcode == Instruction::Xor);
+    else if (binop->getType()->isIntegerTy())
+      // the integer cores have 32-bit ports
+      return binop->getType()->isIntegerTy(32);
+    else
+      return true;
+  } else if (ICmpInst* cmp = dyn_cast<ICmpInst>(instr)) {
+    return cmp->getOperand(0)->getType()->isIntegerTy(32);
+  } else if (CastInst* castInstr = dyn_cast<CastInst>(instr)) {
+    switch (castInstr->getOpcode()) {
+      case Instruction::ZExt:
+      case Instruction::SExt:
+      case Instruction::Trunc:
+      case Instruction::BitCast:
+        return true;
+      case Instruction::SIToFP:
+      case Instruction::UIToFP:
+        return castInstr->getSrcTy()->isIntegerTy(32) && castInstr->getDestTy()->isDoubleTy();
+      case Instruction::FPToSI:
+      case Instruction::FPToUI:
+        return castInstr->getSrcTy()->isDoubleTy() && castInstr->getDestTy()->isIntegerTy(32);
+      default:
+        return false;
+    }
+  } else {
+    return isa<CmpInst>(instr) || isa<SelectInst>(instr) || isa<PHINode>(instr)
+      || isa<BranchInst>(instr) || isa<ReturnInst>(instr) || isa<CallInst>(instr)
+      || isa<LoadInst>(instr) || isa<StoreInst>(instr) || isa<GetElementPtrInst>(instr)
+      || isa<AllocaInst>(instr);
+  }
 }
 
 void VHDLBackend::generatePhiNodeAssignment(std::string tmpVar, Value *op) {
@@ -651,10 +1407,18 @@ void VHDLBackend::generatePhiNode(ValueStorageP target, Value* condition, ValueS
   debug_print("generatePhiNode(...)");
   return_if_dry_run();
 
-  // make sure we cannot miss the valid signal
-  ChannelP condition_rem  = remember(vs_factory->get(condition))->getReadChannel(op.get());
-  ChannelP trueValue_rem  = remember(trueValue)->getReadChannel(op.get());
-  ChannelP falseValue_rem = remember(falseValue)->getReadChannel(op.get());
+  ChannelP condition_rem, trueValue_rem, falseValue_rem;
+  if (static_schedule) {
+    // The values stay valid until the end of the iteration, so we don't have to remember them.
+    condition_rem  = read(vs_factory->get(condition));
+    trueValue_rem  = read(trueValue);
+    falseValue_rem = read(falseValue);
+  } else {
+    // make sure we cannot miss the valid signal
+    condition_rem  = remember(vs_factory->get(condition))->getReadChannel(op.get());
+    trueValue_rem  = remember(trueValue)->getReadChannel(op.get());
+    falseValue_rem = remember(falseValue)->getReadChannel(op.get());
+  }
 
   ChannelP target_w = target->getWriteChannel(op.get());
 
@@ -668,6 +1432,8 @@ void VHDLBackend::generatePhiNode(ValueStorageP target, Value* condition, ValueS
       << "      " << falseValue_rem->data_signal
           << " WHEN " << condition_rem->valid_signal << " = '1' and " << condition_rem->data_signal << "(0) = '0' ELSE\n"
       << "      (others => 'X');\n";
+  setReadyTime(target_w, std::max(getReadyTime(condition_rem),
+    std::max(getReadyTime(trueValue_rem), getReadyTime(falseValue_rem))));
 }
 
 
@@ -692,7 +1458,10 @@ void VHDLBackend::generateReturn(Value *retVal) {
   }
 
   mboxPutWithoutInterface(1, ch1);
+  markFirstResult();
   interface_ccode << "return mbox_get_" << type << "(&mbox_stop);\n";
+  mbox_outputs.push_back(std::make_pair(type, std::string("return_value")));
+  return_type = type;
 }
 
 
@@ -700,9 +1469,18 @@ void VHDLBackend::generateEndOfMethod() {
   debug_print("generateEndOfMethod()");
   return_if_dry_run();
 
-  std::stringstream s;
-  ready_signals->outputVHDL(s);
-  *op << s.str();
+  for (std::map<std::string, std::vector<SharedCore> >::iterator it = shared_cores.begin(); it != shared_cores.end(); ++it)
+    BOOST_FOREACH(SharedCore& core, it->second)
+      generateSharedCore(core);
+
+  if (static_schedule) {
+    // Nobody waits for the ready signals of the statically scheduled values.
+    generateSchedule();
+  } else {
+    std::stringstream s;
+    ready_signals->outputVHDL(s);
+    *op << s.str();
+  }
 
   op->outputVHDL(*stream);
 
@@ -805,6 +1583,9 @@ ChannelP VHDLBackend::read(ValueStorageP value) {
     if (!value->hasBeenWrittenTo()) {
       ChannelP external_channel = read_channel;
       mboxGet(0, external_channel, value);
+
+      if (static_schedule)
+        read_channel = captureInput(external_channel);
     }
   }
 
@@ -812,14 +1593,6 @@ ChannelP VHDLBackend::read(ValueStorageP value) {
 }
 
 void VHDLBackend::mboxGet(unsigned int mbox, ChannelP channel_of_op, ValueStorageP value) {
-  mboxGetWithoutInterface(mbox, channel_of_op);
-
-  std::string key = channel_of_op->data_signal;
-  if (contains(read_values, key))
-    return;
-  else
-    read_values.insert(key);
-
   std::string type;
   switch (value->width()) {
     case  1: // Boolean type in LLVM. Represented by an int.
@@ -834,10 +1607,40 @@ void VHDLBackend::mboxGet(unsigned int mbox, ChannelP channel_of_op, ValueStorag
   if (ccode == "status")
     ccode = "*" + ccode;
 
+  std::string key = channel_of_op->data_signal;
+
+  if (mbox == 0 && contains(invariant_inputs, ccode)) {
+    // the hardware keeps cached inputs in a register, so it reads them only once
+    if (!contains(read_values, key)) {
+      read_values.insert(key);
+      mboxGetWithoutInterface(mbox, channel_of_op, true);
+      cached_inputs.push_back(std::make_pair(type, ccode));
+    }
+    return;
+  }
+
+  mboxGetWithoutInterface(mbox, channel_of_op);
+
+  if (contains(read_values, key))
+    return;
+  else
+    read_values.insert(key);
+
   if (mbox != 0)
     interface_ccode << "_put_" << type << "(" << toString(mbox) << ", " << ccode << ");\n";
-  else
+  else if (static_schedule && firstResultPosition != std::string::npos) {
+    // the static schedule needs all inputs before the first result, so we send them at the start
+    std::string code = interface_ccode.str();
+    std::string put = "mbox_put_" + type + "(&mbox_start, " + ccode + ");\n";
+    code.insert(firstResultPosition, put);
+    firstResultPosition += put.size();
+    interface_ccode.str(code);
+    interface_ccode.seekp(0, std::ios_base::end);
+    mbox_inputs.push_back(std::make_pair(type, ccode));
+  } else {
     interface_ccode << "mbox_put_" << type << "(&mbox_start, " << ccode << ");\n";
+    mbox_inputs.push_back(std::make_pair(type, ccode));
+  }
 }
 
 void VHDLBackend::mboxPut(unsigned int mbox, ChannelP channel_of_op, ValueStorageP value) {
@@ -857,18 +1660,29 @@ void VHDLBackend::mboxPut(unsigned int mbox, ChannelP channel_of_op, ValueStorag
   if (ccode == "status")
     ccode = "*" + ccode;
 
+  markFirstResult();
   if (mbox != 1)
     interface_ccode << ccode << " = _get_" << type << "(" << mbox << ");\n";
-  else
+  else {
     interface_ccode << ccode << " = mbox_get_" << type << "(&mbox_stop);\n";
+    mbox_outputs.push_back(std::make_pair(type, ccode));
+  }
 }
 
-void VHDLBackend::mboxGetWithoutInterface(unsigned int mbox, ChannelP channel_of_op) {
+void VHDLBackend::markFirstResult() {
+  if (firstResultPosition == std::string::npos)
+    firstResultPosition = interface_ccode.str().size();
+}
+
+void VHDLBackend::mboxGetWithoutInterface(unsigned int mbox, ChannelP channel_of_op, bool cached) {
   // channel_of_op is the input channel of the calculation, so we have to revert its
   // direction to use it as a dummy output channel for the ReconOS FSM.
   ChannelDirection::Direction backup = channel_of_op->direction;
   channel_of_op->direction = (ChannelDirection::Direction) (backup | ChannelDirection::IN);
-  r_op->readMbox(mbox, channel_of_op);
+  if (cached)
+    r_op->readCachedMbox(mbox, channel_of_op);
+  else
+    r_op->readMbox(mbox, channel_of_op, static_schedule);
   channel_of_op->direction = backup;
 }
 
@@ -879,4 +1693,6 @@ void VHDLBackend::mboxPutWithoutInterface(unsigned int mbox, ChannelP channel_of
   channel_of_op->direction = (ChannelDirection::Direction) (backup | ChannelDirection::OUT);
   r_op->writeMbox(mbox, channel_of_op);
   channel_of_op->direction = backup;
+
+  scheduled_outputs.push_back(channel_of_op);
 }
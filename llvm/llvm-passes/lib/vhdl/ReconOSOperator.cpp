@@ -8,7 +8,8 @@
 #include <iomanip>
 
 
-BasicReconOSOperator::BasicReconOSOperator() : calculation(NULL), stateNameGenerator("STATE") {
+BasicReconOSOperator::BasicReconOSOperator()
+    : calculation(NULL), stateNameGenerator("STATE"), cachedInputStateCount(0), firstWriteState(UINT_MAX) {
   addInput ("OSIF_FIFO_Sw2Hw_Data", 32);
   addInput ("OSIF_FIFO_Sw2Hw_Fill", 16);
   addInput ("OSIF_FIFO_Sw2Hw_Empty");
@@ -297,8 +298,10 @@ void BasicReconOSOperator::outputStatemachine(std::ostream& o) {
     << "          done  := False;" << endl
     << "          addr <= (others => '0');" << endl
     << "          len <= (others => '0');" << endl
-    << "          init <= '1';" << endl
-    << endl;
+    << "          init <= '1';" << endl;
+  if (cachedInputStateCount > 0)
+    o << "          cached_inputs_version <= (others => '0');" << endl;
+  o << endl;
 
 
   BOOST_FOREACH(Signal* sig, *calculation->getIOList()) {
@@ -323,6 +326,13 @@ void BasicReconOSOperator::outputStatemachine(std::ostream& o) {
     }
   }
 
+  // INIT jumps over the cached inputs, if their version hasn't changed
+  State* afterCachedInputs = NULL;
+  if (cachedInputStateCount > 0 && !sequential_states.empty()) {
+    assert(sequential_states.front()->name == "INIT");
+    afterCachedInputs = sequential_states[(1 + cachedInputStateCount) % sequential_states.size()];
+  }
+
   BOOST_FOREACH(const State* state, states) {
     if (!state->comment.empty())
       o << prefixAllLines("            -- ", state->comment) << endl;
@@ -335,6 +345,11 @@ void BasicReconOSOperator::outputStatemachine(std::ostream& o) {
       s << "state <= STATE_" << state->nextSequentialState->name << ";";
       vhdl = replace("$next", s.str(), vhdl);
     }
+    if (afterCachedInputs) {
+      std::ostringstream s;
+      s << "state <= STATE_" << afterCachedInputs->name << ";";
+      vhdl = replace("$skip_cached_inputs", s.str(), vhdl);
+    }
 
     std::string indent = "               ";
     vhdl = prefixAllLines(indent, vhdl);
@@ -377,9 +392,21 @@ void BasicReconOSOperator::addInitialState() {
       << "  -- elsif (addr = X\"FFFFFFFE\") then" << endl
       << "  --   state <= STATE_READ;" << endl
       << "  --elsif (addr = X\"FFFFFFFD\") then" << endl
-      << "  --  state <= STATE_READ_ITERATIONS;" << endl
+      << "  --  state <= STATE_READ_ITERATIONS;" << endl;
+  if (cachedInputStateCount > 0) {
+    // the mbox word is the version of the cached inputs
+    state.vhdl
+      << "  elsif (addr = cached_inputs_version) then" << endl
+      << "    $skip_cached_inputs" << endl
       << "  else" << endl
-      << "    $next" << endl
+      << "    cached_inputs_version <= addr;" << endl
+      << "    $next" << endl;
+  } else {
+    state.vhdl
+      << "  else" << endl
+      << "    $next" << endl;
+  }
+  state.vhdl
       << "  end if;" << endl
       << "end if;" << endl
       << endl;
@@ -390,6 +417,15 @@ void BasicReconOSOperator::addInitialState() {
     else if (isReadyOfOutputSignal(sig))
       state.vhdl << sig->getName() << " <= '0';" << endl;
   }
+
+  if (cachedInputStateCount > 0) {
+    // the registers still contain the cached inputs
+    state.vhdl << "if done and addr = cached_inputs_version then" << endl;
+    BOOST_FOREACH(const std::string& valid_signal, cachedInputValidSignals) {
+      state.vhdl << "  " << valid_signal << " <= '1';" << endl;
+    }
+    state.vhdl << "end if;" << endl;
+  }
 }
 
 void BasicReconOSOperator::addThreadExitState() {
@@ -458,7 +494,8 @@ void BasicReconOSOperator::readMemory(const std::string& state_name, const std::
       << "end if;" << endl;
 }
 
-void BasicReconOSOperator::readMbox(const std::string& state_name, unsigned int mbox, const ChannelP channel) {
+void BasicReconOSOperator::readMbox(const std::string& state_name, unsigned int mbox, const ChannelP channel,
+    unsigned int state_pos) {
   assert(channel && ChannelDirection::matching_direction(ChannelDirection::IN, channel->direction));
 
   unsigned width = channel->width;
@@ -466,7 +503,9 @@ void BasicReconOSOperator::readMbox(const std::string& state_name, unsigned int
   splitAccessIntoWordsForWriting(channel->data_signal, width, parts);
 
   BOOST_FOREACH(const std::string& part, parts) {
-    State& state = addSequentialState(getUniqueStateName(state_name));
+    State& state = addSequentialState(getUniqueStateName(state_name), state_pos);
+    if (state_pos != UINT_MAX)
+      state_pos++;
 
     state.vhdl
       << "osif_mbox_get(i_osif, o_osif, std_logic_vector(to_unsigned(" << mbox << ", 32)), "
@@ -483,9 +522,34 @@ void BasicReconOSOperator::readMbox(const std::string& state_name, unsigned int
   }
 }
 
+void BasicReconOSOperator::readCachedMbox(const std::string& state_name, unsigned int mbox, const ChannelP channel) {
+  assert(!contains(states_by_name, std::string("INIT")));
+
+  if (cachedInputStateCount == 0)
+    declare("cached_inputs_version", 32);
+
+  unsigned int state_count = sequential_states.size();
+  readMbox(state_name, mbox, channel, cachedInputStateCount);
+  cachedInputStateCount += sequential_states.size() - state_count;
+  if (firstWriteState != UINT_MAX)
+    firstWriteState += sequential_states.size() - state_count;
+
+  cachedInputValidSignals.push_back(channel->valid_signal);
+}
+
+void BasicReconOSOperator::readMboxBeforeWrites(const std::string& state_name, unsigned int mbox, const ChannelP channel) {
+  unsigned int state_count = sequential_states.size();
+  readMbox(state_name, mbox, channel, firstWriteState);
+  if (firstWriteState != UINT_MAX)
+    firstWriteState += sequential_states.size() - state_count;
+}
+
 void BasicReconOSOperator::writeMbox(const std::string& state_name, unsigned int mbox, const ChannelP channel) {
   assert(channel && ChannelDirection::matching_direction(ChannelDirection::OUT, channel->direction));
 
+  if (firstWriteState == UINT_MAX)
+    firstWriteState = sequential_states.size();
+
   unsigned width = channel->width;
   std::vector<std::string> parts;
   splitAccessIntoWords(channel->data_signal, width, parts);
@@ -697,8 +761,15 @@ void LocalFakeRam::generateCode(std::ostream& stream) const {
 }
 
 
-void ReconOSOperator::readMbox(unsigned int mbox, const ChannelP channel) {
-  BasicReconOSOperator::readMbox(getUniqueStateName("MBOX_READ_" + channel->data_signal), mbox, channel);
+void ReconOSOperator::readMbox(unsigned int mbox, const ChannelP channel, bool before_writes) {
+  if (before_writes)
+    BasicReconOSOperator::readMboxBeforeWrites(getUniqueStateName("MBOX_READ_" + channel->data_signal), mbox, channel);
+  else
+    BasicReconOSOperator::readMbox(getUniqueStateName("MBOX_READ_" + channel->data_signal), mbox, channel);
+}
+
+void ReconOSOperator::readCachedMbox(unsigned int mbox, const ChannelP channel) {
+  BasicReconOSOperator::readCachedMbox(getUniqueStateName("MBOX_READ_CACHED_" + channel->data_signal), mbox, channel);
 }
 
 void ReconOSOperator::writeMbox(unsigned int mbox, const ChannelP channel) {
@@ -0,0 +1,92 @@
+// Standalone partitioner: applies the partitioning methods to a partitioning graph
+// that has been saved by the partitioning pass (-partitioning-export-graph) and writes
+// the resulting assignment, which can be used by the pass (-partitioning-assignment).
+
+#include "mehari/Transforms/PartitioningGraph.h"
+#include "mehari/Transforms/PartitioningAlgorithms.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <ctime>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+
+static cl::opt<std::string> InputFilename(cl::Positional,
+            cl::desc("<partitioning graph>"), cl::Required);
+static cl::opt<std::string> OutputFilename("o",
+            cl::desc("Set the file for the partitioning assignment"),
+            cl::value_desc("filename"), cl::init("-"));
+static cl::opt<std::string> Methods("methods",
+            cl::desc("Specify the partitioning methods (seperated by whitespace)"),
+            cl::value_desc("partitioning-methods"), cl::init("clustering"));
+static cl::opt<std::string> Devices("devices",
+            cl::desc("Specify the devices to execute the partitions (seperated by whitespace), "
+            	"default: the devices of the partitioning graph"),
+            cl::value_desc("partitioning-devices"));
+
+
+int main(int argc, char **argv) {
+	cl::ParseCommandLineOptions(argc, argv, "mehari partitioner for saved partitioning graphs\n");
+
+	PartitioningGraph pGraph;
+	std::string functionName;
+	std::vector<std::string> graphDevices;
+	if (!pGraph.load(InputFilename, functionName, graphDevices))
+		return 1;
+
+	std::vector<std::string> methods, devices;
+	boost::algorithm::split(methods, Methods, boost::algorithm::is_any_of(" "), boost::algorithm::token_compress_on);
+	if (Devices.empty())
+		devices = graphDevices;
+	else
+		boost::algorithm::split(devices, Devices, boost::algorithm::is_any_of(" "), boost::algorithm::token_compress_on);
+
+	// the graph only has the costs of its devices, the others would cost nothing
+	for (std::vector<std::string>::iterator it = devices.begin(); it != devices.end(); ++it) {
+		if (std::find(graphDevices.begin(), graphDevices.end(), *it) == graphDevices.end()) {
+			errs() << "ERROR: The partitioning graph " << InputFilename << " doesn't have the costs of device " << *it << "\n";
+			return 1;
+		}
+	}
+
+	unsigned int partitionCount = 1;
+	for (std::vector<std::string>::iterator it = methods.begin(); it != methods.end(); ++it) {
+		if (it == methods.begin())
+			createInitialPartitioning(*it, pGraph, devices);
+
+		if (*it == "nop") {
+			partitionCount = 1;
+			continue;
+		}
+
+		AbstractPartitioningMethod *PM = createPartitioningMethod(*it);
+		if (PM == NULL) {
+			errs() << "ERROR: Invalid partitioning method " << *it << "\n";
+			return 1;
+		}
+
+		clock_t start = std::clock();
+		partitionCount = PM->apply(pGraph, devices);
+		clock_t ends = std::clock();
+		delete PM;
+
+		double runtime = (double) (ends - start) / CLOCKS_PER_SEC * 1000;
+		errs() << "Runtime for partitioning " << functionName << " using " << *it << ": "
+			<< format("%4.4f", runtime) << " ms\n";
+	}
+
+	errs() << "Critical path length for " << functionName << ": " << pGraph.getCriticalPathCost(devices) << "\n";
+
+	std::string outputFilename = OutputFilename;
+	if (outputFilename == "-")
+		outputFilename = "/dev/stdout";
+	if (!pGraph.saveAssignment(outputFilename, functionName, partitionCount))
+		return 1;
+
+	return 0;
+}
@@ -30,6 +30,30 @@ protected:
 
 }; // end class SimpleCCodeGeneratorTest
 
+class SimpleCCodeGeneratorWaitCountersTest : public CodeGeneratorTest {
+
+protected:
+  CodeGeneratorBackend* createBackend() {
+    CCodeBackend* backend = new CCodeBackend();
+    backend->setWaitCounters(3, 2);
+    return backend;
+  }
+
+}; // end class SimpleCCodeGeneratorWaitCountersTest
+
+class SimpleCCodeGeneratorPackingTest : public CodeGeneratorTest {
+
+protected:
+  CodeGeneratorBackend* createBackend() {
+    return new CCodeBackend();
+  }
+
+  void configureCodeGenerator() {
+    codeGen->setSLPPacking(true);
+  }
+
+}; // end class SimpleCCodeGeneratorPackingTest
+
 } // end anonymous namespace
 
 
@@ -224,3 +248,85 @@ TEST_F(SimpleCCodeGeneratorTest, IntegerExtensionTest) {
     "\tt0 = (int)a;\n"
     "\treturn t0;\n");
 }
+
+
+TEST_F(SimpleCCodeGeneratorTest, SignExtensionTest) {
+  ParseC(
+    "int test(short a) {"
+    "  return a;"
+    "}");
+  CheckResult(
+    "\tint t0;\n"
+    "\tt0 = (int)a;\n"
+    "\treturn t0;\n");
+}
+
+
+TEST_F(SimpleCCodeGeneratorTest, UnsignedDivisionTest) {
+  ParseC(
+    "unsigned int test(unsigned int a) {"
+    "  return a / 3;"
+    "}");
+  CheckResult(
+    "\tint t0;\n"
+    "\tt0 = (unsigned int)a / (unsigned int)3;\n"
+    "\treturn t0;\n");
+}
+
+
+TEST_F(SimpleCCodeGeneratorTest, ConversionTest) {
+  ParseC(
+    "int test(double a) {"
+    "  return a;"
+    "}");
+  CheckResult(
+    "\tint t0;\n"
+    "\tt0 = (int)a;\n"
+    "\treturn t0;\n");
+}
+
+
+TEST_F(SimpleCCodeGeneratorWaitCountersTest, CommunicationCallTest) {
+  ParseC(
+    "void _put_real(int, double);"
+    "void test(double a) {"
+    "  _put_real(1, a + 2);"
+    "}");
+  CheckResult(
+    "\tdouble t0;\n"
+    "\tuint64_t _mehari_wait_start;\n"
+    "\tuint64_t _mehari_partition_start = _mehari_wait_begin();\n"
+    "\tt0 = a + 2;\n"
+    "\t_mehari_wait_start = _mehari_wait_begin();\n"
+    "\t_put_real(1, t0);\n"
+    "\t_mehari_wait_end(3, MEHARI_WAIT_DATA, 1, _mehari_wait_start);\n"
+    "\t_mehari_partition_end(3, _mehari_partition_start);\n");
+}
+
+
+TEST_F(SimpleCCodeGeneratorWaitCountersTest, ReturnValueTest) {
+  ParseC(
+    "double test(double a) {"
+    "  return a+2;"
+    "}");
+  CheckResult(
+    "\tdouble t0;\n"
+    "\tuint64_t _mehari_partition_start = _mehari_wait_begin();\n"
+    "\tt0 = a + 2;\n"
+    "\t_mehari_partition_end(3, _mehari_partition_start);\n"
+    "\treturn t0;\n");
+}
+
+
+TEST_F(SimpleCCodeGeneratorPackingTest, IndependentMultiplicationsTest) {
+  ParseC(
+    "void test(double* a, double* b) {"
+    "  b[0] = a[0]*a[1] + a[2]*a[3];"
+    "}");
+  CheckResult(
+    "\tdouble t1;\n"
+    "\tmehari_v2df t0;\n"
+    "\tt0 = ((mehari_v2df){a[0], a[2]}) * ((mehari_v2df){a[1], a[3]});\n"
+    "\tt1 = t0[0] + t0[1];\n"
+    "\tb[0] = t1;\n");
+}
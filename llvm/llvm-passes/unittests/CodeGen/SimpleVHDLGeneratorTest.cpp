@@ -19,6 +19,7 @@
 #include "Signal.hpp"
 
 #include <vector>
+#include <set>
 #include <string>
 #include <sstream>
 #include <iostream>
@@ -455,6 +456,233 @@ TEST_F(SimpleVHDLGeneratorTest, IntegerExtensionTest) {
 }
 
 
+TEST_F(SimpleVHDLGeneratorTest, SignExtensionTest) {
+  ParseC(
+    "int test(short a) {"
+    "  return a;"
+    "}");
+  CheckResultFromFile();
+
+
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setSignedIntegerInput("a_in", -5);
+  test->endDataInput();
+  test->waitForAndCheckSignedIntegerResult("return", "-5");
+
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+
+TEST_F(SimpleVHDLGeneratorTest, XorTest) {
+  ParseC(
+    "void test(int a, int b) {"
+    "  b = a ^ 6;"
+    "}");
+  CheckResultFromFile();
+
+
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setUnsignedIntegerInput("a_in", 32+4+1);
+  test->endDataInput();
+  test->waitForAndCheckUnsignedIntegerResult("b_out", "35");
+
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+
+TEST_F(SimpleVHDLGeneratorTest, ShiftTest) {
+  ParseC(
+    "void test(int a, int b) {"
+    "  b = a << 3;"
+    "}");
+  CheckResultFromFile();
+
+
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setUnsignedIntegerInput("a_in", 5);
+  test->endDataInput();
+  test->waitForAndCheckUnsignedIntegerResult("b_out", "40");
+
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+
+TEST_F(SimpleVHDLGeneratorTest, IntegerComparisonTest) {
+  ParseC(
+    "void test(int a, int b) {"
+    "  if (a < 3)"
+    "    b = 2;"
+    "}");
+  CheckResultFromFile();
+
+
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setSignedIntegerInput("a_in", -4);
+  test->setUnsignedIntegerInput("b_in", 7);
+  test->endDataInput();
+  test->waitForAndCheckUnsignedIntegerResult("b_out", "2");
+
+  test->reset();
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setSignedIntegerInput("a_in", 3);
+  test->setUnsignedIntegerInput("b_in", 7);
+  test->endDataInput();
+  test->waitForAndCheckUnsignedIntegerResult("b_out", "7");
+
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+
+TEST_F(SimpleVHDLGeneratorTest, IntegerWidthSupportTest) {
+  ParseAssembly(
+    "define i1 @test(i32 %a, i64 %b) #0 {\n"
+    "entry:\n"
+    "  %add32 = add i32 %a, 1\n"
+    "  %add64 = add i64 %b, 1\n"
+    "  %shl64 = shl i64 %b, 3\n"
+    "  %div64 = udiv i64 %b, 7\n"
+    "  %cmp32 = icmp slt i32 %a, 3\n"
+    "  %cmp64 = icmp slt i64 %b, 3\n"
+    "  %and = and i1 %cmp32, %cmp64\n"
+    "  ret i1 %and\n"
+    "}\n");
+
+  // the integer cores only have 32-bit ports
+  std::set<std::string> supported, unsupported;
+  for (inst_iterator it = inst_begin(F); it != inst_end(F); ++it)
+    (VHDLBackend::isSupported(&*it) ? supported : unsupported).insert(it->getName().str());
+
+  EXPECT_TRUE(supported.count("add32"));
+  EXPECT_TRUE(supported.count("cmp32"));
+  EXPECT_TRUE(supported.count("and"));
+  EXPECT_TRUE(unsupported.count("add64"));
+  EXPECT_TRUE(unsupported.count("shl64"));
+  EXPECT_TRUE(unsupported.count("div64"));
+  EXPECT_TRUE(unsupported.count("cmp64"));
+}
+
+
+TEST_F(SimpleVHDLGeneratorTest, UnsignedComparisonTest) {
+  ParseC(
+    "void test(unsigned int a, int b) {"
+    "  if (a >= 3)"
+    "    b = 2;"
+    "}");
+  CheckResultFromFile();
+
+
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+
+  // -4 is a big unsigned number
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setSignedIntegerInput("a_in", -4);
+  test->setUnsignedIntegerInput("b_in", 7);
+  test->endDataInput();
+  test->waitForAndCheckUnsignedIntegerResult("b_out", "2");
+
+  test->reset();
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setUnsignedIntegerInput("a_in", 2);
+  test->setUnsignedIntegerInput("b_in", 7);
+  test->endDataInput();
+  test->waitForAndCheckUnsignedIntegerResult("b_out", "7");
+
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+
+TEST_F(SimpleVHDLGeneratorTest, IntegerDivisionTest) {
+  ParseC(
+    "void test(int a, int b, int c) {"
+    "  b = a / -3;"
+    "  c = a % -3;"
+    "}");
+  GenerateCode();
+
+  // the divider is a pipeline of 34 cycles, so the inputs stay valid until the results are there
+  EXPECT_NE(std::string::npos, ((VHDLBackend*)backend)->getResourceReport().find("latency about 34 cycles"));
+
+
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setSignedIntegerInput("a_in", -7);
+  test->waitForAndCheckSignedIntegerResult("b_out", "2");
+  test->waitForAndCheckSignedIntegerResult("c_out", "-1");
+  test->endDataInput();
+
+  test->startDataInput();
+  test->setSignedIntegerInput("a_in", 7);
+  test->waitForAndCheckSignedIntegerResult("b_out", "-2");
+  test->waitForAndCheckSignedIntegerResult("c_out", "1");
+  test->endDataInput();
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+
+TEST_F(SimpleVHDLGeneratorTest, ConversionTest) {
+  ParseC(
+    "int test(double a) {"
+    "  return a;"
+    "}");
+  CheckResultFromFile();
+
+
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setFloatInput("a_in", -2.75);
+  test->endDataInput();
+  test->waitForAndCheckSignedIntegerResult("return", "-2");
+
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+
 TEST_F(SimpleVHDLGeneratorTest, SinTest) {
   ParseC(
     "double sin(double);"
@@ -480,6 +708,137 @@ TEST_F(SimpleVHDLGeneratorTest, SinTest) {
 }
 
 
+static unsigned int countOccurrences(const std::string& text, const std::string& pattern) {
+  unsigned int count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+    count++;
+  return count;
+}
+
+TEST_F(SimpleVHDLGeneratorTest, SharedOperatorTest) {
+  ParseC(
+    "double test(double a, double b, double c) {"
+    "  return a*b + b*c + a*c;"
+    "}");
+  getCodeGenerator();
+  VHDLBackend* vhdlBackend = (VHDLBackend*)backend;
+  vhdlBackend->setOperatorLimit("float_mul", 1);
+  std::string vhdl = GenerateCode();
+
+  // the multiplications share one core, the additions have a core of their own
+  EXPECT_EQ(1u, countOccurrences(vhdl, ": float_mul\n"));
+  EXPECT_EQ(2u, countOccurrences(vhdl, ": float_add\n"));
+
+  std::string report = vhdlBackend->getResourceReport();
+  EXPECT_NE(std::string::npos, report.find("latency about 46 cycles (36 without sharing)"));
+  EXPECT_NE(std::string::npos, report.find("float_mul: 3 operations on 1 core\n"));
+  EXPECT_NE(std::string::npos, report.find("float_add: 2 operations on 2 cores\n"));
+
+
+  // A shared core drops results whose inputs have become invalid, so the
+  // inputs stay valid until the result is there.
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setFloatInput("a_in", 2);
+  test->setFloatInput("b_in", 3);
+  test->setFloatInput("c_in", 4);
+  test->waitForAndCheckFloatResult("return", "26.0", 200);
+  test->endDataInput();
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+TEST_F(SimpleVHDLGeneratorTest, SharedOperatorChainTest) {
+  ParseC(
+    "double test(double a, double b, double c) {"
+    "  return a*b*c;"
+    "}");
+  getCodeGenerator();
+  VHDLBackend* vhdlBackend = (VHDLBackend*)backend;
+  vhdlBackend->setOperatorLimit("float_mul", 1);
+  std::string vhdl = GenerateCode();
+
+  EXPECT_EQ(1u, countOccurrences(vhdl, ": float_mul\n"));
+
+
+  // The second iteration starts without a reset, so the core has to start over
+  // with the first multiplication.
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setFloatInput("a_in", 2);
+  test->setFloatInput("b_in", 3);
+  test->setFloatInput("c_in", 4);
+  test->waitForAndCheckFloatResult("return", "24.0", 200);
+  test->endDataInput();
+
+  test->startDataInput();
+  test->setFloatInput("a_in", 5);
+  test->setFloatInput("b_in", 6);
+  test->setFloatInput("c_in", 7);
+  test->waitForAndCheckFloatResult("return", "210.0", 200);
+  test->endDataInput();
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+TEST_F(SimpleVHDLGeneratorTest, StaticScheduleTest) {
+  ParseC(
+    "double test(double a, double b, double c) {"
+    "  return a*b + b*c + a*c;"
+    "}");
+  getCodeGenerator();
+  VHDLBackend* vhdlBackend = (VHDLBackend*)backend;
+  vhdlBackend->setStaticSchedule(true);
+  std::string vhdl = GenerateCode();
+
+  EXPECT_TRUE(vhdlBackend->isStaticallyScheduled());
+  // only the inputs have a ready signal
+  EXPECT_EQ(3u, countOccurrences(vhdl, "_ready <= "));
+
+  // multiplications at cycle 0, the additions after 11 and 25 cycles
+  std::string report = vhdlBackend->getResourceReport();
+  EXPECT_NE(std::string::npos, report.find("static schedule: 39 cycles"));
+
+
+  TestOperator* test = makeTestOperator();
+
+  test->beginStimulusProcess();
+  test->waitUntilReady();
+  test->startDataInput();
+  test->setFloatInput("a_in", 2);
+  test->setFloatInput("b_in", 3);
+  test->setFloatInput("c_in", 4);
+  test->endDataInput();
+  test->waitForAndCheckFloatResult("return", "26.0", 200);
+  test->endStimulusProcess();
+
+  saveTestOperator();
+}
+
+TEST_F(SimpleVHDLGeneratorTest, StaticScheduleWithCallTest) {
+  ParseC(
+    "double sin(double x);"
+    "double test(double a) {"
+    "  return sin(a) + 1;"
+    "}");
+  getCodeGenerator();
+  VHDLBackend* vhdlBackend = (VHDLBackend*)backend;
+  vhdlBackend->setStaticSchedule(true);
+  GenerateCode();
+
+  // sin doesn't have a fixed latency, so we need the handshakes
+  EXPECT_FALSE(vhdlBackend->isStaticallyScheduled());
+}
+
+
 class ReconOSVHDLGeneratorTest : public SimpleVHDLGeneratorTest {
 
 };
@@ -512,6 +871,54 @@ TEST_F(ReconOSVHDLGeneratorTest, ReturnValueTest) {
 }
 
 
+TEST_F(ReconOSVHDLGeneratorTest, EmulationReturnValueTest) {
+  ParseC(
+    "double test(double a) {"
+    "  return a+2;"
+    "}");
+  GenerateCode();
+  std::string emulation = ((VHDLBackend*)backend)->getEmulationCode("hwt_0_calculation(a)");
+
+  // The emulated hardware thread has to send the return value before the ack. We run
+  // it for two iterations like the interface code of the CPU would do it.
+  std::ostringstream program;
+  program
+    << "#include \"mbox.h\"\n"
+    << "#include \"reconos_emu.h\"\n"
+    << "#include <pthread.h>\n\n"
+    << "static struct mbox start, stop;\n\n"
+    << "static double hwt_0_calculation(double a)\n{\n\treturn a+2;\n}\n\n"
+    << "static void* hwt_0_emulation(void* arg)\n{\n"
+    << "\tstruct mbox* mbox_start = &start;\n"
+    << "\tstruct mbox* mbox_stop = &stop;\n"
+    << "\tdouble a = 0;\n"
+    << emulation
+    << "\treturn NULL;\n}\n\n"
+    << "int main(void)\n{\n"
+    << "\tpthread_t hwt;\n"
+    << "\tint i;\n"
+    << "\tmbox_init(&start, 8);\n"
+    << "\tmbox_init(&stop, 8);\n"
+    << "\tpthread_create(&hwt, NULL, hwt_0_emulation, NULL);\n"
+    << "\tfor (i = 1; i <= 2; i++) {\n"
+    << "\t\tmbox_put(&start, i);\n"
+    << "\t\treconos_emu_mbox_put_real(&start, 40.0 + i);\n"
+    << "\t\tif (reconos_emu_mbox_get_real(&stop) != 42.0 + i)\n"
+    << "\t\t\treturn 1;\n"
+    << "\t\tif (mbox_get(&stop) != (uint32_t)i)\n"
+    << "\t\t\treturn 2;\n"
+    << "\t}\n"
+    << "\tmbox_put(&start, 0xffffffffu);\n"
+    << "\tpthread_join(hwt, NULL);\n"
+    << "\treturn 0;\n}\n";
+  writeFile("emulation-test.c", program.str());
+
+  int result = system("./clang -I reconos_emu -o emulation-test emulation-test.c reconos_emu/reconos_emu.c -lpthread");
+  ASSERT_EQ(0, result);
+  EXPECT_EQ(0, system("./emulation-test"));
+}
+
+
 TEST_F(ReconOSVHDLGeneratorTest, GlobalArrayTest) {
   ParseC(
     "double x[7];"
@@ -535,6 +942,72 @@ TEST_F(ReconOSVHDLGeneratorTest, GlobalArrayTest) {
 }
 
 
+TEST_F(ReconOSVHDLGeneratorTest, SplitPhaseInterfaceTest) {
+  ParseC(
+    "double x[7];"
+    "void test(double a, double b) {"
+    "  x[2] = a;"
+    "  x[3] = b;"
+    "}");
+  GenerateCode();
+
+  // the start code only sends inputs, the collect code begins with the first result
+  EXPECT_EQ(
+    "mbox_put_real(&mbox_start, a);\n",
+    ((VHDLBackend*)backend)->getStartCode());
+  EXPECT_EQ(
+    "x[2] = mbox_get_real(&mbox_stop);\n"
+    "mbox_put_real(&mbox_start, b);\n"
+    "x[3] = mbox_get_real(&mbox_stop);\n",
+    ((VHDLBackend*)backend)->getCollectCode());
+  EXPECT_EQ(
+    ((VHDLBackend*)backend)->getStartCode() + ((VHDLBackend*)backend)->getCollectCode(),
+    getInterfaceCode());
+}
+
+
+TEST_F(ReconOSVHDLGeneratorTest, CachedInputsTest) {
+  ParseC(
+    "double Vp[10];"
+    "double x[7];"
+    "void test(double a) {"
+    "  x[2] = a*Vp[1];"
+    "}");
+  std::set<std::string> inputs;
+  inputs.insert("Vp[1]");
+  getCodeGenerator();
+  ((VHDLBackend*)backend)->setInvariantInputs(inputs);
+  GenerateCode();
+
+  // the version of the cached inputs is the start word
+  EXPECT_TRUE(((VHDLBackend*)backend)->hasCachedInputs());
+  EXPECT_EQ(
+    "{\n"
+    "\tstatic unsigned int cached_inputs_version = 0;\n"
+    "\tstatic double cached_input_0;\n"
+    "\tif (cached_inputs_version == 0\n"
+    "\t\t\t|| memcmp(&cached_input_0, &Vp[1], sizeof(cached_input_0)) != 0) {\n"
+    "\t\t// the hardware starts with version 0 and 0xffffffff stops the thread\n"
+    "\t\tcached_inputs_version = cached_inputs_version % 0xfffffffeu + 1;\n"
+    "\t\tcached_input_0 = Vp[1];\n"
+    "\t\tmbox_put(&mbox_start, cached_inputs_version);\n"
+    "\t\tmbox_put_real(&mbox_start, cached_input_0);\n"
+    "\t} else\n"
+    "\t\tmbox_put(&mbox_start, cached_inputs_version);\n"
+    "}\n"
+    "mbox_put_real(&mbox_start, a);\n"
+    "x[2] = mbox_get_real(&mbox_stop);\n",
+    getInterfaceCode());
+
+  // INIT skips the state that reads the cached input
+  std::ostringstream reconos;
+  getGeneratedReconOSOperator()->outputVHDL(reconos, "reconos");
+  EXPECT_NE(std::string::npos, reconos.str().find("elsif (addr = cached_inputs_version) then"));
+  EXPECT_NE(std::string::npos, reconos.str().find("cached_inputs_version <= addr;"));
+  EXPECT_NE(std::string::npos, reconos.str().find("STATE_MBOX_READ_CACHED_"));
+}
+
+
 TEST_F(ReconOSVHDLGeneratorTest, DoubleCommunicationTest) {
   ParseC(
     "void _put_real(unsigned int, double);"
@@ -0,0 +1,145 @@
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Assembly/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Attributes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "gtest/gtest.h"
+
+#include "mehari/Transforms/AddAlwaysInlineAttributePass.h"
+
+#include <vector>
+#include <string>
+
+
+using namespace llvm;
+
+namespace {
+
+class AddAlwaysInlineAttributePassTest : public testing::Test {
+
+protected:
+
+  void ParseAssembly(const char *Assembly) {
+    M.reset(new Module("Module", getGlobalContext()));
+
+    SMDiagnostic Error;
+    bool Parsed = ParseAssemblyString(Assembly, M.get(), Error, M->getContext()) == M.get();
+
+    std::string errMsg;
+    raw_string_ostream os(errMsg);
+    Error.print("", os);
+
+    if (!Parsed) {
+      // A failure here means that the test itself is buggy.
+      report_fatal_error(os.str().c_str());
+    }
+
+    F = M->getFunction("test");
+    if (F == NULL)
+      report_fatal_error("Test must have a function named @test");
+  }
+
+  void runPass(unsigned int sizeBudget) {
+    AddAlwaysInlineAttributePass pass;
+    pass.setRootFunctions(std::vector<std::string>(1, "test"));
+    pass.setSizeBudget(sizeBudget);
+    pass.runOnModule(*M);
+  }
+
+  bool isInlined(const std::string &name) {
+    return M->getFunction(name)->hasFnAttribute(Attribute::AlwaysInline);
+  }
+
+  OwningPtr<Module> M;
+  Function *F;
+};
+
+
+static const char *callees =
+  // one operation, called 5 times
+  "define double @helper(double %x) {\n"
+  "entry:\n"
+  "  %y = fadd double %x, 1.000000e+00\n"
+  "  ret double %y\n"
+  "}\n"
+  "define double @wrapper(double %x) {\n"
+  "entry:\n"
+  "  %y = call double @helper(double %x)\n"
+  "  ret double %y\n"
+  "}\n"
+  // a chain of operations, parallelism 1
+  "define double @serial(double %a) {\n"
+  "entry:\n"
+  "  %x1 = fmul double %a, %a\n"
+  "  %x2 = fmul double %x1, %a\n"
+  "  %x3 = fmul double %x2, %a\n"
+  "  %x4 = fadd double %x3, %a\n"
+  "  ret double %x4\n"
+  "}\n"
+  // four independent multiplications
+  "define double @parallel(double %a, double %b, double %c, double %d) {\n"
+  "entry:\n"
+  "  %ab = fmul double %a, %b\n"
+  "  %cd = fmul double %c, %d\n"
+  "  %ac = fmul double %a, %c\n"
+  "  %bd = fmul double %b, %d\n"
+  "  %s1 = fadd double %ab, %cd\n"
+  "  %s2 = fadd double %ac, %bd\n"
+  "  %r = fadd double %s1, %s2\n"
+  "  ret double %r\n"
+  "}\n"
+  "define i32 @index(i32 %i) {\n"
+  "entry:\n"
+  "  %j = add i32 %i, 1\n"
+  "  ret i32 %j\n"
+  "}\n"
+  "define double @test(double %a, double %b, i32 %i) {\n"
+  "entry:\n"
+  "  %s = call double @serial(double %a)\n"
+  "  %p = call double @parallel(double %a, double %b, double %s, double %a)\n"
+  "  %h1 = call double @helper(double %a)\n"
+  "  %h2 = call double @helper(double %b)\n"
+  "  %h3 = call double @helper(double %h1)\n"
+  "  %h4 = call double @helper(double %h2)\n"
+  "  %w = call double @wrapper(double %p)\n"
+  "  %j = call i32 @index(i32 %i)\n"
+  "  %r1 = fadd double %h3, %h4\n"
+  "  %r2 = fadd double %r1, %w\n"
+  "  ret double %r2\n"
+  "}\n";
+
+TEST_F(AddAlwaysInlineAttributePassTest, SelectByParallelismTest) {
+  ParseAssembly(callees);
+
+  // parallel adds 6 instructions (8 without the call and the return) and serial adds 3,
+  // so only one of them fits. The one with the independent operations is selected,
+  // although the other one is called first.
+  runPass(8);
+  EXPECT_TRUE(isInlined("parallel"));
+  EXPECT_FALSE(isInlined("serial"));
+
+  // The body of the helper replaces the call and the return, so it doesn't add anything
+  // at its 5 call sites. The wrapper exposes the helper.
+  EXPECT_TRUE(isInlined("helper"));
+  EXPECT_TRUE(isInlined("wrapper"));
+
+  // nothing for the FPGA
+  EXPECT_FALSE(isInlined("index"));
+}
+
+TEST_F(AddAlwaysInlineAttributePassTest, LargeBudgetTest) {
+  ParseAssembly(callees);
+
+  runPass(100);
+  EXPECT_TRUE(isInlined("parallel"));
+  EXPECT_TRUE(isInlined("serial"));
+  EXPECT_TRUE(isInlined("helper"));
+  EXPECT_TRUE(isInlined("wrapper"));
+  EXPECT_FALSE(isInlined("index"));
+}
+
+}
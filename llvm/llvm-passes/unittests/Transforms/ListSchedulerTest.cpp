@@ -0,0 +1,177 @@
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Assembly/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "gtest/gtest.h"
+
+#include "mehari/Transforms/ListScheduler.h"
+#include "mehari/Transforms/PartitioningGraph.h"
+#include "mehari/Analysis/InstructionDependencyAnalysis.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+
+using namespace llvm;
+
+namespace {
+
+class ListSchedulerTest : public testing::Test {
+
+protected:
+
+  void ParseAssembly(const char *Assembly) {
+    M.reset(new Module("Module", getGlobalContext()));
+
+    SMDiagnostic Error;
+    bool Parsed = ParseAssemblyString(Assembly, M.get(), Error, M->getContext()) == M.get();
+
+    std::string errMsg;
+    raw_string_ostream os(errMsg);
+    Error.print("", os);
+
+    if (!Parsed) {
+      // A failure here means that the test itself is buggy.
+      report_fatal_error(os.str().c_str());
+    }
+
+    F = M->getFunction("test");
+    if (F == NULL)
+      report_fatal_error("Test must have a function named @test");
+  }
+
+  // creates the graph of the function with the register dependencies between its instructions
+  void createGraph(PartitioningGraph &pGraph) {
+    std::vector<Instruction*> instructions;
+    for (inst_iterator it = inst_begin(F); it != inst_end(F); ++it)
+      instructions.push_back(&*it);
+    InstructionDependencyList dependencies(instructions.size());
+    for (unsigned int i=0; i<instructions.size(); i++) {
+      dependencies[i].tgtInstruction = instructions[i];
+      for (User::op_iterator opIt = instructions[i]->op_begin(); opIt != instructions[i]->op_end(); ++opIt) {
+        if (Instruction *op = dyn_cast<Instruction>(*opIt)) {
+          InstructionDependency dependency;
+          dependency.depInstruction = op;
+          dependency.isRegdep = true;
+          dependencies[i].dependencies.push_back(dependency);
+        }
+      }
+    }
+    pGraph.create(instructions, dependencies);
+  }
+
+  bool hasConstraint(PartitioningGraph::VertexPairList &constraints,
+      PartitioningGraph::VertexDescriptor first, PartitioningGraph::VertexDescriptor second) {
+    return std::find(constraints.begin(), constraints.end(), std::make_pair(first, second)) != constraints.end();
+  }
+
+  OwningPtr<Module> M;
+  Function *F;
+};
+
+
+// every instruction is a vertex of its own: x (0), y (1), z (2), r (3), ret (4)
+static const char *twoChains =
+  "define double @test(double %a, double %b) {\n"
+  "entry:\n"
+  "  %x = fmul double %a, %a\n"
+  "  %y = fadd double %b, %b\n"
+  "  %z = fmul double %x, %x\n"
+  "  %r = fadd double %z, %y\n"
+  "  ret double %r\n"
+  "}\n";
+
+TEST_F(ListSchedulerTest, UpwardRankTest) {
+  ParseAssembly(twoChains);
+  PartitioningGraph pGraph;
+  createGraph(pGraph);
+  ASSERT_EQ(5u, pGraph.getVertexCount());
+
+  std::vector<std::string> devices(1, "Cortex-A9");
+  ListScheduler scheduler;
+  ListScheduler::Schedule schedule = scheduler.schedule(pGraph, devices);
+
+  // x and z are on the longer path, so they are executed before y
+  ASSERT_EQ(1u, schedule.partitionOrders.size());
+  EXPECT_TRUE(schedule.isSequential[0]);
+  const unsigned int expectedOrder[] = { 0, 2, 1, 3, 4 };
+  EXPECT_TRUE(schedule.partitionOrders[0] == std::vector<ListScheduler::VertexDescriptor>(expectedOrder, expectedOrder + 5));
+
+  // the processor executes the vertices without gaps
+  unsigned int length = 0;
+  for (unsigned int i=0; i<5; i++) {
+    EXPECT_EQ(length, schedule.startTimes[expectedOrder[i]]);
+    length += pGraph.getExecutionTime(expectedOrder[i], devices[0]);
+  }
+  EXPECT_EQ(length, schedule.length);
+}
+
+TEST_F(ListSchedulerTest, FPGAPartitionTest) {
+  ParseAssembly(twoChains);
+  PartitioningGraph pGraph;
+  createGraph(pGraph);
+  ASSERT_EQ(5u, pGraph.getVertexCount());
+
+  // x and y are calculated by the FPGA, the rest by the processor
+  pGraph.setPartition(0, 1);
+  pGraph.setPartition(1, 1);
+  std::vector<std::string> devices;
+  devices.push_back("Cortex-A9");
+  devices.push_back("xc7z020-1");
+  ListScheduler scheduler;
+  ListScheduler::Schedule schedule = scheduler.schedule(pGraph, devices);
+
+  // the FPGA starts both independent vertices at once
+  ASSERT_EQ(2u, schedule.partitionOrders.size());
+  EXPECT_TRUE(schedule.isSequential[0]);
+  EXPECT_FALSE(schedule.isSequential[1]);
+  EXPECT_EQ(2u, schedule.partitionOrders[1].size());
+  EXPECT_EQ(0u, schedule.startTimes[0]);
+  EXPECT_EQ(0u, schedule.startTimes[1]);
+
+  // z waits for x and its transfer to the processor
+  unsigned int xArrival = pGraph.getExecutionTime(0, devices[1])
+    + pGraph.getCommunicationCost(0, 2, devices[1], devices[0]);
+  EXPECT_EQ(xArrival, schedule.startTimes[2]);
+  EXPECT_GE(schedule.startTimes[3], schedule.startTimes[2] + pGraph.getExecutionTime(2, devices[0]));
+  EXPECT_EQ(schedule.startTimes[4] + pGraph.getExecutionTime(4, devices[0]), schedule.length);
+}
+
+TEST_F(ListSchedulerTest, OrderingConstraintsTest) {
+  // vertices: store to g (0), store to h (1), load from g and fmul (2), ret (3)
+  ParseAssembly(
+    "@g = global double 0.000000e+00\n"
+    "@h = global double 0.000000e+00\n"
+    "define void @test(double %a) {\n"
+    "entry:\n"
+    "  store double %a, double* @g\n"
+    "  store double %a, double* @h\n"
+    "  %v = load double* @g\n"
+    "  %m = fmul double %v, %v\n"
+    "  ret void\n"
+    "}\n");
+  PartitioningGraph pGraph;
+  createGraph(pGraph);
+  ASSERT_EQ(4u, pGraph.getVertexCount());
+
+  PartitioningGraph::VertexPairList constraints;
+  ListScheduler::calcOrderingConstraints(pGraph, constraints);
+
+  // the load has to stay behind the store to the same variable
+  EXPECT_TRUE(hasConstraint(constraints, 0, 2));
+  EXPECT_FALSE(hasConstraint(constraints, 0, 1));
+  EXPECT_FALSE(hasConstraint(constraints, 1, 2));
+  // the return statement is the last statement of the partition
+  for (unsigned int i=0; i<3; i++)
+    EXPECT_TRUE(hasConstraint(constraints, i, 3));
+  EXPECT_EQ(4u, constraints.size());
+}
+
+}
@@ -0,0 +1,144 @@
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Assembly/Parser.h"
+#include "llvm/Analysis/Verifier.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "gtest/gtest.h"
+
+#include "mehari/Transforms/ParameterHoisting.h"
+
+#include <vector>
+#include <string>
+
+
+using namespace llvm;
+
+namespace {
+
+class ParameterHoistingTest : public testing::Test {
+
+protected:
+
+  void ParseAssembly(const char *Assembly) {
+    M.reset(new Module("Module", getGlobalContext()));
+
+    SMDiagnostic Error;
+    bool Parsed = ParseAssemblyString(Assembly, M.get(), Error, M->getContext()) == M.get();
+
+    std::string errMsg;
+    raw_string_ostream os(errMsg);
+    Error.print("", os);
+
+    if (!Parsed) {
+      // A failure here means that the test itself is buggy.
+      report_fatal_error(os.str().c_str());
+    }
+
+    F = M->getFunction("test");
+    if (F == NULL)
+      report_fatal_error("Test must have a function named @test");
+  }
+
+  bool runPass() {
+    ParameterHoisting pass;
+    pass.setTargetFunctions(std::vector<std::string>(1, "test"));
+    return pass.runOnModule(*M);
+  }
+
+  Instruction *getInstruction(Function *func, const std::string &name) {
+    for (inst_iterator it = inst_begin(func); it != inst_end(func); ++it)
+      if (it->getName() == name)
+        return &*it;
+    return NULL;
+  }
+
+  unsigned int countStores(Function *func) {
+    unsigned int stores = 0;
+    for (inst_iterator it = inst_begin(func); it != inst_end(func); ++it)
+      stores += isa<StoreInst>(&*it);
+    return stores;
+  }
+
+  OwningPtr<Module> M;
+  Function *F;
+};
+
+
+TEST_F(ParameterHoistingTest, HoistParameterComputationsTest) {
+  // Vp[0] and Vp[1] are parameters, Vp[3] is written by the function itself
+  ParseAssembly(
+    "@Vp = global [4 x double] zeroinitializer\n"
+    "declare double @sin(double)\n"
+    "define double @test(double %a) {\n"
+    "entry:\n"
+    "  %m = load double* getelementptr inbounds ([4 x double]* @Vp, i32 0, i32 0)\n"
+    "  %l = load double* getelementptr inbounds ([4 x double]* @Vp, i32 0, i32 1)\n"
+    "  %ml = fmul double %m, %l\n"
+    "  %mll = fmul double %ml, %l\n"
+    "  %s = call double @sin(double 5.000000e-01)\n"
+    "  %r = fmul double %a, %mll\n"
+    "  %r2 = fadd double %r, %s\n"
+    "  %v = load double* getelementptr inbounds ([4 x double]* @Vp, i32 0, i32 3)\n"
+    "  %v2 = fmul double %v, %m\n"
+    "  %r3 = fadd double %r2, %v2\n"
+    "  store double %r3, double* getelementptr inbounds ([4 x double]* @Vp, i32 0, i32 3)\n"
+    "  ret double %r3\n"
+    "}\n");
+
+  EXPECT_TRUE(runPass());
+  EXPECT_FALSE(verifyModule(*M, ReturnStatusAction));
+
+  // m*l*l and sin(0.5) are computed in advance, their operands are only used there
+  GlobalVariable *cache = M->getGlobalVariable("test_parameter_cache");
+  ASSERT_TRUE(cache != NULL);
+  EXPECT_EQ(2u, cast<ArrayType>(cache->getType()->getElementType())->getNumElements());
+  Function *initFunc = M->getFunction("test_on_parameter_change");
+  ASSERT_TRUE(initFunc != NULL);
+  EXPECT_EQ(2u, countStores(initFunc));
+  EXPECT_TRUE(getInstruction(initFunc, "mll") != NULL);
+
+  EXPECT_TRUE(getInstruction(F, "ml") == NULL);
+  EXPECT_TRUE(getInstruction(F, "mll") == NULL);
+  EXPECT_TRUE(getInstruction(F, "s") == NULL);
+  EXPECT_TRUE(getInstruction(F, "l") == NULL);
+  Instruction *cached = getInstruction(F, "mll.cached");
+  ASSERT_TRUE(cached != NULL);
+  EXPECT_EQ(cached, getInstruction(F, "r")->getOperand(1));
+
+  // the written element is loaded in each call, m is still needed for it
+  EXPECT_TRUE(getInstruction(F, "v") != NULL);
+  EXPECT_TRUE(getInstruction(F, "v2") != NULL);
+  EXPECT_TRUE(getInstruction(F, "m") != NULL);
+
+  // the partitioning finds the new function and its cache in the metadata
+  NamedMDNode *metadata = M->getNamedMetadata(PARAMETER_INIT_METADATA);
+  ASSERT_TRUE(metadata != NULL);
+  ASSERT_EQ(1u, metadata->getNumOperands());
+  EXPECT_EQ(initFunc, dyn_cast<Function>(metadata->getOperand(0)->getOperand(0)));
+  EXPECT_EQ(cache, dyn_cast<GlobalVariable>(metadata->getOperand(0)->getOperand(1)));
+}
+
+TEST_F(ParameterHoistingTest, NothingToHoistTest) {
+  ParseAssembly(
+    "@x = global [2 x double] zeroinitializer\n"
+    "define double @test(double %a) {\n"
+    "entry:\n"
+    "  %x = load double* getelementptr inbounds ([2 x double]* @x, i32 0, i32 0)\n"
+    "  %r = fmul double %a, %x\n"
+    "  store double %r, double* getelementptr inbounds ([2 x double]* @x, i32 0, i32 0)\n"
+    "  ret double %r\n"
+    "}\n");
+
+  EXPECT_FALSE(runPass());
+  EXPECT_TRUE(M->getFunction("test_on_parameter_change") == NULL);
+}
+
+}
@@ -0,0 +1,533 @@
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Assembly/Parser.h"
+#include "llvm/Analysis/Verifier.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/PassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "gtest/gtest.h"
+
+#include "mehari/Transforms/Partitioning.h"
+#include "mehari/Transforms/PartitioningGraph.h"
+#include "mehari/CodeGen/SimpleCCodeGenerator.h"
+#include "mehari/CodeGen/GenerateVHDL.h"
+
+#include <vector>
+#include <string>
+#include <sstream>
+
+
+using namespace llvm;
+
+namespace {
+
+class PartitioningTest : public testing::Test {
+
+protected:
+
+  void ParseAssembly(const char *Assembly) {
+    M.reset(new Module("Module", getGlobalContext()));
+
+    SMDiagnostic Error;
+    bool Parsed = ParseAssemblyString(Assembly, M.get(), Error, M->getContext()) == M.get();
+
+    std::string errMsg;
+    raw_string_ostream os(errMsg);
+    Error.print("", os);
+
+    if (!Parsed) {
+      // A failure here means that the test itself is buggy.
+      report_fatal_error(os.str().c_str());
+    }
+
+    F = M->getFunction("test");
+    if (F == NULL)
+      report_fatal_error("Test must have a function named @test");
+  }
+
+  Instruction *getInstruction(Function *func, const std::string &name) {
+    for (inst_iterator it = inst_begin(func); it != inst_end(func); ++it)
+      if (it->getName() == name)
+        return &*it;
+    return NULL;
+  }
+
+  // mark the get call as the receiver of the value like the partitioning pass does
+  void setReceivedValue(Instruction *getCall, Instruction *value) {
+    std::stringstream ss;
+    ss << value;
+    LLVMContext &context = getCall->getContext();
+    getCall->setMetadata("targetop", MDNode::get(context, MDString::get(context, ss.str())));
+  }
+
+  // assigns the instructions of the function in order to the partitions
+  void splitInstructions(const unsigned int *partitions, std::vector<Instruction*> *instructionsForPartition) {
+    unsigned int i = 0;
+    for (inst_iterator it = inst_begin(F); it != inst_end(F); ++it, ++i)
+      instructionsForPartition[partitions[i]].push_back(&*it);
+  }
+
+  // calculates the block frequencies with the loop and branch analyses of LLVM
+  void calcBlockFrequencies(std::map<BranchInst*, float> &profiledBranches, std::map<BasicBlock*, float> &frequencies) {
+
+    static char ID;
+
+    class BlockFrequencyPass : public FunctionPass {
+     public:
+      BlockFrequencyPass(std::map<BranchInst*, float> &profiledBranches, std::map<BasicBlock*, float> &frequencies)
+          : FunctionPass(ID), profiledBranches(profiledBranches), frequencies(frequencies) {}
+
+      static int initialize() {
+        PassInfo *PI = new PassInfo("BlockFrequency testing pass",
+                                    "", &ID, 0, true, true);
+        PassRegistry::getPassRegistry()->registerPass(*PI, false);
+        initializeLoopInfoPass(*PassRegistry::getPassRegistry());
+        initializeBranchProbabilityInfoPass(*PassRegistry::getPassRegistry());
+        return 0;
+      }
+
+      void getAnalysisUsage(AnalysisUsage &AU) const {
+        AU.setPreservesAll();
+        AU.addRequired<LoopInfo>();
+        AU.addRequired<BranchProbabilityInfo>();
+      }
+
+      bool runOnFunction(Function &F) {
+        if (F.getName() == "test")
+          Partitioning::calcBlockFrequencies(F, &getAnalysis<LoopInfo>(), &getAnalysis<BranchProbabilityInfo>(),
+            profiledBranches, frequencies);
+        return false;
+      }
+
+      std::map<BranchInst*, float> &profiledBranches;
+      std::map<BasicBlock*, float> &frequencies;
+    };
+
+    static int initialize = BlockFrequencyPass::initialize();
+    (void)initialize;
+
+    PassManager PM;
+    PM.add(new BlockFrequencyPass(profiledBranches, frequencies));
+    PM.run(*M);
+  }
+
+  OwningPtr<Module> M;
+  Function *F;
+};
+
+
+TEST_F(PartitioningTest, ClonePartitionTest) {
+  ParseAssembly(
+    "@x = global double 0.000000e+00\n"
+    "declare double @_get_real(i32)\n"
+    "define double @test(double %a) {\n"
+    "entry:\n"
+    "  %add = fadd double %a, 1.000000e+00\n"
+    "  %get = call double @_get_real(i32 0)\n"
+    "  %mul = fmul double %add, 2.000000e+00\n"
+    "  store double %mul, double* @x\n"
+    "  ret double %mul\n"
+    "}\n");
+
+  // the partition receives %add from another partition
+  Instruction *getCall = getInstruction(F, "get");
+  setReceivedValue(getCall, getInstruction(F, "add"));
+  std::vector<Instruction*> instructions;
+  instructions.push_back(getCall);
+  instructions.push_back(getInstruction(F, "mul"));
+  BasicBlock::iterator store = getInstruction(F, "mul");
+  instructions.push_back(++store);
+  instructions.push_back(F->getEntryBlock().getTerminator());
+
+  OwningPtr<Module> partModule(new Module("partitions", getGlobalContext()));
+  Function *partFunc = Partitioning::clonePartition(partModule.get(), *F, "test_llvm", instructions);
+
+  ASSERT_TRUE(partFunc != NULL);
+  EXPECT_FALSE(verifyModule(*partModule, ReturnStatusAction));
+
+  // the instruction of the other partition is gone and its user gets the received value
+  EXPECT_TRUE(getInstruction(partFunc, "add") == NULL);
+  Instruction *clonedGet = getInstruction(partFunc, "get");
+  Instruction *clonedMul = getInstruction(partFunc, "mul");
+  ASSERT_TRUE(clonedGet != NULL);
+  ASSERT_TRUE(clonedMul != NULL);
+  EXPECT_EQ(clonedGet, clonedMul->getOperand(0));
+  EXPECT_TRUE(clonedGet->getMetadata("targetop") == NULL);
+
+  // the original function is unchanged
+  EXPECT_EQ(getInstruction(F, "add"), getInstruction(F, "mul")->getOperand(0));
+}
+
+TEST_F(PartitioningTest, MessageSplitTest) {
+  LLVMContext &context = getGlobalContext();
+  Type *doubleType = Type::getDoubleTy(context);
+  Type *intType = Type::getInt32Ty(context);
+
+  // 20 doubles are 40 words, so they don't fit into a channel of 16 words
+  std::vector<unsigned int> parts = Partitioning::splitMessage(std::vector<Type*>(20, doubleType), 16);
+  ASSERT_EQ(3u, parts.size());
+  EXPECT_EQ(8u, parts[0]);
+  EXPECT_EQ(8u, parts[1]);
+  EXPECT_EQ(4u, parts[2]);
+
+  parts = Partitioning::splitMessage(std::vector<Type*>(17, intType), 16);
+  ASSERT_EQ(2u, parts.size());
+  EXPECT_EQ(16u, parts[0]);
+  EXPECT_EQ(1u, parts[1]);
+
+  std::vector<Type*> mixed;
+  mixed.push_back(intType);
+  mixed.push_back(doubleType);
+  mixed.push_back(intType);
+  parts = Partitioning::splitMessage(mixed, 3);
+  ASSERT_EQ(2u, parts.size());
+  EXPECT_EQ(2u, parts[0]);
+  EXPECT_EQ(1u, parts[1]);
+
+  // a value that is larger than the channel is sent on its own
+  parts = Partitioning::splitMessage(std::vector<Type*>(2, doubleType), 1);
+  ASSERT_EQ(2u, parts.size());
+  EXPECT_EQ(1u, parts[0]);
+  EXPECT_EQ(1u, parts[1]);
+}
+
+TEST_F(PartitioningTest, StaticScheduleWithCommunicationTest) {
+  // the CPU (partition 0) sends a*b to the FPGA (partition 1), which returns the sum
+  ParseAssembly(
+    "declare double @_get_real(i32)\n"
+    "declare void @_put_real(i32, double)\n"
+    "define double @test(double %a, double %b) {\n"
+    "entry:\n"
+    "  %mul = fmul double %a, %b\n"
+    "  call void @_put_real(i32 0, double %mul)\n"
+    "  %get = call double @_get_real(i32 0)\n"
+    "  %add = fadd double %get, %a\n"
+    "  call void @_put_real(i32 1, double %add)\n"
+    "  %result = call double @_get_real(i32 1)\n"
+    "  ret double %result\n"
+    "}\n");
+  setReceivedValue(getInstruction(F, "get"), getInstruction(F, "mul"));
+  setReceivedValue(getInstruction(F, "result"), getInstruction(F, "add"));
+  const unsigned int partitions[] = { 0, 0, 1, 1, 1, 0, 0 };
+  std::vector<Instruction*> instructionsForPartition[2];
+  splitInstructions(partitions, instructionsForPartition);
+
+  // the value of the CPU doesn't depend on the result of the FPGA
+  EXPECT_FALSE(Partitioning::hasRoundTrip(instructionsForPartition, 2, 1));
+
+  VHDLBackend *backend = (new VHDLBackend("calculation"))->setTestMode();
+  backend->setDataDependencyCount(2);
+  backend->setStaticSchedule(true);
+  SimpleCCodeGenerator codeGen(backend);
+  codeGen.createCCode(*F, instructionsForPartition[1]);
+  EXPECT_TRUE(backend->isStaticallyScheduled());
+}
+
+TEST_F(PartitioningTest, RoundTripTest) {
+  // the FPGA (partition 1) needs a value, which the CPU calculates from its first result
+  ParseAssembly(
+    "declare double @_get_real(i32)\n"
+    "declare void @_put_real(i32, double)\n"
+    "define double @test(double %a) {\n"
+    "entry:\n"
+    "  %add = fadd double %a, 1.000000e+00\n"
+    "  call void @_put_real(i32 0, double %add)\n"
+    "  %get = call double @_get_real(i32 0)\n"
+    "  %mul = fmul double %get, %a\n"
+    "  call void @_put_real(i32 1, double %mul)\n"
+    "  ret double %mul\n"
+    "}\n");
+  const unsigned int partitions[] = { 1, 1, 0, 0, 0, 0 };
+  std::vector<Instruction*> instructionsForPartition[2];
+  splitInstructions(partitions, instructionsForPartition);
+  EXPECT_FALSE(Partitioning::hasRoundTrip(instructionsForPartition, 2, 1));
+
+  // now the FPGA gets the product back
+  ParseAssembly(
+    "declare double @_get_real(i32)\n"
+    "declare void @_put_real(i32, double)\n"
+    "define double @test(double %a) {\n"
+    "entry:\n"
+    "  %add = fadd double %a, 1.000000e+00\n"
+    "  call void @_put_real(i32 0, double %add)\n"
+    "  %get = call double @_get_real(i32 0)\n"
+    "  %mul = fmul double %get, %a\n"
+    "  call void @_put_real(i32 1, double %mul)\n"
+    "  %back = call double @_get_real(i32 1)\n"
+    "  %sub = fsub double %back, %add\n"
+    "  ret double %sub\n"
+    "}\n");
+  const unsigned int roundTripPartitions[] = { 1, 1, 0, 0, 0, 1, 1, 1 };
+  std::vector<Instruction*> roundTripInstructions[2];
+  splitInstructions(roundTripPartitions, roundTripInstructions);
+  EXPECT_TRUE(Partitioning::hasRoundTrip(roundTripInstructions, 2, 1));
+  // the CPU only receives the first result
+  EXPECT_FALSE(Partitioning::hasRoundTrip(roundTripInstructions, 2, 0));
+}
+
+TEST_F(PartitioningTest, RedundantSemaphoreTest) {
+  ParseAssembly(
+    "declare void @_sem_post(i32)\n"
+    "declare void @_sem_wait(i32)\n"
+    "declare double @_get_real(i32)\n"
+    "declare void @_put_real(i32, double)\n"
+    "define double @test(double %a) {\n"
+    "entry:\n"
+    "  %add = fadd double %a, 1.000000e+00\n"
+    "  call void @_sem_post(i32 0)\n"
+    "  call void @_put_real(i32 0, double %add)\n"
+    "  call void @_sem_post(i32 1)\n"
+    "  %get = call double @_get_real(i32 0)\n"
+    "  call void @_sem_wait(i32 0)\n"
+    "  call void @_sem_wait(i32 1)\n"
+    "  %mul = fmul double %get, %a\n"
+    "  ret double %mul\n"
+    "}\n");
+  const unsigned int partitions[] = { 0, 0, 0, 0, 1, 1, 1, 1, 1 };
+  std::vector<Instruction*> instructionsForPartition[2];
+  splitInstructions(partitions, instructionsForPartition);
+  std::vector<std::vector<Instruction*> > executionOrders(instructionsForPartition, instructionsForPartition + 2);
+
+  PostDominatorTree PDT;
+  PDT.runOnFunction(*F);
+
+  // The put of partition 0 follows the first post and the get of partition 1 comes before its
+  // wait, so the data dependency already orders them. Nothing orders the second post before its wait.
+  std::set<unsigned int> redundant = Partitioning::findRedundantSemaphores(*F, PDT, executionOrders,
+    std::vector<bool>(2, true));
+  ASSERT_EQ(1u, redundant.size());
+  EXPECT_EQ(0u, *redundant.begin());
+
+  // the FPGA doesn't execute the calls in this order
+  std::vector<bool> isSequential(2, true);
+  isSequential[1] = false;
+  EXPECT_TRUE(Partitioning::findRedundantSemaphores(*F, PDT, executionOrders, isSequential).empty());
+}
+
+TEST_F(PartitioningTest, ConditionalSemaphoreTest) {
+  // the put is not executed in every run, so it cannot replace the semaphore
+  ParseAssembly(
+    "declare void @_sem_post(i32)\n"
+    "declare void @_sem_wait(i32)\n"
+    "declare double @_get_real(i32)\n"
+    "declare void @_put_real(i32, double)\n"
+    "define double @test(double %a, i1 %c) {\n"
+    "entry:\n"
+    "  call void @_sem_post(i32 0)\n"
+    "  br i1 %c, label %then, label %end\n"
+    "then:\n"
+    "  call void @_put_real(i32 0, double %a)\n"
+    "  %get = call double @_get_real(i32 0)\n"
+    "  br label %end\n"
+    "end:\n"
+    "  call void @_sem_wait(i32 0)\n"
+    "  ret double %a\n"
+    "}\n");
+  const unsigned int partitions[] = { 0, 0, 0, 1, 1, 1, 1 };
+  std::vector<Instruction*> instructionsForPartition[2];
+  splitInstructions(partitions, instructionsForPartition);
+  std::vector<std::vector<Instruction*> > executionOrders(instructionsForPartition, instructionsForPartition + 2);
+
+  PostDominatorTree PDT;
+  PDT.runOnFunction(*F);
+
+  EXPECT_TRUE(Partitioning::findRedundantSemaphores(*F, PDT, executionOrders, std::vector<bool>(2, true)).empty());
+}
+
+TEST_F(PartitioningTest, LatencyHidingTest) {
+  // partition 1 sends x to partition 0, which sends y back
+  ParseAssembly(
+    "declare double @_get_real(i32)\n"
+    "declare void @_put_real(i32, double)\n"
+    "define double @test(double %a) {\n"
+    "entry:\n"
+    "  %x = fadd double %a, 1.000000e+00\n"
+    "  call void @_put_real(i32 0, double %x)\n"
+    "  %gx = call double @_get_real(i32 0)\n"
+    "  %y = fmul double %a, 2.000000e+00\n"
+    "  call void @_put_real(i32 1, double %y)\n"
+    "  %gy = call double @_get_real(i32 1)\n"
+    "  %z = fsub double %gy, %x\n"
+    "  %r = fadd double %x, %y\n"
+    "  ret double %r\n"
+    "}\n");
+  Instruction *getX = getInstruction(F, "gx");
+  BasicBlock::iterator putIt = getX;
+  std::advance(putIt, 2);
+  Instruction *putY = &*putIt;
+  setReceivedValue(getX, getInstruction(F, "x"));
+  setReceivedValue(getInstruction(F, "gy"), getInstruction(F, "y"));
+
+  // vertices of partition 0 in execution order
+  std::vector<std::vector<Instruction*> > vertices(3);
+  vertices[0].push_back(getX);
+  vertices[1].push_back(getInstruction(F, "y"));
+  vertices[1].push_back(putY);
+  vertices[2].push_back(getInstruction(F, "r"));
+  vertices[2].push_back(F->getEntryBlock().getTerminator());
+
+  // Partition 1 sends x before it waits for y. If a put had to wait for its receiver,
+  // receiving x after sending y would make both partitions wait for each other.
+  std::vector<Type*> doubles(1, Type::getDoubleTy(getGlobalContext()));
+  EXPECT_TRUE(Partitioning::isMovableMessage(doubles, 16));
+  EXPECT_FALSE(Partitioning::isMovableMessage(doubles, 1));
+
+  std::set<Instruction*> movableCalls;
+  if (Partitioning::isMovableMessage(doubles, 1)) {
+    movableCalls.insert(getX);
+    movableCalls.insert(putY);
+  }
+  unsigned int messageCount = 0;
+  std::vector<std::vector<Instruction*> > unmoved(vertices);
+  EXPECT_EQ(0u, Partitioning::moveCommunicationCalls(*F, unmoved, movableCalls, messageCount));
+  EXPECT_TRUE(unmoved == vertices);
+
+  // x is received in front of its first use, y is still sent right after its computation
+  movableCalls.insert(getX);
+  movableCalls.insert(putY);
+  messageCount = 0;
+  EXPECT_EQ(1u, Partitioning::moveCommunicationCalls(*F, vertices, movableCalls, messageCount));
+  EXPECT_EQ(2u, messageCount);
+  EXPECT_TRUE(vertices[0].empty());
+  ASSERT_EQ(2u, vertices[1].size());
+  EXPECT_EQ(putY, vertices[1][1]);
+  ASSERT_EQ(3u, vertices[2].size());
+  EXPECT_EQ(getX, vertices[2][0]);
+
+  // the parts of a split message fit into the channel
+  std::vector<Type*> values(20, Type::getDoubleTy(getGlobalContext()));
+  std::vector<unsigned int> parts = Partitioning::splitMessage(values, 16);
+  for (std::vector<unsigned int>::iterator it = parts.begin(); it != parts.end(); ++it)
+    EXPECT_TRUE(Partitioning::isMovableMessage(std::vector<Type*>(*it, values[0]), 16));
+}
+
+
+TEST_F(PartitioningTest, LoopExecutionCountTest) {
+  ParseAssembly(
+    "define void @test(double %a) {\n"
+    "entry:\n"
+    "  %a.addr = alloca double\n"
+    "  store double %a, double* %a.addr\n"
+    "  br label %loop\n"
+    "loop:\n"
+    "  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]\n"
+    "  %v = load double* %a.addr\n"
+    "  %mul = fmul double %v, %v\n"
+    "  store double %mul, double* %a.addr\n"
+    "  %inc = add i32 %i, 1\n"
+    "  %cmp = icmp slt i32 %inc, 4\n"
+    "  br i1 %cmp, label %loop, label %exit\n"
+    "exit:\n"
+    "  br label %end\n"
+    "end:\n"
+    "  ret void\n"
+    "}\n");
+  Instruction *mul = getInstruction(F, "mul");
+  BasicBlock *loop = mul->getParent();
+
+  // the loop continues with probability 0.75, so it has four iterations
+  std::map<BranchInst*, float> profiledBranches;
+  profiledBranches[cast<BranchInst>(loop->getTerminator())] = 0.75;
+  std::map<BasicBlock*, float> frequencies;
+  calcBlockFrequencies(profiledBranches, frequencies);
+  EXPECT_FLOAT_EQ(1.0f, frequencies[&F->getEntryBlock()]);
+  EXPECT_FLOAT_EQ(4.0f, frequencies[loop]);
+  EXPECT_FLOAT_EQ(1.0f, frequencies[&F->back()]);
+
+  // the loop is part of a single vertex, whose costs include all iterations
+  std::vector<Instruction*> instructions;
+  for (inst_iterator it = inst_begin(F); it != inst_end(F); ++it)
+    instructions.push_back(&*it);
+  InstructionDependencyList dependencies(instructions.size());
+  PartitioningGraph pGraph;
+  pGraph.create(instructions, dependencies);
+  ASSERT_EQ(1u, pGraph.getVertexCount());
+  PartitioningGraph::VertexDescriptor vd = *pGraph.getFirstIterator();
+
+  std::string device = "Cortex-A9";
+  unsigned int singleIterationTime = pGraph.getExecutionTime(vd, device);
+  pGraph.setBlockFrequencies(frequencies);
+  EXPECT_FLOAT_EQ(4.0f, pGraph.getExpectedExecutionCount(vd, mul));
+  EXPECT_FLOAT_EQ(1.0f, pGraph.getExpectedExecutionCount(vd, F->back().getTerminator()));
+  EXPECT_GT(pGraph.getExecutionTime(vd, device), singleIterationTime);
+}
+
+
+TEST_F(PartitioningTest, TransferPerPartitionTest) {
+  // vertices: x (0), store (1), u and y (2), v and z (3), w (4), r (5), ret (6)
+  ParseAssembly(
+    "@g = global double 0.000000e+00\n"
+    "define double @test(double %a) {\n"
+    "entry:\n"
+    "  %x = fmul double %a, %a\n"
+    "  store double %x, double* @g\n"
+    "  %u = load double* @g\n"
+    "  %y = fadd double %x, %u\n"
+    "  %v = load double* @g\n"
+    "  %z = fmul double %x, %v\n"
+    "  %w = fadd double %x, 3.000000e+00\n"
+    "  %r = fadd double %y, %z\n"
+    "  ret double %r\n"
+    "}\n");
+  BasicBlock::iterator storeIt = getInstruction(F, "x");
+  Instruction *store = ++storeIt;
+
+  // register dependencies of the operands and memory dependencies of the loads
+  std::vector<Instruction*> instructions;
+  for (inst_iterator it = inst_begin(F); it != inst_end(F); ++it)
+    instructions.push_back(&*it);
+  InstructionDependencyList dependencies(instructions.size());
+  for (unsigned int i=0; i<instructions.size(); i++) {
+    dependencies[i].tgtInstruction = instructions[i];
+    for (User::op_iterator opIt = instructions[i]->op_begin(); opIt != instructions[i]->op_end(); ++opIt) {
+      if (Instruction *op = dyn_cast<Instruction>(*opIt)) {
+        InstructionDependency dependency;
+        dependency.depInstruction = op;
+        dependency.isRegdep = true;
+        dependencies[i].dependencies.push_back(dependency);
+      }
+    }
+    if (isa<LoadInst>(instructions[i])) {
+      InstructionDependency dependency;
+      dependency.depInstruction = store;
+      dependency.isMemDep = true;
+      dependencies[i].dependencies.push_back(dependency);
+    }
+  }
+  PartitioningGraph pGraph;
+  pGraph.create(instructions, dependencies);
+  ASSERT_EQ(7u, pGraph.getVertexCount());
+
+  // partition 1 uses x and the stored value twice, but calculates z before y
+  const unsigned int partitions[] = { 0, 0, 1, 1, 0, 1, 1 };
+  const unsigned int positionInSchedule[] = { 0, 1, 1, 0, 2, 2, 3 };
+  for (unsigned int vd=0; vd<7; vd++)
+    pGraph.setPartition(vd, partitions[vd]);
+  std::vector<DeviceInformation::DeviceType> deviceTypes(2, DeviceInformation::CPU_LINUX);
+  std::vector<Partitioning::DependencyTransfer> transfers = Partitioning::collectTransfers(pGraph, dependencies,
+    deviceTypes, std::vector<unsigned int>(positionInSchedule, positionInSchedule + 7));
+
+  // one transfer for each value, received by its first user (w needs none)
+  ASSERT_EQ(2u, transfers.size());
+  unsigned int data = (transfers[0].useSemaphores ? 1 : 0);
+  EXPECT_EQ(getInstruction(F, "x"), transfers[data].depInstr);
+  EXPECT_EQ(getInstruction(F, "z"), transfers[data].tgtInstr);
+  EXPECT_EQ(3u, transfers[data].tgtVertex);
+  EXPECT_EQ(1u, transfers[data].tgtPosition);
+  EXPECT_TRUE(transfers[1 - data].useSemaphores);
+  EXPECT_EQ(store, transfers[1 - data].depInstr);
+  EXPECT_EQ(getInstruction(F, "v"), transfers[1 - data].tgtInstr);
+  EXPECT_EQ(0u, transfers[1 - data].tgtPosition);
+}
+
+}
@@ -0,0 +1,122 @@
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Assembly/Parser.h"
+#include "llvm/Analysis/Verifier.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "gtest/gtest.h"
+
+#include "mehari/Transforms/TreeHeightReduction.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+
+using namespace llvm;
+
+namespace {
+
+class TreeHeightReductionTest : public testing::Test {
+
+protected:
+
+  void ParseAssembly(const char *Assembly) {
+    M.reset(new Module("Module", getGlobalContext()));
+
+    SMDiagnostic Error;
+    bool Parsed = ParseAssemblyString(Assembly, M.get(), Error, M->getContext()) == M.get();
+
+    std::string errMsg;
+    raw_string_ostream os(errMsg);
+    Error.print("", os);
+
+    if (!Parsed) {
+      // A failure here means that the test itself is buggy.
+      report_fatal_error(os.str().c_str());
+    }
+
+    F = M->getFunction("test");
+    if (F == NULL)
+      report_fatal_error("Test must have a function named @test");
+  }
+
+  bool runPass(bool reassociate) {
+    TreeHeightReduction pass;
+    pass.setTargetFunctions(std::vector<std::string>(1, "test"));
+    pass.setReassociate(reassociate);
+    return pass.runOnFunction(*F);
+  }
+
+  // number of operations of the same kind on the longest path to the value
+  unsigned int getDepth(Value *value, unsigned int opcode) {
+    Instruction *instr = dyn_cast<Instruction>(value);
+    if (instr == NULL || instr->getOpcode() != opcode)
+      return 0;
+    return 1 + std::max(getDepth(instr->getOperand(0), opcode), getDepth(instr->getOperand(1), opcode));
+  }
+
+  Value *getReturnValue() {
+    return cast<ReturnInst>(F->getEntryBlock().getTerminator())->getReturnValue();
+  }
+
+  OwningPtr<Module> M;
+  Function *F;
+};
+
+
+static const char *sumOfEightTerms =
+  "define double @test(double %a, double %b, double %c, double %d,\n"
+  "                    double %e, double %f, double %g, double %h) {\n"
+  "entry:\n"
+  "  %s1 = fadd double %a, %b\n"
+  "  %s2 = fadd double %s1, %c\n"
+  "  %s3 = fadd double %s2, %d\n"
+  "  %s4 = fadd double %s3, %e\n"
+  "  %s5 = fadd double %s4, %f\n"
+  "  %s6 = fadd double %s5, %g\n"
+  "  %s7 = fadd double %s6, %h\n"
+  "  ret double %s7\n"
+  "}\n";
+
+TEST_F(TreeHeightReductionTest, RebalanceChainTest) {
+  ParseAssembly(sumOfEightTerms);
+  EXPECT_EQ(7u, getDepth(getReturnValue(), Instruction::FAdd));
+
+  EXPECT_TRUE(runPass(true));
+  EXPECT_FALSE(verifyModule(*M, ReturnStatusAction));
+
+  // log2(8) levels with the same number of additions
+  EXPECT_EQ(3u, getDepth(getReturnValue(), Instruction::FAdd));
+  EXPECT_EQ(8u, F->getEntryBlock().size());
+}
+
+TEST_F(TreeHeightReductionTest, KeepChainWithoutReassociationTest) {
+  ParseAssembly(sumOfEightTerms);
+
+  // the rounding of the result may change, so we only report the chain
+  EXPECT_FALSE(runPass(false));
+  EXPECT_EQ(7u, getDepth(getReturnValue(), Instruction::FAdd));
+}
+
+TEST_F(TreeHeightReductionTest, SharedIntermediateResultTest) {
+  ParseAssembly(
+    "define double @test(double %a, double %b, double %c, double %d) {\n"
+    "entry:\n"
+    "  %p1 = fmul double %a, %b\n"
+    "  %p2 = fmul double %p1, %c\n"
+    "  %p3 = fmul double %p2, %d\n"
+    "  %r = fadd double %p3, %p2\n"
+    "  ret double %r\n"
+    "}\n");
+
+  // %p2 is used twice, so only %p3 = %p2 * %d is left, which can't be improved
+  EXPECT_FALSE(runPass(true));
+  EXPECT_EQ(3u, getDepth(cast<Instruction>(getReturnValue())->getOperand(0), Instruction::FMul));
+}
+
+}
@@ -0,0 +1,50 @@
+--------------------------------------------------------------------------------
+--                          ParameterAssignmentTest
+-- This wrapper has been generated by PivPav (using FloPoCo)
+-- and is distributed under the terms of the GNU Lesser General Public Licence.
+-- Authors: 
+--------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use ieee.math_real.all;
+
+library work;
+use work.float_helpers.all;
+
+entity fptoui is
+  port (
+    aclk : in std_logic;
+    a_data : in std_logic_vector(63 downto 0);
+    a_valid : in std_logic;
+    a_ready : out std_logic;
+    result_data : out std_logic_vector(31 downto 0);
+    result_valid : out std_logic;
+    result_ready : in std_logic
+  );
+end entity;
+
+architecture behavioural of fptoui is
+begin
+  fptoui : process(aclk)
+    variable value : real;
+  begin
+    if rising_edge(aclk) then
+      if a_valid = '1' then
+        -- round towards zero like C does
+        value := trunc(to_real(a_data));
+        if value >= 2147483648.0 then
+          result_data <= '1' & std_logic_vector(to_unsigned(integer(value - 2147483648.0), result_data'length-1));
+        else
+          result_data <= std_logic_vector(to_unsigned(integer(value), result_data'length));
+        end if;
+        result_valid <= '1';
+      else
+        result_data <= (others => '0');
+        result_valid <= '0';
+      end if;
+    end if;
+  end process;
+
+  a_ready <= result_ready;
+end architecture;
@@ -0,0 +1,56 @@
+--------------------------------------------------------------------------------
+--                          ParameterAssignmentTest
+-- This wrapper has been generated by PivPav (using FloPoCo)
+-- and is distributed under the terms of the GNU Lesser General Public Licence.
+-- Authors: 
+--------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity mul is
+  port (
+    aclk : in std_logic;
+    a_data : in std_logic_vector(31 downto 0);
+    a_valid : in std_logic;
+    a_ready : out std_logic;
+    b_data : in std_logic_vector(31 downto 0);
+    b_valid : in std_logic;
+    b_ready : out std_logic;
+    result_data : out std_logic_vector(31 downto 0);
+    result_valid : out std_logic;
+    result_ready : in std_logic
+  );
+end entity;
+
+architecture behavioural of mul is
+  -- like a multiplier of DSP48E1 slices: the inputs, the product and two
+  -- pipeline registers, so the result is valid 4 cycles after the inputs
+  constant STAGES : natural := 4;
+  type product_array is array (2 to STAGES) of signed(31 downto 0);
+  signal a_reg, b_reg : signed(31 downto 0);
+  signal product : product_array;
+  signal valid : std_logic_vector(1 to STAGES);
+begin
+  mul : process(aclk)
+  begin
+    if rising_edge(aclk) then
+      a_reg <= signed(a_data);
+      b_reg <= signed(b_data);
+      valid(1) <= a_valid and b_valid;
+
+      product(2) <= resize(a_reg * b_reg, 32);
+      valid(2) <= valid(1);
+      for i in 3 to STAGES loop
+        product(i) <= product(i-1);
+        valid(i) <= valid(i-1);
+      end loop;
+    end if;
+  end process;
+
+  result_data <= std_logic_vector(product(STAGES)) WHEN valid(STAGES) = '1' ELSE (others => '0');
+  result_valid <= valid(STAGES);
+
+  a_ready <= result_ready;
+  b_ready <= result_ready;
+end architecture;
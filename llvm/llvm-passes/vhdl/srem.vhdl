@@ -0,0 +1,93 @@
+--------------------------------------------------------------------------------
+--                          ParameterAssignmentTest
+-- This wrapper has been generated by PivPav (using FloPoCo)
+-- and is distributed under the terms of the GNU Lesser General Public Licence.
+-- Authors: 
+--------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity srem is
+  port (
+    aclk : in std_logic;
+    a_data : in std_logic_vector(31 downto 0);
+    a_valid : in std_logic;
+    a_ready : out std_logic;
+    b_data : in std_logic_vector(31 downto 0);
+    b_valid : in std_logic;
+    b_ready : out std_logic;
+    result_data : out std_logic_vector(31 downto 0);
+    result_valid : out std_logic;
+    result_ready : in std_logic
+  );
+end entity;
+
+architecture behavioural of srem is
+  -- A combinational 32-bit divider doesn't meet the timing, so this is a radix-2
+  -- pipeline: stage 0 registers the inputs, stage i determines bit 32-i of the
+  -- quotient and the output register follows, so the result is valid 34 cycles
+  -- after the inputs (like the Divider Generator in radix-2 mode).
+  constant STAGES : natural := 32;
+  type word_array is array (0 to STAGES) of unsigned(31 downto 0);
+  type remainder_array is array (0 to STAGES) of unsigned(32 downto 0);
+  signal dividend, divisor, quotient : word_array;
+  signal remainder : remainder_array;
+  signal valid : std_logic_vector(0 to STAGES);
+  signal negate : std_logic_vector(0 to STAGES);
+begin
+  srem : process(aclk)
+    variable partial : unsigned(32 downto 0);
+  begin
+    if rising_edge(aclk) then
+      -- the pipeline divides the absolute values (the absolute value of -2^31 is 2^31)
+      if a_data(31) = '1' then
+        dividend(0) <= unsigned(-signed(a_data));
+      else
+        dividend(0) <= unsigned(a_data);
+      end if;
+      if b_data(31) = '1' then
+        divisor(0) <= unsigned(-signed(b_data));
+      else
+        divisor(0) <= unsigned(b_data);
+      end if;
+      quotient(0) <= (others => '0');
+      remainder(0) <= (others => '0');
+      valid(0) <= a_valid and b_valid;
+      negate(0) <= a_data(31);
+
+      for i in 1 to STAGES loop
+        partial := remainder(i-1)(31 downto 0) & dividend(i-1)(STAGES - i);
+        if partial >= ('0' & divisor(i-1)) then
+          remainder(i) <= partial - ('0' & divisor(i-1));
+          quotient(i) <= quotient(i-1)(30 downto 0) & '1';
+        else
+          remainder(i) <= partial;
+          quotient(i) <= quotient(i-1)(30 downto 0) & '0';
+        end if;
+        dividend(i) <= dividend(i-1);
+        divisor(i) <= divisor(i-1);
+        valid(i) <= valid(i-1);
+        negate(i) <= negate(i-1);
+      end loop;
+    end if;
+  end process;
+
+  -- the remainder has the sign of the dividend
+  result : process(aclk)
+  begin
+    if rising_edge(aclk) then
+      if valid(STAGES) = '1' and negate(STAGES) = '1' then
+        result_data <= std_logic_vector(-signed(remainder(STAGES)(31 downto 0)));
+      elsif valid(STAGES) = '1' then
+        result_data <= std_logic_vector(remainder(STAGES)(31 downto 0));
+      else
+        result_data <= (others => '0');
+      end if;
+      result_valid <= valid(STAGES);
+    end if;
+  end process;
+
+  a_ready <= result_ready;
+  b_ready <= result_ready;
+end architecture;
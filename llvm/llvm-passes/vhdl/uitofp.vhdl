@@ -0,0 +1,49 @@
+--------------------------------------------------------------------------------
+--                          ParameterAssignmentTest
+-- This wrapper has been generated by PivPav (using FloPoCo)
+-- and is distributed under the terms of the GNU Lesser General Public Licence.
+-- Authors: 
+--------------------------------------------------------------------------------
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use ieee.math_real.all;
+
+library work;
+use work.float_helpers.all;
+
+entity uitofp is
+  port (
+    aclk : in std_logic;
+    a_data : in std_logic_vector(31 downto 0);
+    a_valid : in std_logic;
+    a_ready : out std_logic;
+    result_data : out std_logic_vector(63 downto 0);
+    result_valid : out std_logic;
+    result_ready : in std_logic
+  );
+end entity;
+
+architecture behavioural of uitofp is
+begin
+  uitofp : process(aclk)
+    variable value : real;
+  begin
+    if rising_edge(aclk) then
+      if a_valid = '1' then
+        -- an integer cannot hold values above 2**31-1
+        value := real(to_integer(unsigned(a_data(30 downto 0))));
+        if a_data(31) = '1' then
+          value := value + 2147483648.0;
+        end if;
+        result_data <= to_float(value);
+        result_valid <= '1';
+      else
+        result_data <= (others => '0');
+        result_valid <= '0';
+      end if;
+    end if;
+  end process;
+
+  a_ready <= result_ready;
+end architecture;
@@ -0,0 +1,302 @@
+#define _GNU_SOURCE
+#include "mehari_channel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// the Cortex-A9 has 32 byte cache lines, but we use 64 bytes
+// so the host version does not suffer from false sharing either
+#define CACHE_LINE_SIZE 64
+#define CHANNEL_SIZE 16
+
+#ifndef MEHARI_CHANNEL_SPIN
+#define MEHARI_CHANNEL_SPIN 1000
+#endif
+
+// smallest spin window of the adaptation and how often we try the full window again
+#define MIN_SPIN_WINDOW 16
+#define PROBE_INTERVAL 16
+
+// statistics and spin window of the waiting side of a channel or semaphore
+struct wait_stats
+{
+    uint32_t spin_window;
+    uint32_t blocks_since_probe;
+    unsigned long long spin_successes;
+    unsigned long long blocks;
+};
+
+struct channel
+{
+    // written by the producer
+    uint32_t head __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint32_t producer_waiting;
+    uint32_t tail_cache;
+    struct wait_stats producer_stats;
+
+    // written by the consumer
+    uint32_t tail __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint32_t consumer_waiting;
+    uint32_t head_cache;
+    struct wait_stats consumer_stats;
+
+    uint64_t slots[CHANNEL_SIZE] __attribute__((aligned(CACHE_LINE_SIZE)));
+};
+
+struct semaphore
+{
+    uint32_t count __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint32_t waiting;
+    struct wait_stats stats;
+};
+
+static struct channel channels[MEHARI_CHANNEL_COUNT];
+static struct semaphore semaphores[MEHARI_SEMAPHORE_COUNT];
+
+static pthread_once_t initialized = PTHREAD_ONCE_INIT;
+static uint32_t max_spin_window = MEHARI_CHANNEL_SPIN;
+static int adaptive_spinning = 1;
+
+
+static void write_stats_at_exit(void)
+{
+    mehari_channel_write_stats(getenv("MEHARI_SYNC_STATS"));
+}
+
+static void init(void)
+{
+    const char* spin = getenv("MEHARI_SPIN");
+    const char* adaptive = getenv("MEHARI_SPIN_ADAPTIVE");
+    if (spin)
+        max_spin_window = strtoul(spin, NULL, 0);
+    if (adaptive)
+        adaptive_spinning = atoi(adaptive);
+    if (getenv("MEHARI_SYNC_STATS"))
+        atexit(write_stats_at_exit);
+}
+
+static void write_wait_stats(FILE* file, const char* kind, uint32_t number, const char* side, struct wait_stats* stats)
+{
+    if (stats->spin_successes == 0 && stats->blocks == 0)
+        return;
+    fprintf(file, "%s %u %s %llu %llu %u\n", kind, number, side,
+        stats->spin_successes, stats->blocks, stats->spin_window);
+}
+
+void mehari_channel_write_stats(const char* filename)
+{
+    uint32_t i;
+    FILE* file = fopen(filename ? filename : "mehari.syncstats", "w");
+    if (!file)
+    {
+        perror("mehari_channel_write_stats");
+        return;
+    }
+
+    fprintf(file, "# mehari synchronization statistics (max spin window: %u%s)\n",
+        max_spin_window, adaptive_spinning ? ", adaptive" : "");
+    fprintf(file, "# <channel|semaphore> <number> <side> <spin successes> <blocks> <spin window>\n");
+    for (i=0; i<MEHARI_CHANNEL_COUNT; i++)
+    {
+        write_wait_stats(file, "channel", i, "get", &channels[i].consumer_stats);
+        write_wait_stats(file, "channel", i, "put", &channels[i].producer_stats);
+    }
+    for (i=0; i<MEHARI_SEMAPHORE_COUNT; i++)
+        write_wait_stats(file, "semaphore", i, "wait", &semaphores[i].stats);
+
+    fclose(file);
+}
+
+
+static inline void cpu_relax(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__ ("pause");
+#elif defined(__arm__)
+    __asm__ __volatile__ ("yield");
+#endif
+}
+
+static inline struct channel* get_channel(uint32_t channel)
+{
+    if (channel >= MEHARI_CHANNEL_COUNT)
+    {
+        fprintf(stderr, "ERROR: invalid channel %u (max: %d)\n", channel, MEHARI_CHANNEL_COUNT);
+        exit(1);
+    }
+    pthread_once(&initialized, init);
+    return &channels[channel];
+}
+
+static inline struct semaphore* get_semaphore(uint32_t semaphore)
+{
+    if (semaphore >= MEHARI_SEMAPHORE_COUNT)
+    {
+        fprintf(stderr, "ERROR: invalid semaphore %u (max: %d)\n", semaphore, MEHARI_SEMAPHORE_COUNT);
+        exit(1);
+    }
+    pthread_once(&initialized, init);
+    return &semaphores[semaphore];
+}
+
+// wait until the counter has changed and return the new value:
+// spin for a while and sleep on the futex, if the other side takes longer
+static uint32_t wait_for_change(uint32_t* counter, uint32_t value, uint32_t* waiting, struct wait_stats* stats)
+{
+    uint32_t i, window, current;
+
+    if (!adaptive_spinning || stats->spin_window == 0 || stats->spin_window > max_spin_window)
+        stats->spin_window = max_spin_window;
+    window = stats->spin_window;
+
+    for (i=0; i<window; i++)
+    {
+        current = __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+        if (current != value)
+        {
+            // the other side usually needs about as long as this time,
+            // so we spin twice as long the next time
+            stats->spin_successes++;
+            if (adaptive_spinning)
+                stats->spin_window = (2*i < MIN_SPIN_WINDOW ? MIN_SPIN_WINDOW : 2*i);
+            return current;
+        }
+        cpu_relax();
+    }
+
+    // spinning did not help: use a smaller window next time,
+    // but try the full window again from time to time
+    stats->blocks++;
+    if (adaptive_spinning)
+    {
+        if (++stats->blocks_since_probe >= PROBE_INTERVAL)
+        {
+            stats->blocks_since_probe = 0;
+            stats->spin_window = max_spin_window;
+        }
+        else if (window/2 >= MIN_SPIN_WINDOW)
+            stats->spin_window = window/2;
+    }
+
+    for (;;)
+    {
+        // the other side checks the flag after it has changed the counter
+        __atomic_store_n(waiting, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        current = __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+        if (current != value)
+            break;
+        syscall(SYS_futex, counter, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+    }
+    __atomic_store_n(waiting, 0, __ATOMIC_RELAXED);
+    return current;
+}
+
+static inline void wake_waiting(uint32_t* counter, uint32_t* waiting)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiting, __ATOMIC_RELAXED))
+        syscall(SYS_futex, counter, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+static inline void publish(uint32_t* counter, uint32_t value, uint32_t* waiting)
+{
+    __atomic_store_n(counter, value, __ATOMIC_RELEASE);
+    wake_waiting(counter, waiting);
+}
+
+static void put(uint32_t channel, uint64_t value)
+{
+    struct channel* c = get_channel(channel);
+    uint32_t head = c->head;
+
+    if (head - c->tail_cache == CHANNEL_SIZE)
+    {
+        c->tail_cache = __atomic_load_n(&c->tail, __ATOMIC_ACQUIRE);
+        if (head - c->tail_cache == CHANNEL_SIZE)
+            c->tail_cache = wait_for_change(&c->tail, c->tail_cache, &c->producer_waiting, &c->producer_stats);
+    }
+
+    c->slots[head % CHANNEL_SIZE] = value;
+    publish(&c->head, head + 1, &c->consumer_waiting);
+}
+
+static uint64_t get(uint32_t channel)
+{
+    struct channel* c = get_channel(channel);
+    uint32_t tail = c->tail;
+    uint64_t value;
+
+    if (c->head_cache == tail)
+    {
+        c->head_cache = __atomic_load_n(&c->head, __ATOMIC_ACQUIRE);
+        if (c->head_cache == tail)
+            c->head_cache = wait_for_change(&c->head, tail, &c->consumer_waiting, &c->consumer_stats);
+    }
+
+    value = c->slots[tail % CHANNEL_SIZE];
+    publish(&c->tail, tail + 1, &c->producer_waiting);
+    return value;
+}
+
+
+void _ring_put_real(uint32_t channel, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put(channel, bits);
+}
+
+void _ring_put_int(uint32_t channel, int32_t value)
+{
+    put(channel, (uint32_t)value);
+}
+
+void _ring_put_bool(uint32_t channel, int value)
+{
+    put(channel, value != 0);
+}
+
+double _ring_get_real(uint32_t channel)
+{
+    uint64_t bits = get(channel);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int32_t _ring_get_int(uint32_t channel)
+{
+    return (int32_t)(uint32_t)get(channel);
+}
+
+int _ring_get_bool(uint32_t channel)
+{
+    return (int)get(channel);
+}
+
+
+void _ring_sem_post(uint32_t semaphore)
+{
+    struct semaphore* s = get_semaphore(semaphore);
+    __atomic_fetch_add(&s->count, 1, __ATOMIC_RELEASE);
+    wake_waiting(&s->count, &s->waiting);
+}
+
+void _ring_sem_wait(uint32_t semaphore)
+{
+    struct semaphore* s = get_semaphore(semaphore);
+    uint32_t count = __atomic_load_n(&s->count, __ATOMIC_ACQUIRE);
+    for (;;)
+    {
+        if (count == 0)
+            count = wait_for_change(&s->count, 0, &s->waiting, &s->stats);
+        if (__atomic_compare_exchange_n(&s->count, &count, count - 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+            return;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef MEHARI_CHANNEL_H
+#define MEHARI_CHANNEL_H
+
+// Lock-free single-producer/single-consumer channels for data dependencies
+// between two processor partitions. They are used instead of the _put_*/_get_*
+// mailboxes, if the partitioning pass is called with '-cpu-transport=ring'.
+// The channel number is the dependency number of the pass, so each channel
+// has exactly one sending and one receiving thread.
+// Semaphores between two processor partitions use _ring_sem_post/_ring_sem_wait.
+//
+// A receiver (or a sender of a full channel) spins before it blocks on a futex.
+// The spin window of each channel and semaphore adapts to twice the time the
+// partner needed the last time and shrinks after each failed spin. It can be
+// configured by environment variables:
+//   MEHARI_SPIN           maximum spin window in iterations (default: MEHARI_CHANNEL_SPIN, 0 to always block)
+//   MEHARI_SPIN_ADAPTIVE  0 to always spin for the maximum window
+//   MEHARI_SYNC_STATS     write the number of successful spins and blocks to this file at exit
+
+#include <stdint.h>
+
+#ifndef MEHARI_CHANNEL_COUNT
+#define MEHARI_CHANNEL_COUNT 256
+#endif
+#ifndef MEHARI_SEMAPHORE_COUNT
+#define MEHARI_SEMAPHORE_COUNT 256
+#endif
+
+void    _ring_put_real(uint32_t channel, double value);
+void    _ring_put_int(uint32_t channel, int32_t value);
+void    _ring_put_bool(uint32_t channel, int value);
+
+double  _ring_get_real(uint32_t channel);
+int32_t _ring_get_int(uint32_t channel);
+int     _ring_get_bool(uint32_t channel);
+
+void    _ring_sem_post(uint32_t semaphore);
+void    _ring_sem_wait(uint32_t semaphore);
+
+// write the statistics now (they are written at exit, if MEHARI_SYNC_STATS is set)
+void mehari_channel_write_stats(const char* filename);
+
+#endif /*MEHARI_CHANNEL_H*/
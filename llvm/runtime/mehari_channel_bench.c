@@ -0,0 +1,115 @@
+// Measures the costs of the ring buffer channels between two cores and prints
+// them in the format of 'opt -partitioning -cpu-transport-costs <file>':
+//   mehari_channel_bench [cpu clock in MHz (default: 800)] > channel.costs
+// A message with one double, a message with eight doubles and a semaphore
+// are sent back and forth, half of a round trip is the cost of a message.
+
+#define _GNU_SOURCE
+#include "mehari_channel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define ITERATIONS 100000
+#define LARGE_MESSAGE 8
+
+static void pin_to_core(int core)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+        fprintf(stderr, "WARNING: could not pin thread to core %d\n", core);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void* echo(void* arg)
+{
+    int i, k;
+    (void)arg;
+    pin_to_core(1);
+    for (i=0; i<2*ITERATIONS; i++)
+    {
+        // the first half of the iterations uses single values, the second half large messages
+        int size = (i < ITERATIONS ? 1 : LARGE_MESSAGE);
+        for (k=0; k<size; k++)
+            _ring_put_real(1, _ring_get_real(0));
+    }
+    for (i=0; i<ITERATIONS; i++)
+    {
+        _ring_sem_wait(0);
+        _ring_sem_post(1);
+    }
+    return NULL;
+}
+
+// one-way time of a message in ns
+static double measure(int size)
+{
+    int i, k;
+    double sum = 0;
+    uint64_t start = now_ns();
+    for (i=0; i<ITERATIONS; i++)
+    {
+        for (k=0; k<size; k++)
+            _ring_put_real(0, i + k);
+        for (k=0; k<size; k++)
+            sum += _ring_get_real(1);
+    }
+    if (sum < 0)
+        printf("# invalid checksum\n");
+    return (double)(now_ns() - start) / ITERATIONS / 2;
+}
+
+// one-way time of a semaphore in ns
+static double measure_semaphore(void)
+{
+    int i;
+    uint64_t start = now_ns();
+    for (i=0; i<ITERATIONS; i++)
+    {
+        _ring_sem_post(0);
+        _ring_sem_wait(1);
+    }
+    return (double)(now_ns() - start) / ITERATIONS / 2;
+}
+
+int main(int argc, char** argv)
+{
+    pthread_t thread;
+    double mhz = (argc > 1 ? atof(argv[1]) : 800);
+    double single, large, word, message, semaphore;
+
+    pin_to_core(0);
+    if (pthread_create(&thread, NULL, echo, NULL) != 0)
+    {
+        perror("pthread_create");
+        return 1;
+    }
+    single = measure(1);
+    large = measure(LARGE_MESSAGE);
+    semaphore = measure_semaphore();
+    pthread_join(thread, NULL);
+
+    // a double has two words
+    word = (large - single) / ((LARGE_MESSAGE - 1) * 2);
+    if (word < 0)
+        word = 0;
+    message = single - 2 * word;
+
+    printf("# measured with mehari_channel_bench @ %.0f MHz\n", mhz);
+    printf("DataDependency %.0f\n", message * mhz / 1000);
+    printf("DataWord %.0f\n", word * mhz / 1000);
+    printf("OrderDependency %.0f\n", semaphore * mhz / 1000);
+    return 0;
+}
@@ -0,0 +1,85 @@
+#ifndef MEHARI_MESSAGE_H
+#define MEHARI_MESSAGE_H
+
+// Atomic multi-word messages over ReconOS mailboxes. A mailbox transports
+// 32 bit words, so a value or a pointer with more bits is split into several
+// words. If more than one thread puts to (or gets from) the same mailbox, the
+// words of different messages can interleave. The functions in this file hold
+// a lock while the words of one message are transferred.
+//
+// The generated code of the partitioning pass ('-fpga-atomic-messages') uses
+// the send/receive pairs: send_begin draws a ticket and the replies of the
+// hardware thread are received in the order of the tickets. So several threads
+// can share one hardware thread and the next request can be sent while the
+// hardware is still busy with the previous one.
+//
+// This header needs mbox.h of ReconOS and pthreads.
+
+#include "mbox.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+struct mehari_message_channel
+{
+    pthread_mutex_t send_lock;
+    pthread_mutex_t receive_lock;
+    pthread_cond_t  turn;
+    uint32_t next_ticket;
+    uint32_t serving;
+};
+
+#define MEHARI_MESSAGE_CHANNEL_INITIALIZER \
+    { PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0 }
+
+// all words between send_begin and send_end form one message, returns the ticket for the reply
+static inline uint32_t mehari_message_send_begin(struct mehari_message_channel* ch)
+{
+    pthread_mutex_lock(&ch->send_lock);
+    return ch->next_ticket++;
+}
+
+static inline void mehari_message_send_end(struct mehari_message_channel* ch)
+{
+    pthread_mutex_unlock(&ch->send_lock);
+}
+
+// waits until the replies to all earlier tickets have been received
+static inline void mehari_message_receive_begin(struct mehari_message_channel* ch, uint32_t ticket)
+{
+    pthread_mutex_lock(&ch->receive_lock);
+    while (ch->serving != ticket)
+        pthread_cond_wait(&ch->turn, &ch->receive_lock);
+}
+
+static inline void mehari_message_receive_end(struct mehari_message_channel* ch)
+{
+    ch->serving++;
+    pthread_cond_broadcast(&ch->turn);
+    pthread_mutex_unlock(&ch->receive_lock);
+}
+
+// Puts count words as one message (for senders that don't wait for a reply).
+static inline void mehari_message_put(struct mehari_message_channel* ch, struct mbox* mb,
+    const uint32_t* words, size_t count)
+{
+    size_t i;
+    pthread_mutex_lock(&ch->send_lock);
+    for (i=0; i<count; i++)
+        mbox_put(mb, words[i]);
+    pthread_mutex_unlock(&ch->send_lock);
+}
+
+// Gets count words as one message (for several receivers of the same kind of messages).
+static inline void mehari_message_get(struct mehari_message_channel* ch, struct mbox* mb,
+    uint32_t* words, size_t count)
+{
+    size_t i;
+    pthread_mutex_lock(&ch->receive_lock);
+    for (i=0; i<count; i++)
+        words[i] = mbox_get(mb);
+    pthread_mutex_unlock(&ch->receive_lock);
+}
+
+#endif /*MEHARI_MESSAGE_H*/
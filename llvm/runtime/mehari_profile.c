@@ -0,0 +1,160 @@
+#include "mehari_profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_PROFILED_FUNCTIONS 16
+#define CALIBRATION_RUNS 1000
+
+struct instruction_profile
+{
+    unsigned long long executions;
+    unsigned long long cycles;
+};
+
+struct branch_profile
+{
+    unsigned long long taken;
+    unsigned long long not_taken;
+};
+
+struct function_profile
+{
+    const char* name;
+    uint32_t instruction_count;
+    unsigned long long invocations;
+    struct instruction_profile* instructions;
+    struct branch_profile* branches;
+};
+
+static struct function_profile functions[MAX_PROFILED_FUNCTIONS];
+static int initialized = 0;
+
+// cycles that are measured for an empty begin/end pair
+static uint64_t overhead = 0;
+
+
+static inline uint64_t read_cycle_counter(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static void calibrate(void)
+{
+    int i;
+    uint64_t min = (uint64_t)-1;
+    for (i=0; i<CALIBRATION_RUNS; i++)
+    {
+        uint64_t start = _mehari_profile_begin();
+        uint64_t diff  = read_cycle_counter() - start;
+        if (diff < min)
+            min = diff;
+    }
+    overhead = min;
+}
+
+static void write_profile_at_exit(void)
+{
+    const char* filename = getenv("MEHARI_PROFILE");
+    mehari_profile_write(filename ? filename : "mehari.profile");
+}
+
+void mehari_profile_write(const char* filename)
+{
+    int f;
+    uint32_t i;
+    FILE* file = fopen(filename, "w");
+    if (!file)
+    {
+        perror("mehari_profile_write");
+        return;
+    }
+
+    fprintf(file, "# mehari execution profile\n");
+    fprintf(file, "# calibrated overhead: %llu cycles\n", (unsigned long long)overhead);
+    for (f=0; f<MAX_PROFILED_FUNCTIONS; f++)
+    {
+        struct function_profile* fp = &functions[f];
+        if (!fp->name)
+            continue;
+
+        fprintf(file, "function %s %llu %u\n", fp->name, fp->invocations, fp->instruction_count);
+        for (i=0; i<fp->instruction_count; i++)
+            if (fp->instructions[i].executions > 0)
+                fprintf(file, "instr %u %llu %llu\n", i,
+                    fp->instructions[i].executions, fp->instructions[i].cycles);
+        for (i=0; i<fp->instruction_count; i++)
+            if (fp->branches[i].taken > 0 || fp->branches[i].not_taken > 0)
+                fprintf(file, "branch %u %llu %llu\n", i,
+                    fp->branches[i].taken, fp->branches[i].not_taken);
+    }
+
+    fclose(file);
+}
+
+void _mehari_profile_enter(uint32_t function_id, const char* name, uint32_t instruction_count)
+{
+    struct function_profile* fp;
+
+    if (!initialized)
+    {
+        initialized = 1;
+        calibrate();
+        atexit(write_profile_at_exit);
+    }
+
+    if (function_id >= MAX_PROFILED_FUNCTIONS)
+    {
+        fprintf(stderr, "ERROR: too many profiled functions (max: %d)\n", MAX_PROFILED_FUNCTIONS);
+        exit(1);
+    }
+
+    fp = &functions[function_id];
+    if (!fp->name)
+    {
+        fp->name = name;
+        fp->instruction_count = instruction_count;
+        fp->instructions = calloc(instruction_count, sizeof(struct instruction_profile));
+        fp->branches = calloc(instruction_count, sizeof(struct branch_profile));
+        if (!fp->instructions || !fp->branches)
+        {
+            perror("_mehari_profile_enter");
+            exit(1);
+        }
+    }
+
+    fp->invocations++;
+}
+
+uint64_t _mehari_profile_begin(void)
+{
+    return read_cycle_counter();
+}
+
+void _mehari_profile_end(uint32_t function_id, uint32_t instruction_id, uint64_t start)
+{
+    uint64_t cycles = read_cycle_counter() - start;
+    struct instruction_profile* ip = &functions[function_id].instructions[instruction_id];
+
+    ip->executions++;
+    ip->cycles += (cycles > overhead ? cycles - overhead : 0);
+}
+
+void _mehari_profile_branch(uint32_t function_id, uint32_t instruction_id, int condition)
+{
+    struct branch_profile* bp = &functions[function_id].branches[instruction_id];
+
+    if (condition)
+        bp->taken++;
+    else
+        bp->not_taken++;
+}
@@ -0,0 +1,19 @@
+#ifndef MEHARI_PROFILE_H
+#define MEHARI_PROFILE_H
+
+// Runtime for functions that have been instrumented by the
+// profiling-instrumentation pass. The profile is written to the file
+// given by the environment variable MEHARI_PROFILE (default: mehari.profile)
+// when the program exits and can be used by 'opt -partitioning -partitioning-profile'.
+
+#include <stdint.h>
+
+void _mehari_profile_enter(uint32_t function_id, const char* name, uint32_t instruction_count);
+uint64_t _mehari_profile_begin(void);
+void _mehari_profile_end(uint32_t function_id, uint32_t instruction_id, uint64_t start);
+void _mehari_profile_branch(uint32_t function_id, uint32_t instruction_id, int condition);
+
+// write the profile now (it is written at exit anyway)
+void mehari_profile_write(const char* filename);
+
+#endif /*MEHARI_PROFILE_H*/
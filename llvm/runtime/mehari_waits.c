@@ -0,0 +1,185 @@
+#include "mehari_waits.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct wait_counter
+{
+    unsigned long long calls;
+    unsigned long long cycles;
+};
+
+// Each partition runs in one thread, so its counters have only one writer.
+struct partition_counters
+{
+    unsigned long long invocations;
+    unsigned long long cycles;
+    unsigned long long blocked;
+    struct wait_counter* waits[3];      // indexed by enum mehari_wait_kind
+};
+
+static const char* const* partition_names;
+static const uint32_t* predicted_cycles;
+static const char* const* dependency_names;
+static const char* const* semaphore_names;
+static uint32_t partition_count;
+static uint32_t wait_counts[3];
+
+static struct partition_counters* partitions;
+
+
+// unit of the measured counters (see read_cycle_counter)
+#if defined(__i386__) || defined(__x86_64__)
+#define COUNTER_UNIT "tsc ticks"
+#else
+#define COUNTER_UNIT "ns"
+#endif
+
+// clock of the CPU that the predicted cycles are converted with
+#define DEFAULT_CPU_MHZ 800.0
+
+
+static inline uint64_t read_cycle_counter(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static void write_waits_at_exit(void)
+{
+    const char* filename = getenv("MEHARI_WAITS");
+    mehari_waits_write(filename ? filename : "mehari.waits");
+}
+
+void _mehari_waits_init(
+    const char* const* partition_names_, const uint32_t* predicted_cycles_, uint32_t partition_count_,
+    const char* const* dependency_names_, uint32_t dependency_count,
+    const char* const* semaphore_names_, uint32_t semaphore_count)
+{
+    uint32_t p;
+    int kind;
+
+    partition_names  = partition_names_;
+    predicted_cycles = predicted_cycles_;
+    partition_count  = partition_count_;
+    dependency_names = dependency_names_;
+    semaphore_names  = semaphore_names_;
+    wait_counts[MEHARI_WAIT_DATA]      = dependency_count;
+    wait_counts[MEHARI_WAIT_SEMAPHORE] = semaphore_count;
+    wait_counts[MEHARI_WAIT_FPGA]      = partition_count;
+
+    partitions = calloc(partition_count, sizeof(struct partition_counters));
+    if (!partitions)
+    {
+        perror("_mehari_waits_init");
+        exit(1);
+    }
+    for (p=0; p<partition_count; p++)
+        for (kind=0; kind<3; kind++)
+        {
+            // calloc may return NULL for zero elements
+            partitions[p].waits[kind] = calloc(wait_counts[kind] + 1, sizeof(struct wait_counter));
+            if (!partitions[p].waits[kind])
+            {
+                perror("_mehari_waits_init");
+                exit(1);
+            }
+        }
+
+    atexit(write_waits_at_exit);
+}
+
+uint64_t _mehari_wait_begin(void)
+{
+    return read_cycle_counter();
+}
+
+void _mehari_wait_end(uint32_t partition, uint32_t kind, uint32_t number, uint64_t start)
+{
+    uint64_t cycles = read_cycle_counter() - start;
+    struct partition_counters* pc = &partitions[partition];
+    struct wait_counter* wc = &pc->waits[kind][number];
+
+    wc->calls++;
+    wc->cycles += cycles;
+    pc->blocked += cycles;
+}
+
+void _mehari_partition_end(uint32_t partition, uint64_t start)
+{
+    struct partition_counters* pc = &partitions[partition];
+
+    pc->invocations++;
+    pc->cycles += read_cycle_counter() - start;
+}
+
+static const char* wait_name(uint32_t kind, uint32_t number)
+{
+    switch (kind)
+    {
+    case MEHARI_WAIT_DATA:      return dependency_names[number];
+    case MEHARI_WAIT_SEMAPHORE: return semaphore_names[number];
+    default:                    return partition_names[number];
+    }
+}
+
+static double cpu_mhz(void)
+{
+    const char* mhz = getenv("MEHARI_CPU_MHZ");
+    double value = (mhz ? atof(mhz) : 0);
+    return (value > 0 ? value : DEFAULT_CPU_MHZ);
+}
+
+void mehari_waits_write(const char* filename)
+{
+    static const char* const kind_names[3] = { "data", "semaphore", "fpga" };
+    uint32_t p, number;
+    int kind;
+    double mhz = cpu_mhz();
+    FILE* file = fopen(filename, "w");
+    if (!file)
+    {
+        perror("mehari_waits_write");
+        return;
+    }
+
+    fprintf(file, "# mehari wait counters\n");
+    fprintf(file, "# measured times in %s, predicted critical path in model cycles and in ns @ %.0f MHz\n",
+        COUNTER_UNIT, mhz);
+    fprintf(file, "# partition <name> <invocations> <time> <blocked time> "
+        "<predicted cycles per invocation> <predicted ns per invocation>\n");
+    fprintf(file, "# <data|semaphore|fpga> <number> <calls> <blocked time> <source instruction>\n");
+    for (p=0; p<partition_count; p++)
+    {
+        struct partition_counters* pc = &partitions[p];
+        double predicted_ns = predicted_cycles[p] * 1000.0 / mhz;
+        if (pc->invocations == 0)
+            continue;
+
+        fprintf(file, "partition %s %llu %llu %llu %u %.0f\n", partition_names[p],
+            pc->invocations, pc->cycles, pc->blocked, predicted_cycles[p], predicted_ns);
+        fprintf(file, "#   %llu %s per invocation (predicted: %u cycles = %.0f ns), %.1f%% computing, %.1f%% blocked\n",
+            pc->cycles / pc->invocations, COUNTER_UNIT, predicted_cycles[p], predicted_ns,
+            pc->cycles ? 100.0 * (pc->cycles - pc->blocked) / pc->cycles : 0.0,
+            pc->cycles ? 100.0 * pc->blocked / pc->cycles : 0.0);
+
+        for (kind=0; kind<3; kind++)
+            for (number=0; number<wait_counts[kind]; number++)
+            {
+                struct wait_counter* wc = &pc->waits[kind][number];
+                if (wc->calls > 0)
+                    fprintf(file, "  %s %u %llu %llu %s\n", kind_names[kind], number,
+                        wc->calls, wc->cycles, wait_name(kind, number));
+            }
+    }
+
+    fclose(file);
+}
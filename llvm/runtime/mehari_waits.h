@@ -0,0 +1,44 @@
+#ifndef MEHARI_WAITS_H
+#define MEHARI_WAITS_H
+
+// Wait-time and throughput counters for partitioned functions. The partitioning
+// pass generates calls to these functions, if it is called with
+// '-partitioning-wait-counters'. Each partition measures the cycles of its
+// invocations and how long each communication call blocks. The report is
+// written to the file given by the environment variable MEHARI_WAITS
+// (default: mehari.waits) when the program exits.
+//
+// The counters are read from the time stamp counter on x86. On other targets
+// they are in nanoseconds (the cycle counter of the Cortex-A9 cannot be read
+// from user space by default). The predicted critical path is in cycles of the
+// cost model. The report also converts it to nanoseconds with the CPU clock
+// from the environment variable MEHARI_CPU_MHZ (default: 800, the clock of the
+// Cortex-A9 in the cost model). The counters and the prediction are printed in
+// separate columns with their units.
+
+#include <stdint.h>
+
+// kinds of blocking calls, the number is the dependency, semaphore or FPGA partition
+enum mehari_wait_kind
+{
+    MEHARI_WAIT_DATA,
+    MEHARI_WAIT_SEMAPHORE,
+    MEHARI_WAIT_FPGA
+};
+
+// Must be called before the partitions run (the generated code uses a constructor).
+// The partitions are numbered across all partitioned functions, predicted_cycles
+// is the critical path of the function that a partition belongs to.
+void _mehari_waits_init(
+    const char* const* partition_names, const uint32_t* predicted_cycles, uint32_t partition_count,
+    const char* const* dependency_names, uint32_t dependency_count,
+    const char* const* semaphore_names, uint32_t semaphore_count);
+
+uint64_t _mehari_wait_begin(void);
+void _mehari_wait_end(uint32_t partition, uint32_t kind, uint32_t number, uint64_t start);
+void _mehari_partition_end(uint32_t partition, uint64_t start);
+
+// write the report now (it is written at exit anyway)
+void mehari_waits_write(const char* filename);
+
+#endif /*MEHARI_WAITS_H*/
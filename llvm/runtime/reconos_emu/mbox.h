@@ -0,0 +1,30 @@
+#ifndef RECONOS_EMU_MBOX_H
+#define RECONOS_EMU_MBOX_H
+
+// Mailboxes of the ReconOS emulation (see reconos.h in this directory).
+
+#include <stdint.h>
+#include <pthread.h>
+
+struct mbox
+{
+    uint32_t* words;
+    int size;
+    int first;
+    int count;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+};
+
+int      mbox_init(struct mbox* mb, int size);
+void     mbox_destroy(struct mbox* mb);
+
+int      mbox_put(struct mbox* mb, uint32_t msg);
+uint32_t mbox_get(struct mbox* mb);
+
+// return 1 and transfer the word, if it is possible without blocking
+int      mbox_tryput(struct mbox* mb, uint32_t msg);
+int      mbox_tryget(struct mbox* mb, uint32_t* msg);
+
+#endif /*RECONOS_EMU_MBOX_H*/
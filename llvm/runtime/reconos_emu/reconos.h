@@ -0,0 +1,49 @@
+#ifndef RECONOS_EMU_H
+#define RECONOS_EMU_H
+
+// Emulation of the ReconOS API with pthreads, so the code generated by the
+// partitioning pass can be tested and profiled on a Linux host without a board.
+// Use this directory instead of the include directory of ReconOS and link
+// libreconos_emu.a instead of libreconos.
+//
+// A hardware thread is replaced by a C function, which does the same mbox
+// transfers as the hardware. 'opt -partitioning -fpga-emulation' writes it to
+// linux/hwt_mehari_<slot>_emulation.c, which registers it for its slot. Compile
+// these files together with the generated mehari.c.
+
+#include <stddef.h>
+#include <pthread.h>
+
+#define RECONOS_TYPE_MBOX 0x00000001
+#define RECONOS_TYPE_SEM  0x00000002
+
+struct reconos_resource
+{
+    int type;
+    void* ptr;
+};
+
+struct reconos_hwt
+{
+    struct reconos_resource* resources;
+    size_t num_resources;
+    void* init_data;
+    int slot;
+    pthread_t delegate;
+};
+
+void reconos_init(void);
+void reconos_init_autodetect(void);
+void reconos_cleanup(void);
+void reconos_cache_flush(void);
+void reconos_mmu_stats(int* tlb_hits, int* tlb_misses, int* page_faults);
+
+void reconos_hwt_setresources(struct reconos_hwt* hwt, struct reconos_resource* res, size_t num_resources);
+void reconos_hwt_setinitdata(struct reconos_hwt* hwt, void* init_data);
+void reconos_hwt_create(struct reconos_hwt* hwt, int slot, void* arg);
+
+// emulation of the hardware thread in a slot (usually called by a constructor of the generated code)
+typedef void (*reconos_emu_hwt_function)(struct reconos_hwt* hwt);
+void reconos_emu_register_hwt(int slot, reconos_emu_hwt_function function);
+
+#endif /*RECONOS_EMU_H*/
@@ -0,0 +1,161 @@
+#include "reconos.h"
+#include "mbox.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_SLOTS 32
+
+static reconos_emu_hwt_function hwt_functions[MAX_SLOTS];
+
+
+// mailboxes
+// ---------
+
+int mbox_init(struct mbox* mb, int size)
+{
+    if (size < 1)
+        size = 1;
+    mb->words = malloc(size * sizeof(uint32_t));
+    if (mb->words == NULL)
+        return -1;
+    mb->size  = size;
+    mb->first = 0;
+    mb->count = 0;
+    pthread_mutex_init(&mb->lock, NULL);
+    pthread_cond_init(&mb->not_empty, NULL);
+    pthread_cond_init(&mb->not_full, NULL);
+    return 0;
+}
+
+void mbox_destroy(struct mbox* mb)
+{
+    pthread_cond_destroy(&mb->not_full);
+    pthread_cond_destroy(&mb->not_empty);
+    pthread_mutex_destroy(&mb->lock);
+    free(mb->words);
+    mb->words = NULL;
+}
+
+static void put_locked(struct mbox* mb, uint32_t msg)
+{
+    mb->words[(mb->first + mb->count) % mb->size] = msg;
+    mb->count++;
+    pthread_cond_signal(&mb->not_empty);
+}
+
+static uint32_t get_locked(struct mbox* mb)
+{
+    uint32_t msg = mb->words[mb->first];
+    mb->first = (mb->first + 1) % mb->size;
+    mb->count--;
+    pthread_cond_signal(&mb->not_full);
+    return msg;
+}
+
+int mbox_put(struct mbox* mb, uint32_t msg)
+{
+    pthread_mutex_lock(&mb->lock);
+    while (mb->count == mb->size)
+        pthread_cond_wait(&mb->not_full, &mb->lock);
+    put_locked(mb, msg);
+    pthread_mutex_unlock(&mb->lock);
+    return 0;
+}
+
+uint32_t mbox_get(struct mbox* mb)
+{
+    uint32_t msg;
+    pthread_mutex_lock(&mb->lock);
+    while (mb->count == 0)
+        pthread_cond_wait(&mb->not_empty, &mb->lock);
+    msg = get_locked(mb);
+    pthread_mutex_unlock(&mb->lock);
+    return msg;
+}
+
+int mbox_tryput(struct mbox* mb, uint32_t msg)
+{
+    int success = 0;
+    pthread_mutex_lock(&mb->lock);
+    if (mb->count < mb->size)
+    {
+        put_locked(mb, msg);
+        success = 1;
+    }
+    pthread_mutex_unlock(&mb->lock);
+    return success;
+}
+
+int mbox_tryget(struct mbox* mb, uint32_t* msg)
+{
+    int success = 0;
+    pthread_mutex_lock(&mb->lock);
+    if (mb->count > 0)
+    {
+        *msg = get_locked(mb);
+        success = 1;
+    }
+    pthread_mutex_unlock(&mb->lock);
+    return success;
+}
+
+
+// ReconOS
+// -------
+
+// there is no FPGA and the memory is shared, so there is nothing to initialize or flush
+void reconos_init(void) { }
+void reconos_init_autodetect(void) { }
+void reconos_cleanup(void) { }
+void reconos_cache_flush(void) { }
+
+void reconos_mmu_stats(int* tlb_hits, int* tlb_misses, int* page_faults)
+{
+    *tlb_hits = *tlb_misses = *page_faults = 0;
+}
+
+void reconos_hwt_setresources(struct reconos_hwt* hwt, struct reconos_resource* res, size_t num_resources)
+{
+    hwt->resources = res;
+    hwt->num_resources = num_resources;
+}
+
+void reconos_hwt_setinitdata(struct reconos_hwt* hwt, void* init_data)
+{
+    hwt->init_data = init_data;
+}
+
+void reconos_emu_register_hwt(int slot, reconos_emu_hwt_function function)
+{
+    if (slot < 0 || slot >= MAX_SLOTS)
+    {
+        fprintf(stderr, "reconos_emu: invalid slot %d\n", slot);
+        abort();
+    }
+    hwt_functions[slot] = function;
+}
+
+static void* hwt_delegate(void* arg)
+{
+    struct reconos_hwt* hwt = (struct reconos_hwt*)arg;
+    hwt_functions[hwt->slot](hwt);
+    return NULL;
+}
+
+void reconos_hwt_create(struct reconos_hwt* hwt, int slot, void* arg)
+{
+    (void)arg;
+    if (slot < 0 || slot >= MAX_SLOTS || hwt_functions[slot] == NULL)
+    {
+        fprintf(stderr, "reconos_emu: no emulation for the hardware thread in slot %d "
+            "(compile the code generated with -fpga-emulation)\n", slot);
+        abort();
+    }
+    hwt->slot = slot;
+    if (pthread_create(&hwt->delegate, NULL, hwt_delegate, hwt) != 0)
+    {
+        perror("reconos_emu: pthread_create");
+        abort();
+    }
+}
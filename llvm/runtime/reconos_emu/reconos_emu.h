@@ -0,0 +1,40 @@
+#ifndef RECONOS_EMU_VALUES_H
+#define RECONOS_EMU_VALUES_H
+
+// Values with more than 32 bits are sent in several mbox words (the low word first),
+// like the generated hardware threads do it.
+
+#include "mbox.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static inline void reconos_emu_mbox_put_real(struct mbox* mb, double value)
+{
+    uint32_t words[2];
+    memcpy(words, &value, sizeof(words));
+    mbox_put(mb, words[0]);
+    mbox_put(mb, words[1]);
+}
+
+static inline double reconos_emu_mbox_get_real(struct mbox* mb)
+{
+    uint32_t words[2];
+    double value;
+    words[0] = mbox_get(mb);
+    words[1] = mbox_get(mb);
+    memcpy(&value, words, sizeof(value));
+    return value;
+}
+
+static inline void reconos_emu_mbox_put_int(struct mbox* mb, int value)
+{
+    mbox_put(mb, (uint32_t)value);
+}
+
+static inline int reconos_emu_mbox_get_int(struct mbox* mb)
+{
+    return (int)mbox_get(mb);
+}
+
+#endif /*RECONOS_EMU_VALUES_H*/
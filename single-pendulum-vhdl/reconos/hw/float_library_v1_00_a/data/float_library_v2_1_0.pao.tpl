@@ -21,10 +21,33 @@ lib float_library_v1_00_a cos vhdl
 
 # other cores
 lib float_library_v1_00_a add vhdl
+lib float_library_v1_00_a ashr vhdl
+lib float_library_v1_00_a bit_and vhdl
 lib float_library_v1_00_a bit_or vhdl
+lib float_library_v1_00_a bit_xor vhdl
 lib float_library_v1_00_a dummy_mod vhdl
+lib float_library_v1_00_a fptosi vhdl
+lib float_library_v1_00_a fptoui vhdl
+lib float_library_v1_00_a icmp_eq vhdl
 lib float_library_v1_00_a icmp_ne vhdl
+lib float_library_v1_00_a icmp_sge vhdl
 lib float_library_v1_00_a icmp_sgt vhdl
+lib float_library_v1_00_a icmp_sle vhdl
+lib float_library_v1_00_a icmp_slt vhdl
+lib float_library_v1_00_a icmp_uge vhdl
+lib float_library_v1_00_a icmp_ugt vhdl
+lib float_library_v1_00_a icmp_ule vhdl
+lib float_library_v1_00_a icmp_ult vhdl
+lib float_library_v1_00_a lshr vhdl
+lib float_library_v1_00_a mul vhdl
+lib float_library_v1_00_a sdiv vhdl
+lib float_library_v1_00_a shl vhdl
+lib float_library_v1_00_a sitofp vhdl
+lib float_library_v1_00_a srem vhdl
+lib float_library_v1_00_a sub vhdl
+lib float_library_v1_00_a udiv vhdl
+lib float_library_v1_00_a uitofp vhdl
+lib float_library_v1_00_a urem vhdl
 
 # arithmetic cores by Xilinx (generated with coregen)
 # (added by test.sh script)
@@ -53,7 +53,8 @@ architecture implementation of hwt_single_pendulum_simple is
 
 	type STATE_TYPE is (
 					STATE_GET_ADDR,STATE_READ,STATE_STARTING,STATE_EVAL,
-					STATE_WRITE,STATE_ACK,STATE_THREAD_EXIT,STATE_READ_ITERATIONS);
+					STATE_WRITE,STATE_ACK,STATE_THREAD_EXIT,STATE_READ_ITERATIONS,
+					STATE_READ_BATCH);
 
 	component single_pendulum is
 	Port ( x0, x1, u0, t  : in  STD_LOGIC_VECTOR(63 downto 0);
@@ -71,6 +72,8 @@ architecture implementation of hwt_single_pendulum_simple is
 	constant C_LOCAL_RAM_SIZE          : integer := 2 * (C_INPUT_SIZE + C_OUTPUT_SIZE);	-- double takes 8 bytes, i.e. 2 words
 	constant C_LOCAL_RAM_ADDRESS_WIDTH : integer := clog2(C_LOCAL_RAM_SIZE);
 	constant C_LOCAL_RAM_SIZE_IN_BYTES : integer := 4*C_LOCAL_RAM_SIZE;
+	-- jobs of a batch are consecutive in memory
+	constant C_JOB_SIZE_IN_BYTES       : integer := 8 * (C_INPUT_SIZE + C_OUTPUT_SIZE);
 
 	constant MBOX_RECV  : std_logic_vector(31 downto 0) := x"00000000";
 	constant MBOX_SEND  : std_logic_vector(31 downto 0) := x"00000001";
@@ -107,6 +110,7 @@ architecture implementation of hwt_single_pendulum_simple is
 	signal out_tready     : STD_LOGIC;
 
 	signal iterations     : STD_LOGIC_VECTOR(31 downto 0) := (others => '0');
+	signal batch          : STD_LOGIC_VECTOR(31 downto 0) := (others => '0');
 begin
 
 	DEBUG_DATA(5) <= '1' when state = STATE_GET_ADDR else '0';
@@ -258,6 +262,8 @@ begin
 							state <= STATE_READ;
 						elsif (addr = X"FFFFFFFD") then
 							state <= STATE_READ_ITERATIONS;
+						elsif (addr = X"FFFFFFFC") then
+							state <= STATE_READ_BATCH;
 						else
 							goto_read(0);
 						end if;
@@ -308,20 +314,32 @@ begin
 				when STATE_WRITE =>
 					if (addr = X"FFFFFFFE") then
 						-- skip writing to memory - only for performance tests!
-						state <= STATE_ACK;
+						if batch = X"00000000" then
+							state <= STATE_ACK;
+						else
+							batch <= batch - X"00000001";
+							state <= STATE_READ;
+						end if;
 					else
 						memif_write(i_ram,o_ram,i_memif,o_memif,X"00000000",addr_outputs,len,done);
 						if done then
-							if iterations = X"00000000" then
-								state <= STATE_ACK;
-							else
+							if iterations /= X"00000000" then
 								iterations <= iterations - X"00000001";
 								goto_read(0);
+							elsif batch /= X"00000000" then
+								-- continue with the next job of the batch
+								batch <= batch - X"00000001";
+								len   <= conv_std_logic_vector(8 * C_INPUT_SIZE,24);
+								addr  <= (addr(31 downto 2) & "00") + conv_std_logic_vector(C_JOB_SIZE_IN_BYTES,32);
+								state <= STATE_READ;
+							else
+								state <= STATE_ACK;
 							end if;
 						end if;
 					end if;
 				
 				-- send mbox that signals that the sorting is finished
+				-- (for a batch this is the address of its last job)
 				when STATE_ACK =>
 					osif_mbox_put(i_osif, o_osif, MBOX_SEND, addr, ignore, done);
 					if done then state <= STATE_GET_ADDR; end if;
@@ -343,6 +361,15 @@ begin
 						--           she has send a different value for iterations.
 						iterations <= iterations - X"00000001";
 					end if;
+
+				-- the next address points to batch jobs, which are calculated before
+				-- a single 'done' message is sent (like iterations, this is reset afterwards)
+				when STATE_READ_BATCH =>
+					osif_mbox_get(i_osif, o_osif, MBOX_RECV, batch, done);
+					if done then
+						state <= STATE_GET_ADDR;
+						batch <= batch - X"00000001";
+					end if;
 			
 			end case;
 		end if;
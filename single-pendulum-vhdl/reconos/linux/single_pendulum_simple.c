@@ -1,5 +1,6 @@
 #include "reconos.h"
 #include "mbox.h"
+#include "mehari_message.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,6 +25,7 @@
 #define THREAD_EXIT    ((void*)-1)
 #define WITHOUT_MEMORY ((void*)-2)
 #define SET_ITERATIONS ((uint32_t)-3)
+#define SET_BATCH      ((uint32_t)-4)
 
 // software threads
 pthread_t swt[MAX_THREADS];
@@ -38,6 +40,15 @@ struct reconos_hwt hwt[MAX_THREADS];
 struct mbox mb_start;
 struct mbox mb_stop;
 
+// the words of a pointer are sent as one message, so several threads can share the mailboxes
+struct mehari_message_channel mb_start_messages = MEHARI_MESSAGE_CHANNEL_INITIALIZER;
+struct mehari_message_channel mb_stop_messages  = MEHARI_MESSAGE_CHANNEL_INITIALIZER;
+
+static struct mehari_message_channel* message_channel(struct mbox *mb)
+{
+    return (mb == &mb_stop ? &mb_stop_messages : &mb_start_messages);
+}
+
 void print_data(real_t* data, size_t count)
 {
     size_t i;
@@ -66,28 +77,16 @@ void print_reals(real_t* data, size_t count)
 
 void mbox_put_data(struct mbox *mb, const void* p, size_t size)
 {
-    int i;
-    const uint32_t* parts = (const uint32_t*)p;
-
     assert((size%sizeof(uint32_t)) == 0);
 
-    for (i=0; i<size/sizeof(uint32_t); i++)
-    {
-        mbox_put(mb, parts[i]);
-    }
+    mehari_message_put(message_channel(mb), mb, (const uint32_t*)p, size/sizeof(uint32_t));
 }
 
 void mbox_get_data(struct mbox *mb, void* p, size_t size)
 {
-    int i;
-    uint32_t* parts = (uint32_t*)p;
-
     assert((size%sizeof(uint32_t)) == 0);
 
-    for (i=0; i<size/sizeof(uint32_t); i++)
-    {
-        parts[i] = mbox_get(mb);
-    }
+    mehari_message_get(message_channel(mb), mb, (uint32_t*)p, size/sizeof(uint32_t));
 }
 
 void mbox_put_pointer(struct mbox *mb, void* p)
@@ -109,6 +108,7 @@ void single_pendulum_simple(single_pendulum_simple_state_t* state) {
 }
 
 volatile static int iterations_in_thread = 1;
+volatile static int batch_size = 1;
 
 // sort thread shall behave the same as hw thread:
 // - get pointer to data buffer
@@ -133,9 +133,10 @@ void *software_thread(void* data)
         else
         {
             int iterations = iterations_in_thread;
-            int i;
-            for (i=0; i<iterations; ++i)
-                single_pendulum_simple( (single_pendulum_simple_state_t*) ret );
+            int i, job;
+            for (job=0; job<batch_size; ++job)
+                for (i=0; i<iterations; ++i)
+                    single_pendulum_simple( (single_pendulum_simple_state_t*) ret + job );
         }
         
         mbox_put_pointer(mb_stop, ret);
@@ -167,6 +168,7 @@ void print_help()
     "--without-memory\tThe hardware thread doesn't access the memory. It will calculate with dummy values.\n"
     "--iterations <NUM>\tDo the calculation <NUM> times (short: -n <NUM>)\n"
     "--iterations-in-thread <NUM>\tRepeat the calculation without using any synchronization (short: -m <NUM>)\n"
+    "--batch <NUM>\tPass <NUM> consecutive jobs to a thread and wait for one acknowledgement (short: -k <NUM>)\n"
     "--dont-flush\tDo not flush caches between iterations.\n");
 }
 
@@ -204,11 +206,12 @@ int main(int argc, char ** argv)
             { "dont-flush",      no_argument, &dont_flush,      1 },
             { "iterations",      required_argument, 0, 'n' },
             { "iterations-in-thread", required_argument, 0, 'm' },
+            { "batch",           required_argument, 0, 'k' },
             {0, 0, 0, 0}
         };
 
         int option_index = 0;
-        c = getopt_long (argc, argv, "n:m:h?", long_options, &option_index);
+        c = getopt_long (argc, argv, "n:m:k:h?", long_options, &option_index);
 
         if (c == -1)
             // end of options
@@ -224,6 +227,9 @@ int main(int argc, char ** argv)
         case 'm':
             iterations_in_thread = atoi(optarg);
             break;
+        case 'k':
+            batch_size = atoi(optarg);
+            break;
         case 'h':
         case '?':
             only_print_help = 1;
@@ -252,6 +258,12 @@ int main(int argc, char ** argv)
         exit(-1);
     }
 
+    if (batch_size < 1)
+    {
+        fprintf(stderr, "The batch size must be at least 1.\n");
+        exit(-1);
+    }
+
     if (without_reconos && hw_threads > 0)
     {
         fprintf(stderr, "We cannot use hardware threads without reconOS!\n");
@@ -264,12 +276,12 @@ int main(int argc, char ** argv)
         exit(-1);
     }
 
-    if (sizeof(void*) > sizeof(uint32_t) && sw_threads + hw_threads > 1)
+    if (sizeof(void*) > sizeof(uint32_t) && hw_threads > 0 && sw_threads + hw_threads > 1)
     {
-        fprintf(stderr, "mboxes work with 4-byte values, so we have some trouble passing a "
-            "pointer through them. We have to pass it in parts, but with more than one thread, "
-            "the threads might get parts from different pointers. Therefore, you cannot use "
-            "more than one thread on this platform.\n");
+        fprintf(stderr, "mboxes work with 4-byte values, so we have to pass a pointer in parts. "
+            "The software threads get all parts of a pointer as one message, but a hardware "
+            "thread might get parts from different pointers. Therefore, you cannot use "
+            "hardware threads together with other threads on this platform.\n");
         exit(-1);
     }
 
@@ -282,17 +294,31 @@ int main(int argc, char ** argv)
         }
     }
 
+    if (batch_size > 1) {
+        if (hw_threads > 0 && hw_threads + sw_threads > 1)
+        {
+            fprintf(stderr, "'--batch' can only be used with software threads "
+                "or one hardware thread.\n");
+            exit(-1);
+        }
+        if (iterations_in_thread > 1)
+        {
+            fprintf(stderr, "'--batch' cannot be used with '--iterations-in-thread'.\n");
+            exit(-1);
+        }
+    }
+
 
     running_threads = hw_threads + sw_threads;
 
-    // We calculate one step per thread.
-    simulation_steps = running_threads;
+    // We calculate one batch of steps per thread.
+    simulation_steps = running_threads * batch_size;
 
     //int gettimeofday(struct timeval *tv, struct timezone *tz);
 
     // init mailboxes
-    mbox_init(&mb_start, simulation_steps);
-    mbox_init(&mb_stop,  simulation_steps);
+    mbox_init(&mb_start, running_threads);
+    mbox_init(&mb_stop,  running_threads);
 
     // init reconos and communication resources
     if (!without_reconos)
@@ -355,14 +381,14 @@ int main(int argc, char ** argv)
 
     for (iteration=0; iteration<iterations; iteration++) {
         if (verbose_progress) {
-            printf("Putting %i blocks into job queue: ", simulation_steps);
+            printf("Putting %i batches of %i blocks into job queue: ", running_threads, batch_size);
             fflush(stdout);
         }
 
         if (!without_reconos && !dont_flush)
             reconos_cache_flush();
 
-        for (i=0; i<simulation_steps; i++)
+        for (i=0; i<running_threads; i++)
         {
             if (verbose_progress) { printf(" %i",i); fflush(stdout); }
 
@@ -372,16 +398,22 @@ int main(int argc, char ** argv)
                 mbox_put(&mb_start, iterations_in_thread);
             }
 
-            mbox_put_pointer(&mb_start, (without_memory ? WITHOUT_MEMORY : &data[i]));
+            if (batch_size > 1 && hw_threads > 0) {
+                // the hw thread calculates the next batch_size blocks
+                mbox_put(&mb_start, SET_BATCH);
+                mbox_put(&mb_start, batch_size);
+            }
+
+            mbox_put_pointer(&mb_start, (without_memory ? WITHOUT_MEMORY : &data[i * batch_size]));
         }
         if (verbose_progress) printf("\n");
 
         // Wait for results
         if (verbose_progress) {
-            printf("Waiting for %i acknowledgements: ", simulation_steps);
+            printf("Waiting for %i acknowledgements: ", running_threads);
             fflush(stdout);
         }
-        for (i=0; i<simulation_steps; i++)
+        for (i=0; i<running_threads; i++)
         {
             if (verbose_progress) { printf(" %i",i); fflush(stdout); }
             (void)mbox_get_pointer(&mb_stop);